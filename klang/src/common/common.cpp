@@ -127,4 +127,43 @@ name name::from(const std::string& str) {
     return { absolute, std::move(parts) };
 }
 
+//
+// Fast math flags
+//
+
+bool fast_math_flags::set(const std::string& flag) {
+    if (flag == "fast") {
+        *this = fast();
+    } else if (flag == "reassoc") {
+        reassoc = true;
+    } else if (flag == "contract") {
+        contract = true;
+    } else if (flag == "nnan") {
+        nnan = true;
+    } else if (flag == "ninf") {
+        ninf = true;
+    } else if (flag == "nsz") {
+        nsz = true;
+    } else if (flag == "arcp") {
+        arcp = true;
+    } else if (flag == "afn") {
+        afn = true;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::optional<fast_math_flags> fast_math_flags::parse(const std::string& flags) {
+    fast_math_flags res;
+    std::istringstream stm(flags);
+    std::string flag;
+    while (std::getline(stm, flag, ',')) {
+        if (!flag.empty() && !res.set(flag)) {
+            return std::nullopt;
+        }
+    }
+    return res;
+}
+
 } // namespace k
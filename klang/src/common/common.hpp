@@ -19,6 +19,7 @@
 #ifndef KLANG_COMMON_HPP
 #define KLANG_COMMON_HPP
 
+#include <optional>
 #include <string>
 #include <vector>
 #include <variant>
@@ -133,6 +134,54 @@ typedef std::variant<std::monostate,
         float, double,
         std::string> value_type;
 
+/**
+ * Floating point math relaxations, like "-ffast-math" and its finer-grained flags.
+ * Each flag lets the optimizer ignore a part of the IEEE-754 semantics.
+ */
+struct fast_math_flags {
+    /** Reassociate operations, needed to vectorize reductions. */
+    bool reassoc = false;
+    /** Contract operations, like a multiplication and an addition into a fused multiply-add. */
+    bool contract = false;
+    /** Assume arguments and results are not NaN. */
+    bool nnan = false;
+    /** Assume arguments and results are not infinite. */
+    bool ninf = false;
+    /** Ignore the sign of zeros. */
+    bool nsz = false;
+    /** Multiply by the reciprocal of a divisor instead of dividing. */
+    bool arcp = false;
+    /** Approximate math functions. */
+    bool afn = false;
+
+    /**
+     * All flags, like "-ffast-math".
+     */
+    static fast_math_flags fast() {
+        return {true, true, true, true, true, true, true};
+    }
+
+    bool any() const {
+        return reassoc || contract || nnan || ninf || nsz || arcp || afn;
+    }
+
+    bool all() const {
+        return reassoc && contract && nnan && ninf && nsz && arcp && afn;
+    }
+
+    /**
+     * Set a flag from its name: "fast" (all flags), "reassoc", "contract", "nnan", "ninf", "nsz", "arcp" or "afn".
+     * @return False if the name is unknown.
+     */
+    bool set(const std::string& flag);
+
+    /**
+     * Parse a comma-separated list of flag names.
+     * @return Flags, nothing if a name is unknown.
+     */
+    static std::optional<fast_math_flags> parse(const std::string& flags);
+};
+
 
 } // namespace k
 #endif //KLANG_COMMON_HPP
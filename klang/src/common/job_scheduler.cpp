@@ -0,0 +1,102 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "job_scheduler.hpp"
+
+namespace k {
+
+job_scheduler::job_scheduler(unsigned int workers) {
+    if (workers == 0) {
+        workers = default_worker_count();
+    }
+    _workers.reserve(workers);
+    for (unsigned int n = 0; n < workers; ++n) {
+        _workers.emplace_back(&job_scheduler::run, this);
+    }
+}
+
+job_scheduler::~job_scheduler() {
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _jobs_done.wait(lock, [this]{ return _pending == 0; });
+        _stopping = true;
+    }
+    _job_available.notify_all();
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+}
+
+unsigned int job_scheduler::default_worker_count() {
+    unsigned int count = std::thread::hardware_concurrency();
+    return count > 0 ? count : 1;
+}
+
+void job_scheduler::submit(job j) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _jobs.push_back(std::move(j));
+        ++_pending;
+    }
+    _job_available.notify_one();
+}
+
+void job_scheduler::wait() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _jobs_done.wait(lock, [this]{ return _pending == 0; });
+    if (_error) {
+        std::exception_ptr error = _error;
+        _error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void job_scheduler::run() {
+    while (true) {
+        job current;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _job_available.wait(lock, [this]{ return _stopping || !_jobs.empty(); });
+            if (_jobs.empty()) {
+                // Stopping and nothing left to do.
+                return;
+            }
+            current = std::move(_jobs.front());
+            _jobs.pop_front();
+        }
+
+        std::exception_ptr error;
+        try {
+            current();
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (error && !_error) {
+                _error = error;
+            }
+            if (--_pending == 0) {
+                _jobs_done.notify_all();
+            }
+        }
+    }
+}
+
+} // k
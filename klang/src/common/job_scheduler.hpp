@@ -0,0 +1,93 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef KLANG_JOB_SCHEDULER_HPP
+#define KLANG_JOB_SCHEDULER_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace k {
+
+/**
+ * Simple pool of worker threads processing submitted jobs in FIFO order.
+ * Jobs are independent: the scheduler does not provide any ordering guarantee between them.
+ * The first exception thrown by a job is kept and rethrown by wait().
+ */
+class job_scheduler {
+public:
+    typedef std::function<void()> job;
+
+    /**
+     * Create a scheduler.
+     * @param workers Number of worker threads, 0 to use the number of hardware threads.
+     */
+    explicit job_scheduler(unsigned int workers = 0);
+
+    /**
+     * Wait for all pending jobs then stop the workers.
+     */
+    ~job_scheduler();
+
+    job_scheduler(const job_scheduler&) = delete;
+    job_scheduler& operator=(const job_scheduler&) = delete;
+
+    /**
+     * Queue a job to be run by a worker thread.
+     */
+    void submit(job j);
+
+    /**
+     * Block until all submitted jobs are processed.
+     * @throw Rethrow the first exception thrown by a job, if any.
+     */
+    void wait();
+
+    unsigned int worker_count() const {
+        return _workers.size();
+    }
+
+    /**
+     * Number of workers used when none is specified: number of hardware threads, at least 1.
+     */
+    static unsigned int default_worker_count();
+
+protected:
+    std::vector<std::thread> _workers;
+    std::deque<job> _jobs;
+
+    std::mutex _mutex;
+    std::condition_variable _job_available;
+    std::condition_variable _jobs_done;
+
+    /** Number of jobs submitted but not finished yet (queued or running). */
+    size_t _pending = 0;
+    bool _stopping = false;
+    std::exception_ptr _error;
+
+    void run();
+};
+
+} // k
+
+#endif //KLANG_JOB_SCHEDULER_HPP
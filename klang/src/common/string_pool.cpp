@@ -0,0 +1,93 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "string_pool.hpp"
+
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace k {
+
+namespace {
+
+struct string_hash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view str) const {
+        return std::hash<std::string_view>{}(str);
+    }
+};
+
+struct pool {
+    std::shared_mutex mutex;
+    /** Pooled strings, by their own content: entries are removed when the last handle of their string is released. */
+    std::unordered_map<std::string_view, std::weak_ptr<const std::string>, string_hash, std::equal_to<>> strings;
+};
+
+pool& get_pool() {
+    // Never destroyed, so handles held by static objects can still be released at exit.
+    static pool* instance = new pool;
+    return *instance;
+}
+
+void release(const std::string* str) {
+    pool& strings = get_pool();
+    {
+        std::unique_lock<std::shared_mutex> lock(strings.mutex);
+        // The entry may already designate a new string equal to this one, interned while this one was released.
+        if (auto it = strings.strings.find(std::string_view(*str)); it != strings.strings.end() && it->first.data() == str->data()) {
+            strings.strings.erase(it);
+        }
+    }
+    delete str;
+}
+
+} // anonymous namespace
+
+string_pool::handle string_pool::intern(std::string_view str) {
+    pool& strings = get_pool();
+    {
+        std::shared_lock<std::shared_mutex> lock(strings.mutex);
+        if (auto it = strings.strings.find(str); it != strings.strings.end()) {
+            if (auto pooled = it->second.lock()) {
+                return pooled;
+            }
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(strings.mutex);
+    auto it = strings.strings.find(str);
+    if (it != strings.strings.end()) {
+        if (auto pooled = it->second.lock()) {
+            return pooled;
+        }
+        // Being released, replaced by a new string.
+        strings.strings.erase(it);
+    }
+    handle pooled(new std::string(str), release);
+    strings.strings.emplace(std::string_view(*pooled), pooled);
+    return pooled;
+}
+
+const std::string& string_pool::empty() {
+    static const handle empty_string = intern("");
+    return *empty_string;
+}
+
+} // k
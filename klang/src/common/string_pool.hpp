@@ -0,0 +1,52 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef KLANG_STRING_POOL_HPP
+#define KLANG_STRING_POOL_HPP
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace k {
+
+/**
+ * Process-wide pool of immutable strings, like element names.
+ * Equal strings are stored once and shared by reference counted handles: a string is removed from the pool
+ * when its last handle is released, so the pool only holds the names of live elements. Interning is thread-safe.
+ */
+class string_pool {
+public:
+    /** Shared handle of a pooled string. */
+    typedef std::shared_ptr<const std::string> handle;
+
+    /**
+     * Intern a string.
+     * @return Handle of the pooled string equal to str.
+     */
+    static handle intern(std::string_view str);
+
+    /**
+     * Pooled empty string, never released.
+     */
+    static const std::string& empty();
+};
+
+} // k
+
+#endif //KLANG_STRING_POOL_HPP
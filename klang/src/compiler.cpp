@@ -18,14 +18,36 @@
 
 #include "compiler.hpp"
 
+#include <atomic>
 #include <iostream>
+#include <optional>
 
+#include "common/job_scheduler.hpp"
+
+#include "gen/constant_folder.hpp"
+#include "gen/precompiled_module.hpp"
 #include "gen/resolvers.hpp"
+#include "gen/subscript_range_analyzer.hpp"
 #include "gen/unit_llvm_ir_gen.hpp"
 #include "parse/ast_dump.hpp"
 #include "model/model_builder.hpp"
 #include "model/model_dump.hpp"
 
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
+#include "llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/MC/TargetRegistry.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Program.h"
+#include "llvm/TargetParser/Host.h"
+#include "llvm/Transforms/Utils/ModuleUtils.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
+
 namespace k {
 
 compiler::compiler(llvm::TargetMachine* target):
@@ -35,10 +57,102 @@ compiler::compiler(llvm::TargetMachine* target):
 {
 }
 
+compiler::~compiler() = default;
+
 std::shared_ptr<compiler> compiler::create(llvm::TargetMachine* target) {
     return std::shared_ptr<compiler>{new compiler(target)};
 }
 
+llvm::CodeGenOptLevel to_codegen_opt_level(optimization_level level) {
+    switch (level) {
+        case optimization_level::O0:
+            return llvm::CodeGenOptLevel::None;
+        case optimization_level::O1:
+            return llvm::CodeGenOptLevel::Less;
+        case optimization_level::O3:
+            return llvm::CodeGenOptLevel::Aggressive;
+        default:
+            return llvm::CodeGenOptLevel::Default;
+    }
+}
+
+std::string compiler::host_cpu_name() {
+    return llvm::sys::getHostCPUName().str();
+}
+
+std::string compiler::host_cpu_features() {
+    llvm::StringMap<bool> features;
+    std::string res;
+    if (llvm::sys::getHostCPUFeatures(features)) {
+        for (const auto& feature : features) {
+            if (!res.empty()) {
+                res += ',';
+            }
+            res += (feature.second ? '+' : '-');
+            res += feature.first().str();
+        }
+    }
+    return res;
+}
+
+void compiler::set_target_cpu(const std::string& cpu, const std::string& features) {
+    _target_cpu = cpu == "native" ? "" : cpu;
+    _target_features = features == "native" ? "" : features;
+    if (_host_target) {
+        // Host target machine must be recreated with new CPU settings.
+        _target = nullptr;
+        _host_target.reset();
+    }
+}
+
+std::shared_ptr<compiler> compiler::create_sibling() const {
+    auto sibling = create(_host_target ? nullptr : _target);
+    sibling->_target_cpu = _target_cpu;
+    sibling->_target_features = _target_features;
+    sibling->_optimization_level = _optimization_level;
+    sibling->_codegen_partitions = _codegen_partitions;
+    sibling->_checked_subscripts = _checked_subscripts;
+    sibling->_reorder_struct_fields = _reorder_struct_fields;
+    sibling->_fast_math = _fast_math;
+    return sibling;
+}
+
+void compiler::set_codegen_partitions(unsigned int partitions) {
+    _codegen_partitions = partitions > 0 ? partitions : job_scheduler::default_worker_count();
+}
+
+llvm::Expected<llvm::orc::JITTargetMachineBuilder> compiler::get_jit_target_machine_builder() const {
+    auto builder = llvm::orc::JITTargetMachineBuilder::detectHost();
+    if (builder) {
+        if (!_target_cpu.empty()) {
+            builder->setCPU(_target_cpu);
+        }
+        if (!_target_features.empty()) {
+            builder->getFeatures() = llvm::SubtargetFeatures(_target_features);
+        }
+        builder->setCodeGenOptLevel(to_codegen_opt_level(_optimization_level));
+    }
+    return builder;
+}
+
+llvm::TargetMachine* compiler::get_target_machine() {
+    if (!_target) {
+        auto builder = get_jit_target_machine_builder();
+        if (!builder) {
+            llvm::errs() << "Cannot detect host target: " << llvm::toString(builder.takeError()) << "\n";
+            return nullptr;
+        }
+        auto target = builder->createTargetMachine();
+        if (!target) {
+            llvm::errs() << "Cannot create host target machine: " << llvm::toString(target.takeError()) << "\n";
+            return nullptr;
+        }
+        _host_target = std::move(*target);
+        _target = _host_target.get();
+    }
+    return _target;
+}
+
 std::vector<std::shared_ptr<model::element>> compiler::find_elements(const name& name) const {
     std::vector<std::shared_ptr<model::element>> results;
 
@@ -135,7 +249,37 @@ std::string compiler::get_element_mangled_name(const name& name) const {
     }
 }
 
+void compiler::print_struct_layouts(std::ostream& stm) const {
+    for (const auto& [name, st_type] : _context->get_struct_types()) {
+        if (!st_type->is_resolved()) {
+            continue;
+        }
+        std::vector<model::struct_type::field> fields(st_type->fields_begin(), st_type->fields_end());
+        uint64_t used = 0;
+        for (const auto& field : fields) {
+            used += field.size;
+        }
+        stm << "struct " << st_type->name() << ": size " << st_type->get_size()
+            << ", alignment " << st_type->get_alignment()
+            << ", padding " << (st_type->get_size() - used) << std::endl;
+        for (size_t n = 0; n < fields.size(); ++n) {
+            const auto& field = fields[n];
+            // Padding is counted after the field, up to the next one (or to the end of the structure).
+            uint64_t end = n + 1 < fields.size() ? fields[n + 1].offset : st_type->get_size();
+            auto type = field.field_type.lock();
+            stm << "    " << field.name << " : " << (type ? type->to_string() : "<<notype>>")
+                << ": offset " << field.offset << ", size " << field.size
+                << ", padding " << (end - field.offset - field.size) << std::endl;
+        }
+    }
+}
+
 void compiler::parse_source(const std::string_view& src, bool optimize, bool dump) {
+    parse_source(src, optimize ? _optimization_level : optimization_level::O0, dump);
+}
+
+void compiler::parse_source(const std::string_view& src, optimization_level level, bool dump) {
+    _optimization_level = level;
     // TODO : what to do if _source, _ast_unit and so on are already filled (by previous call)
     _source = src;
     try {
@@ -170,32 +314,45 @@ void compiler::parse_source(const std::string_view& src, bool optimize, bool dum
             unit_dump.dump(*_model_unit);
         }
 
+        // Structures are laid out for the target.
+        if (auto target = get_target_machine()) {
+            _context->set_data_layout(target->createDataLayout());
+        }
+        _context->set_reorder_struct_fields(_reorder_struct_fields);
         _context->resolve_types();
 
         k::model::gen::type_reference_resolver type_ref_resolver(_log, _context, *_model_unit);
         type_ref_resolver.resolve();
 
+        k::model::gen::subscript_range_analyzer range_analyzer(_context, *_model_unit);
+        range_analyzer.analyze();
+
+        k::model::gen::constant_folder folder(_context, *_model_unit);
+        folder.fold();
+
         if(dump) {
             k::model::dump::unit_dump unit_dump(std::cout);
             std::cout << "#" << std::endl << "# Type resolution" << std::endl << "#" << std::endl;
             unit_dump.dump(*_model_unit);
         }
 
-        process_gen(optimize, dump);
+        process_gen(dump);
     } catch (std::exception e) {
         std::cerr << "Exception : " << e.what() << std::endl;
     }
 }
 
-void compiler::process_gen(bool optimize, bool dump) {
+void compiler::process_gen(bool dump) {
 
-    auto gen = std::make_unique<k::model::gen::unit_llvm_ir_gen>(_log, _context, *_model_unit);
-
-    if (_target) {
-        gen->get_module().setDataLayout(_target->createDataLayout());
-        gen->get_module().setTargetTriple(_target->getTargetTriple().getTriple());
+    auto target = get_target_machine();
+    if (_host_target) {
+        _host_target->setOptLevel(to_codegen_opt_level(_optimization_level));
     }
 
+    auto gen = std::make_unique<k::model::gen::unit_llvm_ir_gen>(_log, _context, *_model_unit, target);
+    gen->set_checked_subscripts(_checked_subscripts);
+    gen->set_fast_math(_fast_math);
+
     if(dump) {
         std::cout << "#" << std::endl << "# LLVM Module" << std::endl << "#" << std::endl;
     }
@@ -206,32 +363,41 @@ void compiler::process_gen(bool optimize, bool dump) {
         gen->dump();
     }
 
-    if (optimize) {
-        if(dump) {
-            std::cout << "#" << std::endl << "# LLVM Optimize Module" << std::endl << "#" << std::endl;
-        }
-        gen->optimize_functions();
-        gen->verify();
-        if(dump) {
-            gen->dump();
-        }
+    // Optimization is postponed until the module is used: code generation optimizes it partition by partition,
+    // and the lazy JIT function by function.
+    _optimization_deferred = _optimization_level != optimization_level::O0;
+    _gen = std::move(gen);
+
+    if (dump && _codegen_partitions <= 1) {
+        std::cout << "#" << std::endl << "# LLVM Optimize Module" << std::endl << "#" << std::endl;
+        ensure_optimized();
+        _gen->verify();
+        _gen->dump();
     }
+}
 
-    _gen = std::move(gen);
+void compiler::ensure_optimized() {
+    if (_gen && _optimization_deferred) {
+        _gen->optimize(_optimization_level, get_target_machine());
+        _optimization_deferred = false;
+    }
 }
 
 std::unique_ptr<k::model::gen::unit_llvm_jit> compiler::to_jit(bool init_runtime) {
+    return to_jit(jit_options{}, init_runtime);
+}
+
+std::unique_ptr<k::model::gen::unit_llvm_jit> compiler::to_jit(const jit_options& options, bool init_runtime) {
     if (!_gen) {
         process_gen();
     }
     if (_gen) {
-        auto jit = model::gen::unit_llvm_jit::create(shared_from_this());
+        auto jit = model::gen::unit_llvm_jit::create(shared_from_this(), options);
         if (!jit) {
             std::cerr << "Error instantiating jit engine." << std::endl;
             return nullptr;
         }
-        jit->add_module(llvm::orc::ThreadSafeModule(std::move(_context->_module), _context->move_llvm_context()));
-        _gen.reset();
+        jit->add_module(take_module(!jit->optimizes_modules(jit->_main_dynlib)), jit->_main_dynlib, shared_from_this());
 
         if (init_runtime) {
             jit->initialize_runtime();
@@ -244,35 +410,387 @@ std::unique_ptr<k::model::gen::unit_llvm_jit> compiler::to_jit(bool init_runtime
     }
 }
 
+std::unique_ptr<k::model::gen::unit_llvm_jit> compiler::load_precompiled_module(const std::string& precompiled_file,
+                                                                                const jit_options& options, bool init_runtime) {
+    auto module = model::gen::precompiled_module::load(precompiled_file);
+    if (!module) {
+        return nullptr;
+    }
+    // The compiler only provides the target and settings of the JIT.
+    auto jit = model::gen::unit_llvm_jit::create(create(), options);
+    if (!jit->add_precompiled_module(module)) {
+        return nullptr;
+    }
+    if (init_runtime) {
+        jit->initialize_runtime();
+    }
+    return jit;
+}
+
+llvm::orc::ThreadSafeModule compiler::take_module(bool optimized) {
+    if (!_gen) {
+        process_gen();
+    }
+    if (!_gen) {
+        return {};
+    }
+    if (optimized) {
+        ensure_optimized();
+    }
+    _gen.reset();
+    return llvm::orc::ThreadSafeModule(std::move(_context->_module), _context->move_llvm_context());
+}
+
 bool compiler::gen_object_file(const std::string& output_file) {
     if (!_gen) {
         process_gen();
     }
-    if (_gen) {
-        std::error_code EC;
-        llvm::raw_fd_ostream dest(output_file, EC, llvm::sys::fs::OF_None);
-        if (EC) {
-            llvm::errs() << "Could not open file: " << EC.message();
+    if (_gen && _codegen_partitions > 1) {
+        bool res = emit_partitioned_object_file(_gen->get_module(), get_target_machine(), output_file,
+                                                _codegen_partitions, _optimization_deferred ? _optimization_level : optimization_level::O0);
+        // Splitting leaves the module unusable.
+        _gen.reset();
+        return res;
+    } else if (_gen) {
+        ensure_optimized();
+        return emit_object_file(_gen->get_module(), get_target_machine(), output_file);
+    } else {
+        std::cerr << "Error : Failed to generate code for object file." << std::endl;
+        return false;
+    }
+}
+
+/**
+ * Signature of a function, like "(int, double) : int", without its implicit "this" parameter.
+ */
+static std::string function_signature(const model::function& func) {
+    std::string signature = "(";
+    for (const auto& param : func.parameters()) {
+        if (signature.size() > 1) {
+            signature += ", ";
+        }
+        signature += param->get_type() ? param->get_type()->to_string() : "?";
+    }
+    auto return_type = func.get_return_type();
+    return signature + ") : " + (return_type ? return_type->to_string() : "void");
+}
+
+/**
+ * Describe exported functions, global variables and structures of namespace or structure children.
+ */
+static void collect_precompiled_elements(const std::vector<std::shared_ptr<model::element>>& children, model::gen::precompiled_module& module) {
+    using model::gen::precompiled_module;
+    for (const auto& child : children) {
+        if (auto func = std::dynamic_pointer_cast<model::function>(child)) {
+            if (func->is_exported() && !func->is_declaration_only()) {
+                module.add_symbol({precompiled_module::FUNCTION, func->get_fq_name(), func->get_mangled_name(), function_signature(*func)});
+            }
+        } else if (auto var = std::dynamic_pointer_cast<model::global_variable_definition>(child)) {
+            module.add_symbol({precompiled_module::VARIABLE, var->get_fq_name(), var->get_mangled_name(),
+                               var->get_type() ? var->get_type()->to_string() : "?"});
+        } else if (auto st = std::dynamic_pointer_cast<model::structure>(child)) {
+            precompiled_module::structure desc{st->get_fq_name()};
+            for (const auto& member : st->get_children()) {
+                if (auto field = std::dynamic_pointer_cast<model::member_variable_definition>(member)) {
+                    desc.fields.push_back({field->get_short_name(), field->get_type() ? field->get_type()->to_string() : "?"});
+                }
+            }
+            module.add_structure(std::move(desc));
+            collect_precompiled_elements(st->get_children(), module);
+        } else if (auto child_ns = std::dynamic_pointer_cast<model::ns>(child)) {
+            collect_precompiled_elements(child_ns->get_children(), module);
+        }
+    }
+}
+
+/**
+ * Remove a global constructor or destructor list from a module, and give its functions unique external names,
+ * so they can be looked up and called once the module is loaded.
+ * @return Names of the functions, by priority.
+ */
+static std::vector<std::string> export_global_structors(llvm::Module& module, llvm::StringRef list_name, llvm::StringRef prefix, llvm::StringRef module_id) {
+    std::vector<std::pair<uint64_t, llvm::Function*>> structors;
+    if (auto* list = module.getNamedGlobal(list_name)) {
+        if (auto* entries = llvm::dyn_cast<llvm::ConstantArray>(list->getInitializer())) {
+            for (const auto& entry : entries->operands()) {
+                auto* fields = llvm::cast<llvm::ConstantStruct>(entry);
+                if (auto* func = llvm::dyn_cast<llvm::Function>(fields->getOperand(1)->stripPointerCasts())) {
+                    structors.emplace_back(llvm::cast<llvm::ConstantInt>(fields->getOperand(0))->getZExtValue(), func);
+                }
+            }
+        }
+        list->eraseFromParent();
+    }
+    std::stable_sort(structors.begin(), structors.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    std::vector<std::string> names;
+    for (auto& [priority, func] : structors) {
+        func->setLinkage(llvm::GlobalValue::ExternalLinkage);
+        func->setName(prefix + module_id + "." + std::to_string(names.size()));
+        names.push_back(func->getName().str());
+    }
+    return names;
+}
+
+bool compiler::gen_precompiled_module(const std::string& output_file) {
+    if (!_gen) {
+        process_gen();
+    }
+    if (!_gen) {
+        std::cerr << "Error : Failed to generate code for precompiled module." << std::endl;
+        return false;
+    }
+
+    auto* target = get_target_machine();
+    model::gen::precompiled_module module;
+    module.set_target(target->getTargetTriple().str(), target->getTargetCPU().str(), target->getTargetFeatureString().str());
+    auto root_ns = _model_unit->get_root_namespace();
+    module.set_module_name(root_ns->get_fq_name());
+    collect_precompiled_elements(root_ns->get_children(), module);
+
+    // Structors are renamed after the module symbols, so modules loaded in the same JIT library do not collide.
+    llvm::Module& llvm_module = _gen->get_module();
+    std::string module_id = llvm::getUniqueModuleId(&llvm_module);
+    if (module_id.empty()) {
+        module_id = "." + llvm::utohexstr(llvm::MD5Hash(output_file));
+    }
+    for (const auto& name : export_global_structors(llvm_module, "llvm.global_ctors", "__K_precompiled_init", module_id)) {
+        module.add_initializer(name);
+    }
+    for (const auto& name : export_global_structors(llvm_module, "llvm.global_dtors", "__K_precompiled_fini", module_id)) {
+        module.add_finalizer(name);
+    }
+
+    if (_codegen_partitions > 1) {
+        // Partitioned objects are combined by the system linker, through a temporary file.
+        llvm::SmallString<128> object_file;
+        if (auto err = llvm::sys::fs::createTemporaryFile("klang-precompiled", "o", object_file)) {
+            std::cerr << "Error : Cannot create temporary object file: " << err.message() << std::endl;
             return false;
         }
+        bool res = emit_partitioned_object_file(llvm_module, target, object_file.str().str(),
+                                                _codegen_partitions, _optimization_deferred ? _optimization_level : optimization_level::O0);
+        // Splitting leaves the module unusable.
+        _gen.reset();
+        auto object = res ? llvm::MemoryBuffer::getFile(object_file) : std::make_error_code(std::errc::io_error);
+        llvm::sys::fs::remove(object_file);
+        if (!object) {
+            std::cerr << "Error : Cannot generate the object of precompiled module." << std::endl;
+            return false;
+        }
+        module.set_object(std::move(*object));
+    } else {
+        ensure_optimized();
+        llvm::SmallVector<char, 0> object;
+        llvm::raw_svector_ostream stream(object);
+        if (!emit_object(llvm_module, target, stream)) {
+            return false;
+        }
+        module.set_object(llvm::MemoryBuffer::getMemBufferCopy(llvm::StringRef(object.data(), object.size()), output_file));
+    }
 
-        llvm::legacy::PassManager pass;
-        auto FileType = llvm::CodeGenFileType::ObjectFile;
+    return module.save(output_file);
+}
+
+bool compiler::gen_linked_object_file(const std::vector<std::shared_ptr<compiler>>& compilers, const std::string& output_file) {
+    if (compilers.empty()) {
+        std::cerr << "Error : No module to link." << std::endl;
+        return false;
+    }
+
+    llvm::LLVMContext context;
+    std::unique_ptr<llvm::Module> linked;
 
-        if (_target->addPassesToEmitFile(pass, dest, nullptr, FileType)) {
-            llvm::errs() << "TargetMachine can't emit a file of this type";
+    for (const auto& comp : compilers) {
+        if (!comp->_gen) {
+            comp->process_gen();
+        }
+        if (!comp->_gen) {
+            std::cerr << "Error : Failed to generate code for object file." << std::endl;
             return false;
         }
+        if (compilers.front()->_codegen_partitions <= 1) {
+            comp->ensure_optimized();
+        }
 
-        pass.run(_gen->get_module());
-        dest.flush();
-        return true;
+        // Transfer the module to the linking context.
+        llvm::SmallVector<char, 0> buffer;
+        llvm::raw_svector_ostream stream(buffer);
+        llvm::WriteBitcodeToFile(comp->_gen->get_module(), stream);
 
-    } else {
-        std::cerr << "Error : Failed to generate code for object file." << std::endl;
+        auto module = llvm::parseBitcodeFile(
+                llvm::MemoryBufferRef(llvm::StringRef(buffer.data(), buffer.size()), comp->_gen->get_module().getModuleIdentifier()),
+                context);
+        if (!module) {
+            llvm::errs() << "Error : Failed to load module for linking: " << llvm::toString(module.takeError()) << "\n";
+            return false;
+        }
+
+        if (!linked) {
+            linked = std::move(*module);
+        } else if (llvm::Linker::linkModules(*linked, std::move(*module))) {
+            std::cerr << "Error : Failed to link module '" << comp->_model_unit->get_unit_name().to_string() << "'." << std::endl;
+            return false;
+        }
+    }
+
+    const auto& first = compilers.front();
+    if (first->_codegen_partitions > 1) {
+        return emit_partitioned_object_file(*linked, first->get_target_machine(), output_file,
+                                            first->_codegen_partitions, first->_optimization_level);
+    }
+    return emit_object_file(*linked, first->get_target_machine(), output_file);
+}
+
+bool compiler::emit_object_file(llvm::Module& module, llvm::TargetMachine* target, const std::string& output_file) {
+    if (!target) {
+        std::cerr << "Error : No target to generate object file." << std::endl;
         return false;
     }
+
+    std::error_code EC;
+    llvm::raw_fd_ostream dest(output_file, EC, llvm::sys::fs::OF_None);
+    if (EC) {
+        llvm::errs() << "Could not open file: " << EC.message();
+        return false;
+    }
+
+    if (!emit_object(module, target, dest)) {
+        return false;
+    }
+    dest.flush();
+    return true;
+}
+
+bool compiler::emit_object(llvm::Module& module, llvm::TargetMachine* target, llvm::raw_pwrite_stream& stream) {
+    llvm::legacy::PassManager pass;
+    auto FileType = llvm::CodeGenFileType::ObjectFile;
+
+    if (target->addPassesToEmitFile(pass, stream, nullptr, FileType)) {
+        llvm::errs() << "TargetMachine can't emit a file of this type";
+        return false;
+    }
+
+    pass.run(module);
+    return true;
 }
 
+bool compiler::emit_partitioned_object_file(llvm::Module& module, llvm::TargetMachine* target, const std::string& output_file,
+                                            unsigned int partitions, optimization_level level) {
+    if (!target) {
+        std::cerr << "Error : No target to generate object file." << std::endl;
+        return false;
+    }
+
+    // Partition objects are combined by the system linker, which only understands objects of the host.
+    // Otherwise, optimized partitions are linked back into one module, compiled at once.
+    llvm::Triple host(llvm::sys::getProcessTriple());
+    const llvm::Triple& triple = target->getTargetTriple();
+    std::optional<std::string> linker;
+    if (host.getArch() == triple.getArch() && host.getOS() == triple.getOS() && host.getObjectFormat() == triple.getObjectFormat()) {
+        if (auto program = llvm::sys::findProgramByName("ld")) {
+            linker = *program;
+        }
+    }
+
+    // Split the module and serialize each partition, as partitions are processed in their own contexts.
+    std::vector<llvm::SmallVector<char, 0>> bitcodes;
+    llvm::SplitModule(module, partitions, [&](std::unique_ptr<llvm::Module> part) {
+        llvm::raw_svector_ostream stream(bitcodes.emplace_back());
+        llvm::WriteBitcodeToFile(*part, stream);
+    }, /*PreserveLocals=*/true);
+
+    std::vector<std::string> object_files(bitcodes.size());
+    std::atomic<bool> failed = false;
+    {
+        job_scheduler scheduler(bitcodes.size());
+        for (size_t n = 0; n < bitcodes.size(); ++n) {
+            scheduler.submit([&, n]() {
+                llvm::LLVMContext context;
+                auto part = llvm::parseBitcodeFile(
+                        llvm::MemoryBufferRef(llvm::StringRef(bitcodes[n].data(), bitcodes[n].size()), module.getModuleIdentifier()),
+                        context);
+                if (!part) {
+                    llvm::errs() << "Error : Failed to load partition: " << llvm::toString(part.takeError()) << "\n";
+                    failed = true;
+                    return;
+                }
+
+                // TargetMachine instances are not shareable between threads.
+                std::unique_ptr<llvm::TargetMachine> part_target(target->getTarget().createTargetMachine(
+                        target->getTargetTriple().str(), target->getTargetCPU(), target->getTargetFeatureString(),
+                        target->Options, target->getRelocationModel(), target->getCodeModel(), target->getOptLevel()));
+
+                if (level != optimization_level::O0) {
+                    model::gen::unit_llvm_ir_gen::optimize_module(**part, level, part_target.get());
+                }
+
+                if (!linker) {
+                    // Keep the optimized partition, to be linked back.
+                    bitcodes[n].clear();
+                    llvm::raw_svector_ostream stream(bitcodes[n]);
+                    llvm::WriteBitcodeToFile(**part, stream);
+                    return;
+                }
+
+                llvm::SmallString<128> path;
+                int fd;
+                if (auto EC = llvm::sys::fs::createTemporaryFile("klang-part", "o", fd, path)) {
+                    llvm::errs() << "Error : Cannot create temporary object file: " << EC.message() << "\n";
+                    failed = true;
+                    return;
+                }
+                object_files[n] = path.str().str();
+
+                llvm::raw_fd_ostream dest(fd, /*shouldClose=*/true);
+                if (!emit_object(**part, part_target.get(), dest)) {
+                    failed = true;
+                }
+            });
+        }
+        scheduler.wait();
+    }
+
+    if (!failed && !linker) {
+        llvm::LLVMContext context;
+        std::unique_ptr<llvm::Module> linked;
+        for (const auto& bitcode : bitcodes) {
+            auto part = llvm::parseBitcodeFile(
+                    llvm::MemoryBufferRef(llvm::StringRef(bitcode.data(), bitcode.size()), module.getModuleIdentifier()),
+                    context);
+            if (!part) {
+                llvm::errs() << "Error : Failed to load partition: " << llvm::toString(part.takeError()) << "\n";
+                return false;
+            }
+            if (!linked) {
+                linked = std::move(*part);
+            } else if (llvm::Linker::linkModules(*linked, std::move(*part))) {
+                std::cerr << "Error : Failed to link partitions." << std::endl;
+                return false;
+            }
+        }
+        return emit_object_file(*linked, target, output_file);
+    }
+
+    if (!failed) {
+        // Combine partition objects into one relocatable object.
+        std::vector<llvm::StringRef> args{*linker, "-r", "-o", output_file};
+        for (const auto& object_file : object_files) {
+            args.push_back(object_file);
+        }
+        std::string error;
+        if (llvm::sys::ExecuteAndWait(*linker, args, std::nullopt, {}, 0, 0, &error) != 0) {
+            std::cerr << "Error : Failed to combine partitioned objects: " << error << std::endl;
+            failed = true;
+        }
+    }
+
+    for (const auto& object_file : object_files) {
+        if (!object_file.empty()) {
+            llvm::sys::fs::remove(object_file);
+        }
+    }
+    return !failed;
+}
 
 } // k
\ No newline at end of file
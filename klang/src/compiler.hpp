@@ -17,13 +17,24 @@
  */
 #ifndef KLANG_COMPILER_HPP
 #define KLANG_COMPILER_HPP
+#include <ostream>
 #include <string_view>
 
+#include "common/common.hpp"
 #include "common/logger.hpp"
 #include "parse/parser.hpp"
 
+#include "llvm/Support/CodeGen.h"
+
 namespace llvm {
+class Module;
 class TargetMachine;
+class raw_pwrite_stream;
+template<class T> class Expected;
+namespace orc {
+class JITTargetMachineBuilder;
+class ThreadSafeModule;
+}
 }
 
 namespace k {
@@ -39,6 +50,103 @@ class unit;
 class context;
 }
 
+/**
+ * Optimization levels, following usual -O<n> compiler flags.
+ */
+enum class optimization_level {
+    O0, ///< No optimization.
+    O1, ///< Optimize quickly without destroying debuggability.
+    O2, ///< Fast execution, without significantly increasing code size.
+    O3, ///< Fast execution, regardless of code size.
+    Os, ///< Like O2 but also reduce code size.
+    Oz  ///< Reduce code size at all cost.
+};
+
+/**
+ * Code generation optimization level corresponding to an IR optimization level.
+ */
+llvm::CodeGenOptLevel to_codegen_opt_level(optimization_level level);
+
+/**
+ * Options of the JIT engine created by compiler::to_jit().
+ */
+struct jit_options {
+    /**
+     * Compile functions lazily, on their first call, instead of compiling the whole unit when the first symbol
+     * is looked up. Each function is compiled in its own partition, called through a lazy stub.
+     * Modules are added unoptimized: each partition is optimized when compiled, at the compiler optimization level,
+     * so the startup time does not grow with the unit size.
+     */
+    bool lazy = false;
+
+    /**
+     * Record the mangled names of the functions compiled so far, in lazy mode, see
+     * unit_llvm_jit::get_compiled_functions(). Meant for tests and diagnostics.
+     */
+    bool track_compiled_functions = false;
+
+    /**
+     * Number of threads compiling modules (or functions, in lazy mode), 0 to compile on the thread looking up symbols.
+     * With compile threads, the JIT session dispatches materialization tasks to a thread pool, so independent modules
+     * and functions compile in parallel and concurrent lookups do not wait for each other's compilation.
+     */
+    unsigned int compile_threads = 0;
+
+    /**
+     * Tiered compilation: exported functions are called through indirect stubs and first run unoptimized
+     * (tier 0, whatever the compiler optimization level, for the fastest startup), with an entry counter.
+     * Functions called more than tier_up_threshold times are re-optimized at tier_up_level on a background
+     * thread, then their stubs are redirected to the optimized code. Lazy compilation is not used in this mode.
+     */
+    bool tiered = false;
+    unsigned int tier_up_threshold = 1000;
+    optimization_level tier_up_level = optimization_level::O3;
+
+    /**
+     * Call exported functions through indirect stubs, so they can be replaced while the JIT is running,
+     * see unit_llvm_jit::reload_functions(). Implied by tiered compilation. Lazy compilation is not used in this mode.
+     */
+    bool reloadable = false;
+
+    /**
+     * Directory of the persistent cache of compiled objects, empty to disable the cache.
+     * Objects are reused across processes when the module IR, the target and the optimization level match.
+     */
+    std::string cache_directory;
+
+    /**
+     * Maximum size of the object cache, in bytes, 0 for unlimited.
+     * Least recently used objects are evicted first.
+     */
+    uint64_t cache_max_size = 0;
+
+    /**
+     * Record JIT-compiled functions in the perf map of the process ("/tmp/perf-<pid>.map"), named after their
+     * demangled K names, so profilers like "perf" can symbolize the generated code.
+     */
+    bool perf_map = false;
+
+    /**
+     * Register JIT-compiled objects to debuggers through the GDB JIT interface, so GDB and LLDB can see the
+     * generated functions (backtraces, breakpoints). Objects are then linked with RuntimeDyld instead of JITLink.
+     */
+    bool debugger = false;
+
+    /**
+     * Maximum memory used by the code and data of JIT-compiled modules, in bytes, 0 for unlimited.
+     * Linking an object exceeding the limit fails, and so do lookups of its symbols. Memory of removed modules
+     * is given back. The limit is only enforced with JITLink: with RuntimeDyld, memory is only accounted.
+     */
+    uint64_t memory_limit = 0;
+
+    /**
+     * Size of the address space slabs JIT code and data are sub-allocated from, in bytes, 0 to allocate memory
+     * for each object separately. Memory of removed modules is reused by the next ones, reducing fragmentation
+     * when many modules are added and removed. JITLink only.
+     */
+    uint64_t memory_slab_size = 0;
+};
+
 class compiler : public std::enable_shared_from_this<compiler> {
 protected:
     k::log::logger _log;
@@ -50,15 +158,147 @@ protected:
     std::unique_ptr<model::gen::unit_llvm_ir_gen> _gen;
 
     llvm::TargetMachine* _target;
+    /** Host target machine, created when no target is specified. */
+    std::unique_ptr<llvm::TargetMachine> _host_target;
+
+    optimization_level _optimization_level = optimization_level::O2;
+
+    /** CPU and features of the host target machine and JIT, empty to use the host ones. */
+    std::string _target_cpu;
+    std::string _target_features;
+
+    /** Number of partitions the module is split into for parallel optimization and code generation. */
+    unsigned int _codegen_partitions = 1;
+    /** Module optimization is postponed until the module is used, see ensure_optimized(). */
+    bool _optimization_deferred = false;
+    /** Check at runtime the subscripts of sized arrays which are not proven in bounds. */
+    bool _checked_subscripts = false;
+    /** Reorder fields of structures without layout attributes to reduce padding. */
+    bool _reorder_struct_fields = false;
+    /** Floating point math relaxations of functions not specifying their own ones. */
+    fast_math_flags _fast_math;
 
-    void process_gen(bool optimize = true, bool dump = true);
+    void process_gen(bool dump = true);
+
+    /**
+     * Run the postponed module optimization, if not done yet.
+     * Partitioned code generation optimizes partitions instead, and the lazy JIT the compiled functions.
+     */
+    void ensure_optimized();
 
     compiler(llvm::TargetMachine* target = nullptr);
 
 public:
+    ~compiler();
 
     static std::shared_ptr<compiler> create(llvm::TargetMachine* target = nullptr);
 
+    /**
+     * Target machine used to optimize and generate code.
+     * If no target machine was given at creation, a target machine for the host is created.
+     * @return Target machine, null if the host target cannot be detected.
+     */
+    llvm::TargetMachine* get_target_machine();
+
+    /**
+     * Builder of host target machines, for JIT and host code generation.
+     * Uses the host CPU and features unless others are specified with set_target_cpu().
+     */
+    llvm::Expected<llvm::orc::JITTargetMachineBuilder> get_jit_target_machine_builder() const;
+
+    /**
+     * Create a new compiler with the same target and code generation settings (target machine, CPU, features,
+     * optimization level, code generation partitions, subscript checks and structure field reordering),
+     * to compile another source the same way.
+     */
+    std::shared_ptr<compiler> create_sibling() const;
+
+    /**
+     * Set the CPU and features used when generating code for the host (JIT or when no target machine was given).
+     * Generated functions are tagged with "target-cpu" and "target-features" attributes accordingly.
+     * @param cpu CPU name, "native" or empty for the host CPU.
+     * @param features Feature string (like "+avx2,-avx512f"), "native" or empty for the host CPU features.
+     */
+    void set_target_cpu(const std::string& cpu, const std::string& features = "");
+
+    /**
+     * Name of the host CPU, as detected by LLVM.
+     */
+    static std::string host_cpu_name();
+
+    /**
+     * Features of the host CPU, as a feature string usable for target machine creation.
+     */
+    static std::string host_cpu_features();
+
+    optimization_level get_optimization_level() const {
+        return _optimization_level;
+    }
+
+    void set_optimization_level(optimization_level level) {
+        _optimization_level = level;
+    }
+
+    unsigned int get_codegen_partitions() const {
+        return _codegen_partitions;
+    }
+
+    /**
+     * Set the number of partitions the module is split into when generating object files.
+     * With more than one partition, the module optimization is postponed: partitions are optimized and
+     * compiled in parallel, each in its own LLVM context, then combined into a single relocatable object.
+     * Must be called before parsing the source.
+     * @param partitions Number of partitions, 0 for the number of hardware threads, 1 to disable partitioning.
+     */
+    void set_codegen_partitions(unsigned int partitions);
+
+    bool get_checked_subscripts() const {
+        return _checked_subscripts;
+    }
+
+    /**
+     * Check at runtime that subscripts of sized arrays are in bounds, and trap if not.
+     * Subscripts proven in bounds at compile time, like counted loop indices, are not checked.
+     * Must be called before parsing the source.
+     */
+    void set_checked_subscripts(bool checked) {
+        _checked_subscripts = checked;
+    }
+
+    bool get_reorder_struct_fields() const {
+        return _reorder_struct_fields;
+    }
+
+    /**
+     * Reorder the fields of structures by decreasing alignment, to reduce padding.
+     * Structures with layout attributes ("packed", "align" or "no_reorder") keep their declaration order:
+     * structures shared with other languages must use one of them.
+     * Must be called before parsing the source.
+     */
+    void set_reorder_struct_fields(bool reorder) {
+        _reorder_struct_fields = reorder;
+    }
+
+    const fast_math_flags& get_fast_math() const {
+        return _fast_math;
+    }
+
+    /**
+     * Relax floating point math, like "-ffast-math" for all flags: reductions can then be vectorized
+     * and multiplications and additions contracted into fused multiply-adds.
+     * Functions with "[[fast_math]]" or "[[strict_math]]" attributes keep their own flags.
+     * Must be called before parsing the source.
+     */
+    void set_fast_math(const fast_math_flags& flags) {
+        _fast_math = flags;
+    }
+
+    /**
+     * Print the layout of the structures of the unit: size, alignment, then offset, size and padding of each field.
+     * Must be called after parsing the source.
+     */
+    void print_struct_layouts(std::ostream& stm) const;
+
     std::shared_ptr<model::unit> get_unit() {
         return _model_unit;
     }
@@ -93,13 +333,92 @@ public:
     }
 
 
+    /**
+     * Parse and generate code for a source.
+     * @param src Source to compile
+     * @param optimize Optimize with the compiler optimization level if true, do not optimize (O0) otherwise.
+     * @param dump Dump intermediate representations to standard output.
+     */
     void parse_source(const std::string_view& src, bool optimize = true, bool dump = false);
 
+    /**
+     * Parse and generate code for a source at the given optimization level.
+     * The level becomes the compiler optimization level, also used for JIT and object code generation.
+     */
+    void parse_source(const std::string_view& src, optimization_level level, bool dump = false);
+
     std::unique_ptr<k::model::gen::unit_llvm_jit> to_jit(bool init_runtime = true);
 
+    /**
+     * Create a JIT engine and transfer the generated module into it.
+     * @param options JIT engine options.
+     * @param init_runtime Run the module initializers (global constructors).
+     */
+    std::unique_ptr<k::model::gen::unit_llvm_jit> to_jit(const jit_options& options, bool init_runtime = true);
+
+    /**
+     * Create a JIT instance running a precompiled module, without any source to compile.
+     * The JIT targets the host, the module must be compiled for the host architecture and system.
+     * @param precompiled_file Path of the precompiled module, see gen_precompiled_module().
+     * @param options JIT options.
+     * @param init_runtime Run module initializers.
+     * @return The JIT instance, null if the precompiled module cannot be loaded.
+     */
+    static std::unique_ptr<k::model::gen::unit_llvm_jit> load_precompiled_module(const std::string& precompiled_file,
+                                                                                const jit_options& options = {}, bool init_runtime = true);
+
+    /**
+     * Take the generated module, with its LLVM context, away from the compiler. Code is generated if not done yet.
+     * @param optimized Optimize the module at the compiler optimization level, if not done yet. Otherwise,
+     * the module may be left unoptimized for its user to optimize it (like the lazy JIT, function by function).
+     * @return Generated module, an empty module if code generation failed.
+     */
+    llvm::orc::ThreadSafeModule take_module(bool optimized = true);
+
     bool gen_object_file(const std::string& output_file);
 
+    /**
+     * Generate a precompiled K module: the object file of the unit, bundled with its exported symbols
+     * (K and mangled names, types) and structures, loadable by a JIT without parsing nor generating code again,
+     * see unit_llvm_jit::add_precompiled_module().
+     * Global initializers are exported and run by the JIT instead of being registered as object constructors,
+     * so the generated module must not be used for other outputs afterwards.
+     * @param output_file Path of the precompiled module file to produce.
+     * @return True if the precompiled module is successfully generated.
+     */
+    bool gen_precompiled_module(const std::string& output_file);
+
+    /**
+     * Link the modules generated by several compilers into a single module and emit it as one object file.
+     * Each compiler owns its own LLVM context, so modules are transferred through bitcode before being linked.
+     * The target and the code generation partitions of the first compiler are used to emit the object file.
+     * @param compilers Compilers whose source is already parsed.
+     * @param output_file Path of the object file to produce.
+     * @return True if the object file is successfully generated.
+     */
+    static bool gen_linked_object_file(const std::vector<std::shared_ptr<compiler>>& compilers, const std::string& output_file);
+
 protected:
+    static bool emit_object_file(llvm::Module& module, llvm::TargetMachine* target, const std::string& output_file);
+    static bool emit_object(llvm::Module& module, llvm::TargetMachine* target, llvm::raw_pwrite_stream& stream);
+
+    /**
+     * Split a module into partitions, optimize and compile them in parallel and combine the resulting objects
+     * into one relocatable object file.
+     * Each partition is transferred through bitcode to its own LLVM context and compiled with its own clone of
+     * the target machine. Local symbols are kept in the partition of their users, so they stay local.
+     * Objects are combined by the system linker ("ld"), only used when the target matches the host. Otherwise
+     * (cross compilation, no linker), partitions are only optimized in parallel, then linked back and compiled at once.
+     * @param module Module to compile, it is left unusable (split) after the call.
+     * @param target Target machine to clone for each partition.
+     * @param output_file Path of the object file to produce.
+     * @param partitions Number of partitions.
+     * @param level Optimization level to apply on each partition, O0 for none.
+     * @return True if the object file is successfully generated.
+     */
+    static bool emit_partitioned_object_file(llvm::Module& module, llvm::TargetMachine* target, const std::string& output_file,
+                                             unsigned int partitions, optimization_level level);
+
     void find_elements_from(const name& name, const std::shared_ptr<model::element>& element, std::vector<std::shared_ptr<model::element>>& res) const;
 };
 
@@ -0,0 +1,335 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "constant_evaluator.hpp"
+
+#include <llvm/Analysis/ConstantFolding.h>
+#include <llvm/IR/InstrTypes.h>
+#include <llvm/IR/Instruction.h>
+
+namespace k::model::gen {
+
+llvm::Constant* constant_evaluator::evaluate(const std::shared_ptr<expression>& expr) {
+    if (!expr || !expr->get_type() || !type::is_resolved(expr->get_type())) {
+        return nullptr;
+    }
+
+    _value = nullptr;
+    expr->accept(*this);
+    llvm::Constant* value = _value;
+    _value = nullptr;
+
+    // Undefined and poison values come from undefined behaviors, they are not constants.
+    if (!value || llvm::isa<llvm::UndefValue>(value)) {
+        return nullptr;
+    }
+    // Evaluated value must have the type of the expression.
+    if (value->getType() != _context->get_llvm_type(get_value_type(*expr))) {
+        return nullptr;
+    }
+    return value;
+}
+
+std::shared_ptr<type> constant_evaluator::get_value_type(expression& expr) {
+    auto type = expr.get_type();
+    if (type::is_reference(type)) {
+        return type->get_subtype();
+    }
+    return type;
+}
+
+llvm::Constant* constant_evaluator::evaluate_global_variable(const std::shared_ptr<global_variable_definition>& var) {
+    auto type = var->get_type();
+    if (!type::is_resolved(type) || !(type::is_primitive(type) || type::is_vector(type))) {
+        return nullptr;
+    }
+
+    auto init_expr = var->get_init_expr();
+    if (!init_expr) {
+        // Not explicitly initialized, zero-filled.
+        return type->generate_default_value_initializer();
+    }
+
+    if (_evaluating.count(var.get()) > 0) {
+        // Cyclic initialization
+        return nullptr;
+    }
+    _evaluating.insert(var.get());
+    auto value = evaluate(init_expr);
+    _evaluating.erase(var.get());
+
+    if (value && value->getType() != _context->get_llvm_type(type)) {
+        // Initialization expression is not (yet) adapted to the variable type.
+        return nullptr;
+    }
+    return value;
+}
+
+void constant_evaluator::visit_value_expression(value_expression& expr) {
+    _value = nullptr;
+    if (expr.is_literal()) {
+        _value = _context->get_llvm_constant_from_literal(expr.any_literal());
+    } else {
+        _value = _context->get_llvm_constant_from_value(expr.get_value(), expr.get_type());
+    }
+}
+
+void constant_evaluator::visit_symbol_expression(symbol_expression& expr) {
+    _value = nullptr;
+    if (!_global_reads) {
+        return;
+    }
+    if (auto var = std::dynamic_pointer_cast<global_variable_definition>(expr.get_variable_def())) {
+        _value = evaluate_global_variable(var);
+    }
+}
+
+void constant_evaluator::visit_load_value_expression(load_value_expression& expr) {
+    _value = evaluate(expr.sub_expr());
+}
+
+//
+// Casts
+//
+
+void constant_evaluator::visit_cast_expression(cast_expression& expr) {
+    auto source_type = get_value_type(*expr.sub_expr());
+    auto target_type = expr.get_cast_type();
+
+    _value = nullptr;
+    auto value = evaluate(expr.sub_expr());
+    if (!value || !type::is_resolved(target_type)) {
+        return;
+    }
+
+    if (auto vec_type = std::dynamic_pointer_cast<vector_type>(target_type)) {
+        // Broadcast a scalar (already of the lane type) to all the lanes.
+        if (source_type == target_type) {
+            _value = value;
+        } else if (!type::is_vector(source_type)) {
+            _value = llvm::ConstantVector::getSplat(llvm::ElementCount::getFixed(vec_type->get_size()), value);
+        }
+        return;
+    }
+
+    auto src = std::dynamic_pointer_cast<primitive_type>(source_type);
+    auto tgt = std::dynamic_pointer_cast<primitive_type>(target_type);
+    if (src && tgt) {
+        _value = fold_cast(value, src, tgt);
+    }
+}
+
+llvm::Constant* constant_evaluator::fold_cast(llvm::Constant* value, const std::shared_ptr<primitive_type>& src, const std::shared_ptr<primitive_type>& tgt) {
+    llvm::Type* tgt_type = _context->get_llvm_type(tgt);
+    if (value->getType() == tgt_type && src->is_float() == tgt->is_float()) {
+        return value;
+    }
+
+    if (src->is_boolean()) {
+        if (tgt->is_integer()) {
+            return llvm::ConstantFoldCastOperand(tgt->is_unsigned() ? llvm::Instruction::ZExt : llvm::Instruction::SExt, value, tgt_type, _data_layout);
+        } else if (tgt->is_float()) {
+            return llvm::ConstantFP::get(tgt_type, value->isOneValue() ? 1.0 : 0.0);
+        }
+    } else if (src->is_integer()) {
+        if (tgt->is_boolean()) {
+            return llvm::ConstantFoldCompareInstOperands(llvm::CmpInst::ICMP_NE, value, llvm::Constant::getNullValue(value->getType()), _data_layout);
+        } else if (tgt->is_integer()) {
+            unsigned src_size = value->getType()->getIntegerBitWidth();
+            unsigned tgt_size = tgt_type->getIntegerBitWidth();
+            unsigned op = src_size > tgt_size ? llvm::Instruction::Trunc
+                        : tgt->is_signed() ? llvm::Instruction::SExt : llvm::Instruction::ZExt;
+            return llvm::ConstantFoldCastOperand(op, value, tgt_type, _data_layout);
+        } else if (tgt->is_float()) {
+            return llvm::ConstantFoldCastOperand(src->is_unsigned() ? llvm::Instruction::UIToFP : llvm::Instruction::SIToFP, value, tgt_type, _data_layout);
+        }
+    } else if (src->is_float()) {
+        if (tgt->is_boolean()) {
+            return llvm::ConstantFoldCompareInstOperands(llvm::CmpInst::FCMP_UNE, value, llvm::Constant::getNullValue(value->getType()), _data_layout);
+        } else if (tgt->is_integer()) {
+            return llvm::ConstantFoldCastOperand(tgt->is_unsigned() ? llvm::Instruction::FPToUI : llvm::Instruction::FPToSI, value, tgt_type, _data_layout);
+        } else if (tgt->is_float()) {
+            unsigned op = src->type_size() < tgt->type_size() ? llvm::Instruction::FPExt : llvm::Instruction::FPTrunc;
+            return llvm::ConstantFoldCastOperand(op, value, tgt_type, _data_layout);
+        }
+    }
+    return nullptr;
+}
+
+//
+// Binary expressions
+//
+
+void constant_evaluator::fold_binary(binary_expression& expr, unsigned signed_op, unsigned unsigned_op, unsigned float_op) {
+    _value = nullptr;
+    auto prim = std::dynamic_pointer_cast<primitive_type>(type::get_lane_type(get_value_type(*expr.left())));
+    if (!prim) {
+        return;
+    }
+    auto left = evaluate(expr.left());
+    if (!left) {
+        return;
+    }
+    auto right = evaluate(expr.right());
+    if (!right || left->getType() != right->getType()) {
+        return;
+    }
+
+    unsigned op = prim->is_float() ? float_op : prim->is_unsigned() ? unsigned_op : signed_op;
+    if (op == 0) {
+        // Operation not supported for this type
+        return;
+    }
+    _value = llvm::ConstantFoldBinaryOpOperands(op, left, right, _data_layout);
+}
+
+void constant_evaluator::visit_addition_expression(addition_expression& expr) {
+    fold_binary(expr, llvm::Instruction::Add, llvm::Instruction::Add, llvm::Instruction::FAdd);
+}
+
+void constant_evaluator::visit_substraction_expression(substraction_expression& expr) {
+    fold_binary(expr, llvm::Instruction::Sub, llvm::Instruction::Sub, llvm::Instruction::FSub);
+}
+
+void constant_evaluator::visit_multiplication_expression(multiplication_expression& expr) {
+    fold_binary(expr, llvm::Instruction::Mul, llvm::Instruction::Mul, llvm::Instruction::FMul);
+}
+
+void constant_evaluator::visit_division_expression(division_expression& expr) {
+    fold_binary(expr, llvm::Instruction::SDiv, llvm::Instruction::UDiv, llvm::Instruction::FDiv);
+}
+
+void constant_evaluator::visit_modulo_expression(modulo_expression& expr) {
+    fold_binary(expr, llvm::Instruction::SRem, llvm::Instruction::URem, llvm::Instruction::FRem);
+}
+
+void constant_evaluator::visit_bitwise_and_expression(bitwise_and_expression& expr) {
+    fold_binary(expr, llvm::Instruction::And, llvm::Instruction::And, 0);
+}
+
+void constant_evaluator::visit_bitwise_or_expression(bitwise_or_expression& expr) {
+    fold_binary(expr, llvm::Instruction::Or, llvm::Instruction::Or, 0);
+}
+
+void constant_evaluator::visit_bitwise_xor_expression(bitwise_xor_expression& expr) {
+    fold_binary(expr, llvm::Instruction::Xor, llvm::Instruction::Xor, 0);
+}
+
+void constant_evaluator::visit_left_shift_expression(left_shift_expression& expr) {
+    fold_binary(expr, llvm::Instruction::Shl, llvm::Instruction::Shl, 0);
+}
+
+void constant_evaluator::visit_right_shift_expression(right_shift_expression& expr) {
+    fold_binary(expr, llvm::Instruction::AShr, llvm::Instruction::LShr, 0);
+}
+
+void constant_evaluator::visit_logical_and_expression(logical_and_expression& expr) {
+    fold_binary(expr, llvm::Instruction::And, llvm::Instruction::And, 0);
+}
+
+void constant_evaluator::visit_logical_or_expression(logical_or_expression& expr) {
+    fold_binary(expr, llvm::Instruction::Or, llvm::Instruction::Or, 0);
+}
+
+//
+// Unary expressions
+//
+
+void constant_evaluator::visit_unary_plus_expression(unary_plus_expression& expr) {
+    _value = evaluate(expr.sub_expr());
+}
+
+void constant_evaluator::visit_unary_minus_expression(unary_minus_expression& expr) {
+    _value = nullptr;
+    auto prim = std::dynamic_pointer_cast<primitive_type>(type::get_lane_type(get_value_type(*expr.sub_expr())));
+    auto value = evaluate(expr.sub_expr());
+    if (!prim || !value) {
+        return;
+    }
+    if (prim->is_float()) {
+        _value = llvm::ConstantFoldUnaryOpOperand(llvm::Instruction::FNeg, value, _data_layout);
+    } else {
+        _value = llvm::ConstantFoldBinaryOpOperands(llvm::Instruction::Sub, llvm::Constant::getNullValue(value->getType()), value, _data_layout);
+    }
+}
+
+void constant_evaluator::visit_bitwise_not_expression(bitwise_not_expression& expr) {
+    _value = nullptr;
+    auto prim = std::dynamic_pointer_cast<primitive_type>(type::get_lane_type(get_value_type(*expr.sub_expr())));
+    auto value = evaluate(expr.sub_expr());
+    if (prim && !prim->is_float() && value) {
+        _value = llvm::ConstantFoldBinaryOpOperands(llvm::Instruction::Xor, value, llvm::Constant::getAllOnesValue(value->getType()), _data_layout);
+    }
+}
+
+void constant_evaluator::visit_logical_not_expression(logical_not_expression& expr) {
+    _value = nullptr;
+    auto value = evaluate(expr.sub_expr());
+    if (value && value->getType()->isIntegerTy(1)) {
+        _value = llvm::ConstantFoldBinaryOpOperands(llvm::Instruction::Xor, value, llvm::ConstantInt::getTrue(value->getType()), _data_layout);
+    }
+}
+
+//
+// Comparisons
+//
+
+void constant_evaluator::fold_comparison(binary_expression& expr, unsigned signed_pred, unsigned unsigned_pred, unsigned float_pred) {
+    _value = nullptr;
+    auto prim = std::dynamic_pointer_cast<primitive_type>(get_value_type(*expr.left()));
+    if (!prim) {
+        return;
+    }
+    auto left = evaluate(expr.left());
+    if (!left) {
+        return;
+    }
+    auto right = evaluate(expr.right());
+    if (!right || left->getType() != right->getType()) {
+        return;
+    }
+
+    unsigned pred = prim->is_float() ? float_pred : prim->is_unsigned() ? unsigned_pred : signed_pred;
+    _value = llvm::ConstantFoldCompareInstOperands(pred, left, right, _data_layout);
+}
+
+void constant_evaluator::visit_equal_expression(equal_expression& expr) {
+    fold_comparison(expr, llvm::CmpInst::ICMP_EQ, llvm::CmpInst::ICMP_EQ, llvm::CmpInst::FCMP_OEQ);
+}
+
+void constant_evaluator::visit_different_expression(different_expression& expr) {
+    fold_comparison(expr, llvm::CmpInst::ICMP_NE, llvm::CmpInst::ICMP_NE, llvm::CmpInst::FCMP_ONE);
+}
+
+void constant_evaluator::visit_lesser_expression(lesser_expression& expr) {
+    fold_comparison(expr, llvm::CmpInst::ICMP_SLT, llvm::CmpInst::ICMP_ULT, llvm::CmpInst::FCMP_OLT);
+}
+
+void constant_evaluator::visit_greater_expression(greater_expression& expr) {
+    fold_comparison(expr, llvm::CmpInst::ICMP_SGT, llvm::CmpInst::ICMP_UGT, llvm::CmpInst::FCMP_OGT);
+}
+
+void constant_evaluator::visit_lesser_equal_expression(lesser_equal_expression& expr) {
+    fold_comparison(expr, llvm::CmpInst::ICMP_SLE, llvm::CmpInst::ICMP_ULE, llvm::CmpInst::FCMP_OLE);
+}
+
+void constant_evaluator::visit_greater_equal_expression(greater_equal_expression& expr) {
+    fold_comparison(expr, llvm::CmpInst::ICMP_SGE, llvm::CmpInst::ICMP_UGE, llvm::CmpInst::FCMP_OGE);
+}
+
+} // k::model::gen
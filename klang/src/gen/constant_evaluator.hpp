@@ -0,0 +1,140 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef KLANG_CONSTANT_EVALUATOR_HPP
+#define KLANG_CONSTANT_EVALUATOR_HPP
+
+#include "../model/model.hpp"
+#include "../model/model_visitor.hpp"
+
+#include "../model/context.hpp"
+
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DataLayout.h>
+
+#include <set>
+
+namespace k::model::gen {
+
+/**
+ * Constant expression evaluator
+ * This helper class evaluates, at compile time, expressions made only of constants.
+ * It supports literals and values, casts between primitive types (and scalar to vector broadcasts), arithmetic,
+ * bitwise, logical and comparison operators and reads of global variables initialized by constant expressions.
+ * A global variable read by a constant expression is evaluated as its initial value: constant initializations
+ * are done at load time, before any dynamic initialization. So global variable reads must be disabled
+ * when evaluating expressions of function bodies, where globals may have been modified.
+ * Evaluated values follow the code generation semantic: an expression with undefined behavior
+ * (division by zero, out of range float to integer conversion...) is not considered as constant.
+ * It must be run after type resolution, as evaluation relies on expression types.
+ */
+class constant_evaluator : public default_model_visitor {
+protected:
+
+    std::shared_ptr<context> _context;
+
+    /** Data layout used for folding, scalar folding does not depend on the target. */
+    llvm::DataLayout _data_layout{""};
+
+    /** Value of the last evaluated expression, null if not constant. */
+    llvm::Constant* _value = nullptr;
+
+    /** Evaluate reads of constant-initialized global variables as their initial values. */
+    bool _global_reads;
+
+    /** Global variables whose initialization is being evaluated, to detect cycles. */
+    std::set<const variable_definition*> _evaluating;
+
+public:
+
+    explicit constant_evaluator(std::shared_ptr<context> context, bool global_reads = true) :
+    _context(context),
+    _global_reads(global_reads) {
+    }
+
+    /**
+     * Evaluate an expression at compile time.
+     * @param expr Expression to evaluate, must be type-resolved.
+     * @return Constant value of the expression, null if it is not a constant expression.
+     */
+    llvm::Constant* evaluate(const std::shared_ptr<expression>& expr);
+
+    /**
+     * Evaluate the initial value of a global variable.
+     * Variables without a constant initial value are initialized at runtime, by the unit global constructor.
+     * @return Initial value, null if the variable is not initialized by a constant expression.
+     */
+    llvm::Constant* evaluate_global_variable(const std::shared_ptr<global_variable_definition>& var);
+
+protected:
+
+    /**
+     * Type of the value held by an expression: its type, or the referenced type for references.
+     */
+    static std::shared_ptr<type> get_value_type(expression& expr);
+
+    /**
+     * Fold a binary expression, choosing the instruction from the type of its left operand.
+     */
+    void fold_binary(binary_expression& expr, unsigned signed_op, unsigned unsigned_op, unsigned float_op);
+
+    /**
+     * Fold a comparison expression, choosing the predicate from the type of its left operand.
+     */
+    void fold_comparison(binary_expression& expr, unsigned signed_pred, unsigned unsigned_pred, unsigned float_pred);
+
+    /**
+     * Fold the cast of a constant from a primitive type to another, with code generation semantic.
+     */
+    llvm::Constant* fold_cast(llvm::Constant* value, const std::shared_ptr<primitive_type>& src, const std::shared_ptr<primitive_type>& tgt);
+
+    void visit_value_expression(value_expression&) override;
+    void visit_symbol_expression(symbol_expression&) override;
+    void visit_cast_expression(cast_expression&) override;
+    void visit_load_value_expression(load_value_expression&) override;
+
+    void visit_addition_expression(addition_expression&) override;
+    void visit_substraction_expression(substraction_expression&) override;
+    void visit_multiplication_expression(multiplication_expression&) override;
+    void visit_division_expression(division_expression&) override;
+    void visit_modulo_expression(modulo_expression&) override;
+    void visit_bitwise_and_expression(bitwise_and_expression&) override;
+    void visit_bitwise_or_expression(bitwise_or_expression&) override;
+    void visit_bitwise_xor_expression(bitwise_xor_expression&) override;
+    void visit_left_shift_expression(left_shift_expression&) override;
+    void visit_right_shift_expression(right_shift_expression&) override;
+
+    void visit_unary_plus_expression(unary_plus_expression&) override;
+    void visit_unary_minus_expression(unary_minus_expression&) override;
+    void visit_bitwise_not_expression(bitwise_not_expression&) override;
+
+    void visit_logical_and_expression(logical_and_expression&) override;
+    void visit_logical_or_expression(logical_or_expression&) override;
+    void visit_logical_not_expression(logical_not_expression&) override;
+
+    void visit_equal_expression(equal_expression&) override;
+    void visit_different_expression(different_expression&) override;
+    void visit_lesser_expression(lesser_expression&) override;
+    void visit_greater_expression(greater_expression&) override;
+    void visit_lesser_equal_expression(lesser_equal_expression&) override;
+    void visit_greater_equal_expression(greater_equal_expression&) override;
+};
+
+} // k::model::gen
+
+#endif //KLANG_CONSTANT_EVALUATOR_HPP
@@ -0,0 +1,491 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "constant_folder.hpp"
+
+#include "../model/expressions.hpp"
+#include "../model/statements.hpp"
+
+namespace k::model::gen {
+
+void constant_folder::fold()
+{
+    visit_unit(_unit);
+}
+
+std::shared_ptr<expression> constant_folder::fold(const std::shared_ptr<expression>& expr) {
+    if (!expr) {
+        return expr;
+    }
+    _replacement = nullptr;
+    expr->accept(*this);
+    auto res = _replacement ? _replacement : expr;
+    _replacement = nullptr;
+    return res;
+}
+
+std::shared_ptr<statement> constant_folder::fold_statement(const std::shared_ptr<statement>& stmt) {
+    _stmt_replaced = false;
+    stmt->accept(*this);
+    if (!_stmt_replaced) {
+        return stmt;
+    }
+    _stmt_replaced = false;
+    return std::move(_stmt_replacement);
+}
+
+std::shared_ptr<statement> constant_folder::fold_nested_statement(const std::shared_ptr<statement>& stmt) {
+    auto res = fold_statement(stmt);
+    if (!res) {
+        // Removed statement, replace it by an empty block.
+        res = std::make_shared<block>(stmt->get_parent_stmt());
+    }
+    return res;
+}
+
+std::optional<k::value_type> constant_folder::to_value(llvm::Constant* constant, const primitive_type& prim) {
+    if (auto fp = llvm::dyn_cast<llvm::ConstantFP>(constant)) {
+        if (prim.get_type() == primitive_type::FLOAT) {
+            return fp->getValueAPF().convertToFloat();
+        } else if (prim.get_type() == primitive_type::DOUBLE) {
+            return fp->getValueAPF().convertToDouble();
+        }
+        return {};
+    }
+
+    auto integer = llvm::dyn_cast<llvm::ConstantInt>(constant);
+    if (!integer) {
+        return {};
+    }
+    const llvm::APInt& val = integer->getValue();
+    if (prim.is_unsigned() ? val.getActiveBits() > 64 : val.getSignificantBits() > 64) {
+        // Values are limited to 64 bits
+        return {};
+    }
+    switch (prim.get_type()) {
+        case primitive_type::BOOL:
+            return integer->isOne();
+        case primitive_type::CHAR:
+            return (char) val.getSExtValue();
+        case primitive_type::BYTE:
+            return (unsigned char) val.getZExtValue();
+        case primitive_type::SHORT:
+            return (short) val.getSExtValue();
+        case primitive_type::UNSIGNED_SHORT:
+            return (unsigned short) val.getZExtValue();
+        case primitive_type::INT:
+            return (int) val.getSExtValue();
+        case primitive_type::UNSIGNED_INT:
+            return (unsigned int) val.getZExtValue();
+        case primitive_type::LONG:
+            return (long) val.getSExtValue();
+        case primitive_type::UNSIGNED_LONG:
+            return (unsigned long) val.getZExtValue();
+        case primitive_type::LONG_LONG:
+            return (long long) val.getSExtValue();
+        case primitive_type::UNSIGNED_LONG_LONG:
+            return (unsigned long long) val.getZExtValue();
+        default:
+            return {};
+    }
+}
+
+llvm::Constant* constant_folder::get_constant(const std::shared_ptr<expression>& expr) {
+    if (!std::dynamic_pointer_cast<value_expression>(expr)) {
+        return nullptr;
+    }
+    return _evaluator.evaluate(expr);
+}
+
+bool constant_folder::is_constant(const std::shared_ptr<expression>& expr, int64_t number) {
+    auto constant = get_constant(expr);
+    if (auto integer = llvm::dyn_cast_or_null<llvm::ConstantInt>(constant)) {
+        return integer->getValue() == llvm::APInt(integer->getBitWidth(), number, true);
+    }
+    if (auto fp = llvm::dyn_cast_or_null<llvm::ConstantFP>(constant)) {
+        return fp->isExactlyValue((double) number);
+    }
+    return false;
+}
+
+bool constant_folder::fold_value(expression& expr) {
+    auto prim = std::dynamic_pointer_cast<primitive_type>(expr.get_type());
+    if (!prim) {
+        return false;
+    }
+    auto constant = _evaluator.evaluate(expr.shared_as<expression>());
+    if (!constant) {
+        return false;
+    }
+    auto value = to_value(constant, *prim);
+    if (!value) {
+        return false;
+    }
+    auto value_expr = value_expression::from_value(*value);
+    value_expr->set_type(prim);
+    _replacement = value_expr;
+    return true;
+}
+
+void constant_folder::replace_by_operand(expression& expr, const std::shared_ptr<expression>& operand) {
+    auto type = operand->get_type();
+    if (type::is_reference(type) && type->get_subtype() == expr.get_type()) {
+        auto load = load_value_expression::make_shared(operand);
+        load->set_type(expr.get_type());
+        _replacement = load;
+    } else if (type && type == expr.get_type()) {
+        _replacement = operand;
+    }
+}
+
+bool constant_folder::fold_binary(binary_expression& expr) {
+    if (auto left = fold(expr.left()); left != expr.left()) {
+        expr.assign_left(left);
+    }
+    if (auto right = fold(expr.right()); right != expr.right()) {
+        expr.assign_right(right);
+    }
+    if (std::dynamic_pointer_cast<value_expression>(expr.left()) && std::dynamic_pointer_cast<value_expression>(expr.right())) {
+        return fold_value(expr);
+    }
+    return false;
+}
+
+bool constant_folder::fold_unary(unary_expression& expr) {
+    if (auto sub = fold(expr.sub_expr()); sub != expr.sub_expr()) {
+        expr.assign(sub);
+    }
+    if (std::dynamic_pointer_cast<value_expression>(expr.sub_expr())) {
+        return fold_value(expr);
+    }
+    return false;
+}
+
+//
+// Unit and definitions
+//
+
+void constant_folder::visit_unit(unit& unit)
+{
+    visit_namespace(*_unit.get_root_namespace());
+
+    visit_function(_unit.get_global_constructor_function());
+    visit_function(_unit.get_global_destructor_function());
+}
+
+void constant_folder::visit_namespace(ns& ns)
+{
+    for(auto& child : ns.get_children()) {
+        child->accept(*this);
+    }
+}
+
+void constant_folder::visit_structure(structure& st)
+{
+    for(auto& child : st.get_children()) {
+        child->accept(*this);
+    }
+}
+
+void constant_folder::visit_function(function& fn)
+{
+    if(auto block = fn.get_block()) {
+        visit_block(*block);
+    }
+}
+
+//
+// Statements
+//
+
+void constant_folder::visit_block(block& block)
+{
+    // Statements may be replaced while iterating
+    auto statements = block.get_statements();
+    for(auto& stmt : statements) {
+        auto res = fold_statement(stmt);
+        if (res != stmt) {
+            block.replace_statement(stmt, res);
+        }
+    }
+}
+
+void constant_folder::visit_return_statement(return_statement& stmt)
+{
+    if(auto expr = stmt.get_expression()) {
+        if(auto res = fold(expr); res != expr) {
+            stmt.set_expression(res);
+        }
+    }
+}
+
+void constant_folder::visit_if_else_statement(if_else_statement& stmt)
+{
+    if(auto test = fold(stmt.get_test_expr()); test != stmt.get_test_expr()) {
+        stmt.set_test_expr(test);
+    }
+    if(auto then_stmt = fold_nested_statement(stmt.get_then_stmt()); then_stmt != stmt.get_then_stmt()) {
+        stmt.set_then_stmt(then_stmt);
+    }
+    if(auto else_stmt = stmt.get_else_stmt()) {
+        if(auto res = fold_statement(else_stmt); res != else_stmt) {
+            stmt.set_else_stmt(res);
+        }
+    }
+
+    // Constant test: keep only the taken branch
+    if(auto test = llvm::dyn_cast_or_null<llvm::ConstantInt>(get_constant(stmt.get_test_expr()))) {
+        _stmt_replaced = true;
+        _stmt_replacement = test->isOne() ? stmt.get_then_stmt() : stmt.get_else_stmt();
+    }
+}
+
+void constant_folder::visit_while_statement(while_statement& stmt)
+{
+    if(auto test = fold(stmt.get_test_expr()); test != stmt.get_test_expr()) {
+        stmt.set_test_expr(test);
+    }
+    if(auto nested = fold_nested_statement(stmt.get_nested_stmt()); nested != stmt.get_nested_stmt()) {
+        stmt.set_nested_stmt(nested);
+    }
+}
+
+void constant_folder::visit_for_statement(for_statement& stmt)
+{
+    if(auto decl = stmt.get_decl_stmt()) {
+        visit_variable_statement(*decl);
+    }
+    if(auto test = stmt.get_test_expr()) {
+        if(auto res = fold(test); res != test) {
+            stmt.set_test_expr(res);
+        }
+    }
+    if(auto step = stmt.get_step_expr()) {
+        if(auto res = fold(step); res != step) {
+            stmt.set_step_expr(res);
+        }
+    }
+    if(auto nested = fold_nested_statement(stmt.get_nested_stmt()); nested != stmt.get_nested_stmt()) {
+        stmt.set_nested_stmt(nested);
+    }
+}
+
+void constant_folder::visit_expression_statement(expression_statement& stmt)
+{
+    if(auto expr = stmt.get_expression()) {
+        if(auto res = fold(expr); res != expr) {
+            stmt.set_expression(res);
+        }
+    }
+}
+
+void constant_folder::visit_variable_statement(variable_statement& var)
+{
+    if(auto expr = var.get_init_expr()) {
+        if(auto res = fold(expr); res != expr) {
+            var.set_init_expr(res);
+        }
+    }
+}
+
+//
+// Expressions
+//
+
+void constant_folder::visit_cast_expression(cast_expression& expr)
+{
+    if (fold_unary(expr)) {
+        return;
+    }
+    // Cast to the type of the sub-expression is a no-op
+    replace_by_operand(expr, expr.sub_expr());
+}
+
+void constant_folder::visit_arithmetic_binary_expression(arithmetic_binary_expression& expr)
+{
+    fold_binary(expr);
+}
+
+void constant_folder::visit_addition_expression(addition_expression& expr)
+{
+    if (fold_binary(expr) || type::is_prim_float(expr.get_type())) {
+        // Note: "x + 0.0" is not "x" when x is -0.0
+        return;
+    }
+    if (is_constant(expr.right(), 0)) {
+        replace_by_operand(expr, expr.left());
+    } else if (is_constant(expr.left(), 0)) {
+        replace_by_operand(expr, expr.right());
+    }
+}
+
+void constant_folder::visit_substraction_expression(substraction_expression& expr)
+{
+    if (!fold_binary(expr) && is_constant(expr.right(), 0)) {
+        replace_by_operand(expr, expr.left());
+    }
+}
+
+void constant_folder::visit_multiplication_expression(multiplication_expression& expr)
+{
+    if (fold_binary(expr)) {
+        return;
+    }
+    if (is_constant(expr.right(), 1)) {
+        replace_by_operand(expr, expr.left());
+    } else if (is_constant(expr.left(), 1)) {
+        replace_by_operand(expr, expr.right());
+    }
+}
+
+void constant_folder::visit_division_expression(division_expression& expr)
+{
+    if (!fold_binary(expr) && is_constant(expr.right(), 1)) {
+        replace_by_operand(expr, expr.left());
+    }
+}
+
+void constant_folder::visit_bitwise_and_expression(bitwise_and_expression& expr)
+{
+    if (fold_binary(expr)) {
+        return;
+    }
+    if (is_constant(expr.right(), -1)) {
+        replace_by_operand(expr, expr.left());
+    } else if (is_constant(expr.left(), -1)) {
+        replace_by_operand(expr, expr.right());
+    }
+}
+
+void constant_folder::visit_bitwise_or_expression(bitwise_or_expression& expr)
+{
+    if (fold_binary(expr)) {
+        return;
+    }
+    if (is_constant(expr.right(), 0)) {
+        replace_by_operand(expr, expr.left());
+    } else if (is_constant(expr.left(), 0)) {
+        replace_by_operand(expr, expr.right());
+    }
+}
+
+void constant_folder::visit_bitwise_xor_expression(bitwise_xor_expression& expr)
+{
+    if (fold_binary(expr)) {
+        return;
+    }
+    if (is_constant(expr.right(), 0)) {
+        replace_by_operand(expr, expr.left());
+    } else if (is_constant(expr.left(), 0)) {
+        replace_by_operand(expr, expr.right());
+    }
+}
+
+void constant_folder::visit_left_shift_expression(left_shift_expression& expr)
+{
+    if (!fold_binary(expr) && is_constant(expr.right(), 0)) {
+        replace_by_operand(expr, expr.left());
+    }
+}
+
+void constant_folder::visit_right_shift_expression(right_shift_expression& expr)
+{
+    if (!fold_binary(expr) && is_constant(expr.right(), 0)) {
+        replace_by_operand(expr, expr.left());
+    }
+}
+
+void constant_folder::visit_assignation_expression(assignation_expression& expr)
+{
+    // Left hand is the assigned reference, only the assigned value can be folded.
+    if (auto right = fold(expr.right()); right != expr.right()) {
+        expr.assign_right(right);
+    }
+}
+
+void constant_folder::visit_arithmetic_unary_expression(arithmetic_unary_expression& expr)
+{
+    fold_unary(expr);
+}
+
+void constant_folder::visit_unary_plus_expression(unary_plus_expression& expr)
+{
+    if (!fold_unary(expr)) {
+        replace_by_operand(expr, expr.sub_expr());
+    }
+}
+
+void constant_folder::visit_logical_binary_expression(logical_binary_expression& expr)
+{
+    fold_binary(expr);
+}
+
+void constant_folder::visit_logical_and_expression(logical_and_expression& expr)
+{
+    if (fold_binary(expr)) {
+        return;
+    }
+    if (is_constant(expr.right(), 1)) {
+        replace_by_operand(expr, expr.left());
+    } else if (is_constant(expr.left(), 1)) {
+        replace_by_operand(expr, expr.right());
+    }
+}
+
+void constant_folder::visit_logical_or_expression(logical_or_expression& expr)
+{
+    if (fold_binary(expr)) {
+        return;
+    }
+    if (is_constant(expr.right(), 0)) {
+        replace_by_operand(expr, expr.left());
+    } else if (is_constant(expr.left(), 0)) {
+        replace_by_operand(expr, expr.right());
+    }
+}
+
+void constant_folder::visit_logical_not_expression(logical_not_expression& expr)
+{
+    fold_unary(expr);
+}
+
+void constant_folder::visit_comparison_expression(comparison_expression& expr)
+{
+    fold_binary(expr);
+}
+
+void constant_folder::visit_subscript_expression(subscript_expression& expr)
+{
+    // Left hand is the array reference, only the index can be folded.
+    if (auto right = fold(expr.right()); right != expr.right()) {
+        expr.assign_right(right);
+    }
+}
+
+void constant_folder::visit_function_invocation_expression(function_invocation_expression& expr)
+{
+    const auto& arguments = expr.arguments();
+    for (size_t index = 0; index < arguments.size(); ++index) {
+        auto arg = arguments[index];
+        if (auto res = fold(arg); res != arg) {
+            expr.assign_argument(index, res);
+        }
+    }
+}
+
+} // k::model::gen
@@ -0,0 +1,175 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef KLANG_CONSTANT_FOLDER_HPP
+#define KLANG_CONSTANT_FOLDER_HPP
+
+#include "../model/model.hpp"
+#include "../model/model_visitor.hpp"
+
+#include "../model/context.hpp"
+
+#include "constant_evaluator.hpp"
+
+#include <optional>
+
+namespace k::model::gen {
+
+/**
+ * Constant folder
+ * This pass simplifies function bodies before code generation, so code generated without optimization
+ * passes (-O0, baseline JIT) is smaller and faster:
+ * - operations on constant values are folded into values, with the width and signedness of their type,
+ * - casts to the type of their sub-expression are removed,
+ * - neutral operands are removed ("x + 0", "x * 1", "x | 0", "x && true"...),
+ * - if-else statements with a constant test are replaced by the taken branch.
+ * Global variable reads are never folded, as they may be modified at runtime.
+ * It must be run after type resolution and subscript range analysis, which looks for literals.
+ */
+class constant_folder : public default_model_visitor {
+protected:
+
+    std::shared_ptr<context> _context;
+
+    unit& _unit;
+
+    constant_evaluator _evaluator;
+
+    /** Replacement of the last visited expression, null to keep it. */
+    std::shared_ptr<expression> _replacement;
+
+    /** Set when the last visited statement must be replaced by _stmt_replacement (null to remove it). */
+    bool _stmt_replaced = false;
+    std::shared_ptr<statement> _stmt_replacement;
+
+public:
+
+    constant_folder(std::shared_ptr<context> context, unit& unit) :
+    _context(context),
+    _unit(unit),
+    _evaluator(context, false) {
+    }
+
+    void fold();
+
+protected:
+
+    /**
+     * Fold an expression and its sub-expressions.
+     * @return Folded expression, the expression itself if not replaced.
+     */
+    std::shared_ptr<expression> fold(const std::shared_ptr<expression>& expr);
+
+    /**
+     * Fold a statement and its sub-statements.
+     * @return Folded statement, the statement itself if not replaced, null if it must be removed.
+     */
+    std::shared_ptr<statement> fold_statement(const std::shared_ptr<statement>& stmt);
+
+    /**
+     * Fold a sub-statement which cannot be removed (loop body, if-else branch).
+     */
+    std::shared_ptr<statement> fold_nested_statement(const std::shared_ptr<statement>& stmt);
+
+    /**
+     * Convert a constant to a value of a primitive type.
+     * @return Value, nothing if the constant cannot be represented as a value.
+     */
+    static std::optional<k::value_type> to_value(llvm::Constant* constant, const primitive_type& prim);
+
+    /**
+     * Constant value of an expression already folded to a value.
+     * @return Constant, null if the expression is not a value.
+     */
+    llvm::Constant* get_constant(const std::shared_ptr<expression>& expr);
+
+    /**
+     * Test if an expression is a value equal to an integer or float number.
+     */
+    bool is_constant(const std::shared_ptr<expression>& expr, int64_t number);
+
+    /**
+     * Replace an expression whose operands are values by its own value.
+     * @return True if the expression is replaced.
+     */
+    bool fold_value(expression& expr);
+
+    /**
+     * Replace an expression by one of its operands, if it holds a value of the expression type.
+     * Reference operands are loaded.
+     */
+    void replace_by_operand(expression& expr, const std::shared_ptr<expression>& operand);
+
+    /**
+     * Fold both operands of a binary expression.
+     * @return True if the expression itself is replaced by a value.
+     */
+    bool fold_binary(binary_expression& expr);
+
+    /**
+     * Fold the operand of an unary expression.
+     * @return True if the expression itself is replaced by a value.
+     */
+    bool fold_unary(unary_expression& expr);
+
+    void visit_unit(unit&) override;
+
+    void visit_namespace(ns&) override;
+    void visit_structure(structure&) override;
+    void visit_function(function&) override;
+
+    void visit_block(block&) override;
+    void visit_return_statement(return_statement&) override;
+    void visit_if_else_statement(if_else_statement&) override;
+    void visit_while_statement(while_statement&) override;
+    void visit_for_statement(for_statement&) override;
+    void visit_expression_statement(expression_statement&) override;
+    void visit_variable_statement(variable_statement&) override;
+
+    void visit_cast_expression(cast_expression&) override;
+
+    void visit_arithmetic_binary_expression(arithmetic_binary_expression&) override;
+    void visit_addition_expression(addition_expression&) override;
+    void visit_substraction_expression(substraction_expression&) override;
+    void visit_multiplication_expression(multiplication_expression&) override;
+    void visit_division_expression(division_expression&) override;
+    void visit_bitwise_and_expression(bitwise_and_expression&) override;
+    void visit_bitwise_or_expression(bitwise_or_expression&) override;
+    void visit_bitwise_xor_expression(bitwise_xor_expression&) override;
+    void visit_left_shift_expression(left_shift_expression&) override;
+    void visit_right_shift_expression(right_shift_expression&) override;
+
+    void visit_assignation_expression(assignation_expression&) override;
+
+    void visit_arithmetic_unary_expression(arithmetic_unary_expression&) override;
+    void visit_unary_plus_expression(unary_plus_expression&) override;
+
+    void visit_logical_binary_expression(logical_binary_expression&) override;
+    void visit_logical_and_expression(logical_and_expression&) override;
+    void visit_logical_or_expression(logical_or_expression&) override;
+    void visit_logical_not_expression(logical_not_expression&) override;
+
+    void visit_comparison_expression(comparison_expression&) override;
+
+    void visit_subscript_expression(subscript_expression&) override;
+    void visit_function_invocation_expression(function_invocation_expression&) override;
+};
+
+} // k::model::gen
+
+#endif //KLANG_CONSTANT_FOLDER_HPP
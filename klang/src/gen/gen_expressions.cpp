@@ -18,6 +18,7 @@
 #include "resolvers.hpp"
 #include "unit_llvm_ir_gen.hpp"
 
+#include "llvm/IR/MDBuilder.h"
 #include "llvm/Support/raw_os_ostream.h"
 template<typename STM>
 STM& operator << (STM& stm, const llvm::Type& type) {
@@ -53,9 +54,8 @@ llvm::Constant* unit_llvm_ir_gen::get_llvm_constant_from_value_expr(const value_
     if(expr.is_literal()) {
         return _context->get_llvm_constant_from_literal(expr.any_literal());
     } else {
-        // TODO
+        return _context->get_llvm_constant_from_value(expr.get_value(), expr.get_type());
     }
-    return nullptr;
 }
 
 void unit_llvm_ir_gen::visit_value_expression(value_expression &expr) {
@@ -127,6 +127,11 @@ void unit_llvm_ir_gen::visit_symbol_expression(symbol_expression &symbol) {
 
         // Handle source of symbol
         if (auto param = std::dynamic_pointer_cast<parameter>(var_def)) {
+            if (auto it = _context->_parameter_values.find(param); it != _context->_parameter_values.end()) {
+                // Parameter without local storage (reference or 'this'), its value is the referenced address.
+                _value = it->second;
+                return;
+            }
             ptr =  _context->_parameter_variables[param];
             name = param->get_short_name();
         } else if (auto global_var = std::dynamic_pointer_cast<global_variable_definition>(var_def)) {
@@ -145,7 +150,7 @@ void unit_llvm_ir_gen::visit_symbol_expression(symbol_expression &symbol) {
                 // TODO throw exception : no function found in context for member variable access
                 std::cerr << "Error: no function context available for member variable '" << member_var->get_fq_name() << "' access." << std::endl;
             }
-            this_value_ref = _context->_function_this_variables[func];
+            this_value_ref = _context->_function_this_values[func];
             if (!this_value_ref) {
                 // TODO throw exception : no 'this' pointer found in function for member variable access
                 std::cerr << "Error: no 'this' pointer available in function context for member variable '" << member_var->get_fq_name() << "' access." << std::endl;
@@ -160,14 +165,9 @@ void unit_llvm_ir_gen::visit_symbol_expression(symbol_expression &symbol) {
             auto struct_type = struct_ref->get_struct_type();
             if(struct_type) {
                 if(auto field = struct_type->get_member(name); field) {
-                    auto this_ptr = _builder->CreateLoad(
-                            _context->get_llvm_type(struct_type->get_reference()),
-                            this_value_ref,
-                            "this_ref"
-                    );
                     ptr = _builder->CreateStructGEP(
                             _context->get_llvm_type(struct_type),
-                            this_ptr,
+                            this_value_ref,
                             (unsigned)field->index,
                             "this_" + struct_ref->get_short_name() + "_" + name + "_ptr"
                     );
@@ -342,7 +342,7 @@ void type_reference_resolver::process_arithmetic(binary_expression& expr) {
         // Target type must be de-referenced
         target_type = std::dynamic_pointer_cast<reference_type>(target_type)->get_subtype();
     }
-    if(!type::is_primitive(target_type)) {
+    if(!type::is_primitive(target_type) && !type::is_vector(target_type)) {
         // TODO throw an exception
         // Arithmetic for non-primitive types is not supported.
         std::cerr << "Error: Arithmetic for non-primitive types is not supported yet." << std::endl;
@@ -353,8 +353,6 @@ void type_reference_resolver::process_arithmetic(binary_expression& expr) {
         std::cerr << "Error: Arithmetic for boolean is not supported." << std::endl;
     }
 
-    expr.set_type(target_type);
-
     auto source_type = right->get_type();
     if(type::is_pointer(source_type)) {
         // TODO throw an exception
@@ -370,7 +368,29 @@ void type_reference_resolver::process_arithmetic(binary_expression& expr) {
         expr.assign_right(right);
     }
 
-    // TODO Promote to largest target_type instread to align to left operand.
+    // Promote the left operand when the right one is wider (e.g. "a * (long long) b").
+    // Shifts keep the type of their left operand.
+    bool is_shift = dynamic_cast<left_shift_expression*>(&expr) || dynamic_cast<right_shift_expression*>(&expr);
+    auto prim_target = std::dynamic_pointer_cast<primitive_type>(target_type);
+    auto prim_source = std::dynamic_pointer_cast<primitive_type>(source_type);
+    if(!is_shift && prim_target && prim_source && primitive_type::common_type(prim_target, prim_source) != prim_target) {
+        auto promoted = adapt_type(adapt_reference_load_value(left), prim_source);
+        if(promoted) {
+            expr.assign_left(promoted);
+            target_type = prim_source;
+        }
+    }
+
+    // Vector arithmetic is element-wise, a scalar operand on either side is broadcast to all lanes by adapt_type.
+    if(prim_target && type::is_vector(source_type)) {
+        auto broadcast = adapt_type(adapt_reference_load_value(left), source_type);
+        if(broadcast) {
+            expr.assign_left(broadcast);
+            target_type = source_type;
+        }
+    }
+    expr.set_type(target_type);
+
     auto cast = adapt_type(right, target_type);
     if(!cast) {
         // TODO throw an exception
@@ -409,12 +429,12 @@ void unit_llvm_ir_gen::visit_addition_expression(addition_expression &expr) {
     if(type::is_reference(expr.left()->get_type())) {
         auto ref_type = std::dynamic_pointer_cast<reference_type>(expr.left()->get_type());
         llvm::Type* type = _context->get_llvm_type(ref_type->get_subtype());
-        left = _builder->CreateLoad(type, left);
+        left = load_reference(type, left);
     }
 
-    if(type::is_prim_integer(expr.get_type())) {
+    if(type::is_prim_integer(type::get_lane_type(expr.get_type()))) {
         _value = _builder->CreateAdd(left, right);
-    } else if(type::is_prim_float(expr.get_type())) {
+    } else if(type::is_prim_float(type::get_lane_type(expr.get_type()))) {
         _value = _builder->CreateFAdd(left, right);
     } else {
         // TODO: Support other types
@@ -438,12 +458,12 @@ void unit_llvm_ir_gen::visit_substraction_expression(substraction_expression &ex
     if(type::is_reference(expr.left()->get_type())) {
         auto ref_type = std::dynamic_pointer_cast<reference_type>(expr.left()->get_type());
         llvm::Type* type = _context->get_llvm_type(ref_type->get_subtype());
-        left = _builder->CreateLoad(type, left);
+        left = load_reference(type, left);
     }
 
-    if(type::is_prim_integer(expr.get_type())) {
+    if(type::is_prim_integer(type::get_lane_type(expr.get_type()))) {
         _value = _builder->CreateSub(left, right);
-    } else if(type::is_prim_float(expr.get_type())) {
+    } else if(type::is_prim_float(type::get_lane_type(expr.get_type()))) {
         _value = _builder->CreateFSub(left, right);
     } else {
         // TODO: Support other types
@@ -467,14 +487,14 @@ void unit_llvm_ir_gen::visit_multiplication_expression(multiplication_expression
     if(type::is_reference(expr.left()->get_type())) {
         auto ref_type = std::dynamic_pointer_cast<reference_type>(expr.left()->get_type());
         llvm::Type* type = _context->get_llvm_type(ref_type->get_subtype());
-        left = _builder->CreateLoad(type, left);
+        left = load_reference(type, left);
     }
 
     // TODO: Check for type alignement
-    if(type::is_prim_integer(expr.get_type())) {
+    if(type::is_prim_integer(type::get_lane_type(expr.get_type()))) {
         // TODO Should poison for int/uint multiplication overflow ?
         _value = _builder->CreateMul(left, right);
-    } else if(type::is_prim_float(expr.get_type())) {
+    } else if(type::is_prim_float(type::get_lane_type(expr.get_type()))) {
         _value = _builder->CreateFMul(left, right);
     } else {
         // TODO: Support other types
@@ -498,10 +518,10 @@ void unit_llvm_ir_gen::visit_division_expression(division_expression &expr) {
     if(type::is_reference(expr.left()->get_type())) {
         auto ref_type = std::dynamic_pointer_cast<reference_type>(expr.left()->get_type());
         llvm::Type* type = _context->get_llvm_type(ref_type->get_subtype());
-        left = _builder->CreateLoad(type, left);
+        left = load_reference(type, left);
     }
 
-    if(auto prim = std::dynamic_pointer_cast<primitive_type>(expr.get_type())) {
+    if(auto prim = std::dynamic_pointer_cast<primitive_type>(type::get_lane_type(expr.get_type()))) {
         if(prim->is_integer()) {
             if(prim->is_unsigned()) {
                 _value = _builder->CreateUDiv(left, right);
@@ -533,10 +553,10 @@ void unit_llvm_ir_gen::visit_modulo_expression(modulo_expression &expr) {
     if(type::is_reference(expr.left()->get_type())) {
         auto ref_type = std::dynamic_pointer_cast<reference_type>(expr.left()->get_type());
         llvm::Type* type = _context->get_llvm_type(ref_type->get_subtype());
-        left = _builder->CreateLoad(type, left);
+        left = load_reference(type, left);
     }
 
-    if(auto prim = std::dynamic_pointer_cast<primitive_type>(expr.get_type())) {
+    if(auto prim = std::dynamic_pointer_cast<primitive_type>(type::get_lane_type(expr.get_type()))) {
         if(prim->is_integer()) {
             if(prim->is_unsigned()) {
                 _value = _builder->CreateURem(left, right);
@@ -568,10 +588,10 @@ void unit_llvm_ir_gen::visit_bitwise_and_expression(bitwise_and_expression& expr
     if(type::is_reference(expr.left()->get_type())) {
         auto ref_type = std::dynamic_pointer_cast<reference_type>(expr.left()->get_type());
         llvm::Type* type = _context->get_llvm_type(ref_type->get_subtype());
-        left = _builder->CreateLoad(type, left);
+        left = load_reference(type, left);
     }
 
-    if(auto prim = std::dynamic_pointer_cast<primitive_type>(expr.get_type())) {
+    if(auto prim = std::dynamic_pointer_cast<primitive_type>(type::get_lane_type(expr.get_type()))) {
         if(prim->is_integer()) {
             _value = _builder->CreateAnd(left, right);
         } else if(prim->is_float()) {
@@ -601,10 +621,10 @@ void unit_llvm_ir_gen::visit_bitwise_or_expression(bitwise_or_expression& expr)
     if(type::is_reference(expr.left()->get_type())) {
         auto ref_type = std::dynamic_pointer_cast<reference_type>(expr.left()->get_type());
         llvm::Type* type = _context->get_llvm_type(ref_type->get_subtype());
-        left = _builder->CreateLoad(type, left);
+        left = load_reference(type, left);
     }
 
-    if(auto prim = std::dynamic_pointer_cast<primitive_type>(expr.get_type())) {
+    if(auto prim = std::dynamic_pointer_cast<primitive_type>(type::get_lane_type(expr.get_type()))) {
         if(prim->is_integer()) {
             _value = _builder->CreateOr(left, right);
         } else if(prim->is_float()) {
@@ -634,10 +654,10 @@ void unit_llvm_ir_gen::visit_bitwise_xor_expression(bitwise_xor_expression& expr
     if(type::is_reference(expr.left()->get_type())) {
         auto ref_type = std::dynamic_pointer_cast<reference_type>(expr.left()->get_type());
         llvm::Type* type = _context->get_llvm_type(ref_type->get_subtype());
-        left = _builder->CreateLoad(type, left);
+        left = load_reference(type, left);
     }
 
-    if(auto prim = std::dynamic_pointer_cast<primitive_type>(expr.get_type())) {
+    if(auto prim = std::dynamic_pointer_cast<primitive_type>(type::get_lane_type(expr.get_type()))) {
         if(prim->is_integer()) {
             _value = _builder->CreateXor(left, right);
         } else if(prim->is_float()) {
@@ -667,10 +687,10 @@ void unit_llvm_ir_gen::visit_left_shift_expression(left_shift_expression& expr)
     if(type::is_reference(expr.left()->get_type())) {
         auto ref_type = std::dynamic_pointer_cast<reference_type>(expr.left()->get_type());
         llvm::Type* type = _context->get_llvm_type(ref_type->get_subtype());
-        left = _builder->CreateLoad(type, left);
+        left = load_reference(type, left);
     }
 
-    if(auto prim = std::dynamic_pointer_cast<primitive_type>(expr.get_type())) {
+    if(auto prim = std::dynamic_pointer_cast<primitive_type>(type::get_lane_type(expr.get_type()))) {
         if(prim->is_integer()) {
             // TODO may it poison when overflow ?
             _value = _builder->CreateShl(left, right);
@@ -701,10 +721,10 @@ void unit_llvm_ir_gen::visit_right_shift_expression(right_shift_expression& expr
     if(type::is_reference(expr.left()->get_type())) {
         auto ref_type = std::dynamic_pointer_cast<reference_type>(expr.left()->get_type());
         llvm::Type* type = _context->get_llvm_type(ref_type->get_subtype());
-        left = _builder->CreateLoad(type, left);
+        left = load_reference(type, left);
     }
 
-    if(auto prim = std::dynamic_pointer_cast<primitive_type>(expr.get_type())) {
+    if(auto prim = std::dynamic_pointer_cast<primitive_type>(type::get_lane_type(expr.get_type()))) {
         if(prim->is_integer()) {
             if(prim->is_unsigned()) {
                 // TODO may it poison when overflow ?
@@ -768,7 +788,7 @@ void type_reference_resolver::visit_assignation_expression(assignation_expressio
             // Error : Pointer assignation can only receive a pointer
             std::cerr << "Error: Pointer assignation can only receive a pointer." << std::endl;
         }
-    } else if(!type::is_primitive(target_type)) {
+    } else if(!type::is_primitive(target_type) && !type::is_vector(target_type)) {
         // TODO throw an exception
         // Arithmetic for non-primitive types is not supported.
         std::cerr << "Error: Arithmetic for non-primitive types is not supported yet." << std::endl;
@@ -824,7 +844,7 @@ void unit_llvm_ir_gen::visit_simple_assignation_expression(simple_assignation_ex
     _value = right;
 
     // Store the value, return the left ref
-    _value = _builder->CreateStore(_value, left);
+    _value = store_reference(_value, left);
     _value = left;
 
 }
@@ -870,17 +890,17 @@ void unit_llvm_ir_gen::visit_addition_assignation_expression(additition_assignat
     auto left_type = left_ref_type->get_subtype();
     auto llvm_type = _context->get_llvm_type(left_type);
 
-    auto left_val = _builder->CreateLoad(llvm_type, left);
-    if(type::is_prim_integer(left_type)) {
+    auto left_val = load_reference(llvm_type, left);
+    if(type::is_prim_integer(type::get_lane_type(left_type))) {
         _value = _builder->CreateAdd(left_val, right);
-    } else if(type::is_prim_float(left_type)) {
+    } else if(type::is_prim_float(type::get_lane_type(left_type))) {
         _value = _builder->CreateFAdd(left_val, right);
     } else {
         // TODO: Support other types
     }
 
     // Store the value, return the left ref
-    _value = _builder->CreateStore(_value, left);
+    _value = store_reference(_value, left);
     _value = left;
 }
 
@@ -901,17 +921,17 @@ void unit_llvm_ir_gen::visit_substraction_assignation_expression(substraction_as
     auto left_type = left_ref_type->get_subtype();
     auto llvm_type = _context->get_llvm_type(left_type);
 
-    auto left_val = _builder->CreateLoad(llvm_type, left);
-    if(type::is_prim_integer(left_type)) {
+    auto left_val = load_reference(llvm_type, left);
+    if(type::is_prim_integer(type::get_lane_type(left_type))) {
         _value = _builder->CreateSub(left_val, right);
-    } else if(type::is_prim_float(left_type)) {
+    } else if(type::is_prim_float(type::get_lane_type(left_type))) {
         _value = _builder->CreateFSub(left_val, right);
     } else {
         // TODO: Support other types
     }
 
     // Store the value, return the left ref
-    _value = _builder->CreateStore(_value, left);
+    _value = store_reference(_value, left);
     _value = left;
 }
 
@@ -932,17 +952,17 @@ void unit_llvm_ir_gen::visit_multiplication_assignation_expression(multiplicatio
     auto left_type = left_ref_type->get_subtype();
     auto llvm_type = _context->get_llvm_type(left_type);
 
-    auto left_val = _builder->CreateLoad(llvm_type, left);
-    if(type::is_prim_integer(left_type)) {
+    auto left_val = load_reference(llvm_type, left);
+    if(type::is_prim_integer(type::get_lane_type(left_type))) {
         _value = _builder->CreateMul(left_val, right);
-    } else if(type::is_prim_float(left_type)) {
+    } else if(type::is_prim_float(type::get_lane_type(left_type))) {
         _value = _builder->CreateFMul(left_val, right);
     } else {
         // TODO: Support other types
     }
 
     // Store the value, return the left ref
-    _value = _builder->CreateStore(_value, left);
+    _value = store_reference(_value, left);
     _value = left;
 }
 
@@ -963,8 +983,8 @@ void unit_llvm_ir_gen::visit_division_assignation_expression(division_assignatio
     auto left_type = left_ref_type->get_subtype();
     auto llvm_type = _context->get_llvm_type(left_type);
 
-    auto left_val = _builder->CreateLoad(llvm_type, left);
-    if(auto prim = std::dynamic_pointer_cast<primitive_type>(left_type)) {
+    auto left_val = load_reference(llvm_type, left);
+    if(auto prim = std::dynamic_pointer_cast<primitive_type>(type::get_lane_type(left_type))) {
         if(prim->is_integer()) {
             if(prim->is_unsigned()) {
                 _value = _builder->CreateUDiv(left_val, right);
@@ -979,7 +999,7 @@ void unit_llvm_ir_gen::visit_division_assignation_expression(division_assignatio
     }
 
     // Store the value, return the left ref
-    _value = _builder->CreateStore(_value, left);
+    _value = store_reference(_value, left);
     _value = left;
 }
 
@@ -1000,8 +1020,8 @@ void unit_llvm_ir_gen::visit_modulo_assignation_expression(modulo_assignation_ex
     auto left_type = left_ref_type->get_subtype();
     auto llvm_type = _context->get_llvm_type(left_type);
 
-    auto left_val = _builder->CreateLoad(llvm_type, left);
-    if(auto prim = std::dynamic_pointer_cast<primitive_type>(left_type)) {
+    auto left_val = load_reference(llvm_type, left);
+    if(auto prim = std::dynamic_pointer_cast<primitive_type>(type::get_lane_type(left_type))) {
         if(prim->is_integer()) {
             if(prim->is_unsigned()) {
                 _value = _builder->CreateURem(left_val, right);
@@ -1016,7 +1036,7 @@ void unit_llvm_ir_gen::visit_modulo_assignation_expression(modulo_assignation_ex
     }
 
     // Store the value, return the left ref
-    _value = _builder->CreateStore(_value, left);
+    _value = store_reference(_value, left);
     _value = left;
 }
 
@@ -1037,8 +1057,8 @@ void unit_llvm_ir_gen::visit_bitwise_and_assignation_expression(bitwise_and_assi
     auto left_type = left_ref_type->get_subtype();
     auto llvm_type = _context->get_llvm_type(left_type);
 
-    auto left_val = _builder->CreateLoad(llvm_type, left);
-    if(auto prim = std::dynamic_pointer_cast<primitive_type>(left_type)) {
+    auto left_val = load_reference(llvm_type, left);
+    if(auto prim = std::dynamic_pointer_cast<primitive_type>(type::get_lane_type(left_type))) {
         if(prim->is_integer()) {
             _value = _builder->CreateAnd(left_val, right);
         } else if(prim->is_float()) {
@@ -1051,7 +1071,7 @@ void unit_llvm_ir_gen::visit_bitwise_and_assignation_expression(bitwise_and_assi
     }
 
     // Store the value, return the left ref
-    _value = _builder->CreateStore(_value, left);
+    _value = store_reference(_value, left);
     _value = left;
 }
 
@@ -1072,8 +1092,8 @@ void unit_llvm_ir_gen::visit_bitwise_or_assignation_expression(bitwise_or_assign
     auto left_type = left_ref_type->get_subtype();
     auto llvm_type = _context->get_llvm_type(left_type);
 
-    auto left_val = _builder->CreateLoad(llvm_type, left);
-    if(auto prim = std::dynamic_pointer_cast<primitive_type>(left_type)) {
+    auto left_val = load_reference(llvm_type, left);
+    if(auto prim = std::dynamic_pointer_cast<primitive_type>(type::get_lane_type(left_type))) {
         if(prim->is_integer()) {
             _value = _builder->CreateOr(left_val, right);
         } else if(prim->is_float()) {
@@ -1086,7 +1106,7 @@ void unit_llvm_ir_gen::visit_bitwise_or_assignation_expression(bitwise_or_assign
     }
 
     // Store the value, return the left ref
-    _value = _builder->CreateStore(_value, left);
+    _value = store_reference(_value, left);
     _value = left;
 }
 
@@ -1107,8 +1127,8 @@ void unit_llvm_ir_gen::visit_bitwise_xor_assignation_expression(bitwise_xor_assi
     auto left_type = left_ref_type->get_subtype();
     auto llvm_type = _context->get_llvm_type(left_type);
 
-    auto left_val = _builder->CreateLoad(llvm_type, left);
-    if(auto prim = std::dynamic_pointer_cast<primitive_type>(left_type)) {
+    auto left_val = load_reference(llvm_type, left);
+    if(auto prim = std::dynamic_pointer_cast<primitive_type>(type::get_lane_type(left_type))) {
         if(prim->is_integer()) {
             _value = _builder->CreateXor(left_val, right);
         } else if(prim->is_float()) {
@@ -1121,7 +1141,7 @@ void unit_llvm_ir_gen::visit_bitwise_xor_assignation_expression(bitwise_xor_assi
     }
 
     // Store the value, return the left ref
-    _value = _builder->CreateStore(_value, left);
+    _value = store_reference(_value, left);
     _value = left;
 }
 
@@ -1142,8 +1162,8 @@ void unit_llvm_ir_gen::visit_left_shift_assignation_expression(left_shift_assign
     auto left_type = left_ref_type->get_subtype();
     auto llvm_type = _context->get_llvm_type(left_type);
 
-    auto left_val = _builder->CreateLoad(llvm_type, left);
-    if(auto prim = std::dynamic_pointer_cast<primitive_type>(left_type)) {
+    auto left_val = load_reference(llvm_type, left);
+    if(auto prim = std::dynamic_pointer_cast<primitive_type>(type::get_lane_type(left_type))) {
         if(prim->is_integer()) {
             // TODO may it poison when overflow ?
             _value = _builder->CreateShl(left_val, right);
@@ -1157,7 +1177,7 @@ void unit_llvm_ir_gen::visit_left_shift_assignation_expression(left_shift_assign
     }
 
     // Store the value, return the left ref
-    _value = _builder->CreateStore(_value, left);
+    _value = store_reference(_value, left);
     _value = left;
 }
 
@@ -1178,8 +1198,8 @@ void unit_llvm_ir_gen::visit_right_shift_assignation_expression(right_shift_assi
     auto left_type = left_ref_type->get_subtype();
     auto llvm_type = _context->get_llvm_type(left_type);
 
-    auto left_val = _builder->CreateLoad(llvm_type, left);
-    if(auto prim = std::dynamic_pointer_cast<primitive_type>(left_type)) {
+    auto left_val = load_reference(llvm_type, left);
+    if(auto prim = std::dynamic_pointer_cast<primitive_type>(type::get_lane_type(left_type))) {
         if(prim->is_integer()) {
             if(prim->is_unsigned()) {
                 // TODO may it poison when overflow ?
@@ -1198,7 +1218,7 @@ void unit_llvm_ir_gen::visit_right_shift_assignation_expression(right_shift_assi
     }
 
     // Store the value, return the left ref
-    _value = _builder->CreateStore(_value, left);
+    _value = store_reference(_value, left);
     _value = left;
 }
 
@@ -1248,7 +1268,7 @@ void unit_llvm_ir_gen::visit_unary_plus_expression(unary_plus_expression& expr)
     if(type::is_reference(type)) {
         type = type->get_subtype();
         // If reference, dereference it.
-        val = _builder->CreateLoad(_context->get_llvm_type(type), val);
+        val = load_reference(_context->get_llvm_type(type), val);
     }
 
     if(type::is_primitive(type)) {
@@ -1275,7 +1295,7 @@ void unit_llvm_ir_gen::visit_unary_minus_expression(unary_minus_expression& expr
     if(type::is_reference(type)) {
         type = type->get_subtype();
         // If reference, dereference it.
-        val = _builder->CreateLoad(_context->get_llvm_type(type), val);
+        val = load_reference(_context->get_llvm_type(type), val);
     }
 
     if(auto prim = std::dynamic_pointer_cast<primitive_type>(type)) {
@@ -1310,7 +1330,7 @@ void unit_llvm_ir_gen::visit_bitwise_not_expression(bitwise_not_expression& expr
     if(type::is_reference(type)) {
         type = type->get_subtype();
         // If reference, dereference it.
-        val = _builder->CreateLoad(_context->get_llvm_type(type), val);
+        val = load_reference(_context->get_llvm_type(type), val);
     }
 
     if(auto prim = std::dynamic_pointer_cast<primitive_type>(type)) {
@@ -1406,7 +1426,7 @@ void unit_llvm_ir_gen::visit_logical_and_expression(logical_and_expression& expr
     // Right is supposed to be already dereferenced
     if(type::is_reference(expr.left()->get_type())) {
         llvm::Type* type = _context->get_llvm_type(expr.left()->get_type());
-        left = _builder->CreateLoad(type, left);
+        left = load_reference(type, left);
     }
 
     if(!type::is_primitive(expr.left()->get_type()) || !type::is_primitive(expr.right()->get_type())) {
@@ -1434,7 +1454,7 @@ void unit_llvm_ir_gen::visit_logical_or_expression(logical_or_expression& expr)
     // Right is supposed to be already dereferenced
     if(type::is_reference(expr.left()->get_type())) {
         llvm::Type* type = _context->get_llvm_type(expr.left()->get_type());
-        left = _builder->CreateLoad(type, left);
+        left = load_reference(type, left);
     }
 
     if(!type::is_primitive(expr.left()->get_type()) || !type::is_primitive(expr.right()->get_type())) {
@@ -1467,7 +1487,7 @@ void type_reference_resolver::visit_logical_not_expression(logical_not_expressio
         std::cerr << "Error: Logical negation for non-primitive types is not supported yet." << std::endl;
     }
 
-    static auto bool_type = _context->from_type(primitive_type::BOOL);
+    auto bool_type = _context->from_type(primitive_type::BOOL);
     auto cast = adapt_type(sub, bool_type);
     if(!cast) {
         // TODO throw an exception
@@ -1499,7 +1519,7 @@ void unit_llvm_ir_gen::visit_logical_not_expression(logical_not_expression& expr
     if(type::is_reference(type)) {
         // Dereference
         type = type->get_subtype();
-        value = _builder->CreateLoad(_context->get_llvm_type(type), value);
+        value = load_reference(_context->get_llvm_type(type), value);
     }
 
     if(!type::is_primitive(type)) {
@@ -1563,7 +1583,7 @@ void type_reference_resolver::visit_load_value_expression(load_value_expression&
 void unit_llvm_ir_gen::visit_load_value_expression(load_value_expression& expr) {
     _value = nullptr;
     expr.sub_expr()->accept(*this);
-    _value = _builder->CreateLoad(_context->get_llvm_type(expr.get_type()), _value);
+    _value = load_reference(_context->get_llvm_type(expr.get_type()), _value);
 }
 
 
@@ -1741,7 +1761,7 @@ void type_reference_resolver::visit_comparison_expression(comparison_expression&
     }
 
     // For primitive type, logical is always returning boolean
-    static auto bool_type = _context->from_type(primitive_type::BOOL);
+    auto bool_type = _context->from_type(primitive_type::BOOL);
     expr.set_type(bool_type);
 }
 
@@ -1760,10 +1780,10 @@ void unit_llvm_ir_gen::visit_equal_expression(equal_expression& expr) {
     // If operands are references, dereference them.
     llvm::Type* type = _context->get_llvm_type(expr.get_type());
     if(type::is_reference(expr.left()->get_type())) {
-        left = _builder->CreateLoad(type, left);
+        left = load_reference(type, left);
     }
     if(type::is_reference(expr.right()->get_type())) {
-        right = _builder->CreateLoad(type, right);
+        right = load_reference(type, right);
     }
 
     if(!type::is_primitive(expr.left()->get_type()) || !type::is_primitive(expr.right()->get_type())) {
@@ -1773,7 +1793,7 @@ void unit_llvm_ir_gen::visit_equal_expression(equal_expression& expr) {
     }
 
     // For primitives, operand types are supposed to be aligned
-    static auto bool_type = _context->from_type(primitive_type::BOOL);
+    auto bool_type = _context->from_type(primitive_type::BOOL);
     auto prim = std::dynamic_pointer_cast<primitive_type>(expr.left()->get_type());
 
     if(prim->is_integer_or_bool()) {
@@ -1800,10 +1820,10 @@ void unit_llvm_ir_gen::visit_different_expression(different_expression& expr) {
     // If operands are references, dereference them.
     llvm::Type* type = _context->get_llvm_type(expr.get_type());
     if(type::is_reference(expr.left()->get_type())) {
-        left = _builder->CreateLoad(type, left);
+        left = load_reference(type, left);
     }
     if(type::is_reference(expr.right()->get_type())) {
-        right = _builder->CreateLoad(type, right);
+        right = load_reference(type, right);
     }
 
     if(!type::is_primitive(expr.left()->get_type()) || !type::is_primitive(expr.right()->get_type())) {
@@ -1813,7 +1833,7 @@ void unit_llvm_ir_gen::visit_different_expression(different_expression& expr) {
     }
 
     // For primitives, operand types are supposed to be aligned
-    static auto bool_type = _context->from_type(primitive_type::BOOL);
+    auto bool_type = _context->from_type(primitive_type::BOOL);
     auto prim = std::dynamic_pointer_cast<primitive_type>(expr.left()->get_type());
 
     if(prim->is_integer_or_bool()) {
@@ -1840,10 +1860,10 @@ void unit_llvm_ir_gen::visit_lesser_expression(lesser_expression& expr) {
     // If operands are references, dereference them.
     llvm::Type* type = _context->get_llvm_type(expr.get_type());
     if(type::is_reference(expr.left()->get_type())) {
-        left = _builder->CreateLoad(type, left);
+        left = load_reference(type, left);
     }
     if(type::is_reference(expr.right()->get_type())) {
-        right = _builder->CreateLoad(type, right);
+        right = load_reference(type, right);
     }
 
     if(!type::is_primitive(expr.left()->get_type()) || !type::is_primitive(expr.right()->get_type())) {
@@ -1853,7 +1873,7 @@ void unit_llvm_ir_gen::visit_lesser_expression(lesser_expression& expr) {
     }
 
     // For primitives, operand types are supposed to be aligned
-    static auto bool_type = _context->from_type(primitive_type::BOOL);
+    auto bool_type = _context->from_type(primitive_type::BOOL);
     auto prim = std::dynamic_pointer_cast<primitive_type>(expr.left()->get_type());
 
     if(prim->is_integer_or_bool()) {
@@ -1884,10 +1904,10 @@ void unit_llvm_ir_gen::visit_greater_expression(greater_expression& expr) {
     // If operands are references, dereference them.
     llvm::Type* type = _context->get_llvm_type(expr.get_type());
     if(type::is_reference(expr.left()->get_type())) {
-        left = _builder->CreateLoad(type, left);
+        left = load_reference(type, left);
     }
     if(type::is_reference(expr.right()->get_type())) {
-        right = _builder->CreateLoad(type, right);
+        right = load_reference(type, right);
     }
 
     if(!type::is_primitive(expr.left()->get_type()) || !type::is_primitive(expr.right()->get_type())) {
@@ -1897,7 +1917,7 @@ void unit_llvm_ir_gen::visit_greater_expression(greater_expression& expr) {
     }
 
     // For primitives, operand types are supposed to be aligned
-    static auto bool_type = _context->from_type(primitive_type::BOOL);
+    auto bool_type = _context->from_type(primitive_type::BOOL);
     auto prim = std::dynamic_pointer_cast<primitive_type>(expr.left()->get_type());
 
     if(prim->is_integer_or_bool()) {
@@ -1928,10 +1948,10 @@ void unit_llvm_ir_gen::visit_lesser_equal_expression(lesser_equal_expression& ex
     // If operands are references, dereference them.
     llvm::Type* type = _context->get_llvm_type(expr.get_type());
     if(type::is_reference(expr.left()->get_type())) {
-        left = _builder->CreateLoad(type, left);
+        left = load_reference(type, left);
     }
     if(type::is_reference(expr.right()->get_type())) {
-        right = _builder->CreateLoad(type, right);
+        right = load_reference(type, right);
     }
 
     if(!type::is_primitive(expr.left()->get_type()) || !type::is_primitive(expr.right()->get_type())) {
@@ -1941,7 +1961,7 @@ void unit_llvm_ir_gen::visit_lesser_equal_expression(lesser_equal_expression& ex
     }
 
     // For primitives, operand types are supposed to be aligned
-    static auto bool_type = _context->from_type(primitive_type::BOOL);
+    auto bool_type = _context->from_type(primitive_type::BOOL);
     auto prim = std::dynamic_pointer_cast<primitive_type>(expr.left()->get_type());
 
     if(prim->is_integer_or_bool()) {
@@ -1972,10 +1992,10 @@ void unit_llvm_ir_gen::visit_greater_equal_expression(greater_equal_expression&
     // If operands are references, dereference them.
     llvm::Type* type = _context->get_llvm_type(expr.get_type());
     if(type::is_reference(expr.left()->get_type())) {
-        left = _builder->CreateLoad(type, left);
+        left = load_reference(type, left);
     }
     if(type::is_reference(expr.right()->get_type())) {
-        right = _builder->CreateLoad(type, right);
+        right = load_reference(type, right);
     }
 
     if(!type::is_primitive(expr.left()->get_type()) || !type::is_primitive(expr.right()->get_type())) {
@@ -1985,7 +2005,7 @@ void unit_llvm_ir_gen::visit_greater_equal_expression(greater_equal_expression&
     }
 
     // For primitives, operand types are supposed to be aligned
-    static auto bool_type = _context->from_type(primitive_type::BOOL);
+    auto bool_type = _context->from_type(primitive_type::BOOL);
     auto prim = std::dynamic_pointer_cast<primitive_type>(expr.left()->get_type());
 
     if(prim->is_integer_or_bool()) {
@@ -2027,13 +2047,17 @@ void type_reference_resolver::visit_subscript_expression(subscript_expression& e
     }
     left_type = std::dynamic_pointer_cast<reference_type>(left_type)->get_subtype();
 
-    if(!type::is_array(left_type)) {
+    if(auto vec_type = std::dynamic_pointer_cast<vector_type>(left_type)) {
+        // Lane access
+        expr.set_type(vec_type->get_lane_type()->get_reference());
+    } else if(!type::is_array(left_type)) {
         // TODO throw an exception
         // Subscript expression is supported only for arrays.
-        std::cerr << "Error: Subscript expression is supported only for arrays." << std::endl;
+        std::cerr << "Error: Subscript expression is supported only for arrays and vectors." << std::endl;
+    } else {
+        auto arr_type = std::dynamic_pointer_cast<array_type>(left_type);
+        expr.set_type(arr_type->get_subtype()->get_reference());
     }
-    auto arr_type = std::dynamic_pointer_cast<array_type>(left_type);
-    expr.set_type(arr_type->get_subtype()->get_reference());
 
     // Check the right hand can be cast to unsigned integer
     // TODO adapt to the really right index type.
@@ -2069,15 +2093,87 @@ void unit_llvm_ir_gen::visit_subscript_expression(subscript_expression& expr) {
     auto right_type = expr.right()->get_type();
     if(type::is_reference(right_type)) {
         right_type = std::dynamic_pointer_cast<reference_type>(right_type)->get_subtype();
-        right = _builder->CreateLoad(_context->get_llvm_type(right_type), right);
+        right = load_reference(_context->get_llvm_type(right_type), right);
     }
 
-    auto arr_type = _context->get_llvm_type(left_type->get_subtype());
+    auto array_type = left_type->get_subtype();
+    auto arr_type = _context->get_llvm_type(array_type);
+    auto sized_array = std::dynamic_pointer_cast<sized_array_type>(array_type);
 
-    llvm::Value* indices[] = {_builder->getInt32(0), right};
+    if (sized_array && expr.is_index_in_bounds()) {
+        assume_index_range(right, sized_array->get_size());
+    }
+    // Index arithmetic is done on the pointer index width: the unsigned index must be zero-extended,
+    // as GEP sign-extends narrower indices.
+    auto index_type = get_module().getDataLayout().getIndexType(left->getType());
+    if (right->getType()->getIntegerBitWidth() < index_type->getIntegerBitWidth()) {
+        right = _builder->CreateZExt(right, index_type);
+    }
 
-//    _value = _builder->Insert(llvm::GetElementPtrInst::Create(arr_type, left, indices));
-    _value = _builder->CreateGEP(arr_type, left, indices);
+    llvm::Value* indices[] = {_builder->getInt64(0), right};
+
+    if (sized_array) {
+        if (_checked_subscripts && !expr.is_index_in_bounds()) {
+            // Trap when out of bounds
+            llvm::Function* func = _builder->GetInsertBlock()->getParent();
+            llvm::BasicBlock* trap_block = llvm::BasicBlock::Create(**_context, "subscript-out-of-bounds");
+            llvm::BasicBlock* cont_block = llvm::BasicBlock::Create(**_context, "subscript-in-bounds");
+            auto in_bounds = _builder->CreateICmpULT(right, llvm::ConstantInt::get(right->getType(), sized_array->get_size()));
+            // Same weights as a likely expectation (__builtin_expect)
+            _builder->CreateCondBr(in_bounds, cont_block, trap_block, llvm::MDBuilder(**_context).createBranchWeights(2000, 1));
+
+            func->insert(func->end(), trap_block);
+            _builder->SetInsertPoint(trap_block);
+            _builder->CreateIntrinsic(llvm::Intrinsic::trap, {}, {});
+            _builder->CreateUnreachable();
+
+            func->insert(func->end(), cont_block);
+            _builder->SetInsertPoint(cont_block);
+        }
+        if (expr.is_index_in_bounds() || _checked_subscripts) {
+            // Index proven in bounds or checked (trapping otherwise).
+            _value = _builder->CreateInBoundsGEP(arr_type, left, indices);
+        } else {
+            // Unchecked index, out of bounds accesses must not be made more undefined than they already are.
+            _value = _builder->CreateGEP(arr_type, left, indices);
+        }
+    } else if (type::is_vector(array_type)) {
+        // Lanes are read and written through the whole vector (extract and insert element), the lane address is only
+        // used when a reference to the lane is bound.
+        _value = _builder->CreateGEP(arr_type, left, indices);
+        _vector_lanes[_value] = {arr_type, left, right};
+    } else {
+        // Unsized arrays
+        _value = _builder->CreateGEP(arr_type, left, indices);
+    }
+}
+
+void unit_llvm_ir_gen::assume_index_range(llvm::Value* index, uint64_t size) {
+    if (!index->getType()->isIntegerTy() || llvm::isa<llvm::Constant>(index)) {
+        return;
+    }
+    unsigned int bits = index->getType()->getIntegerBitWidth();
+    if (size == 0 || (bits < 64 && size >= (uint64_t{1} << bits))) {
+        // Range is empty or the full set of values of the type.
+        return;
+    }
+    _builder->CreateAssumption(_builder->CreateICmpULT(index, llvm::ConstantInt::get(index->getType(), size)));
+}
+
+llvm::Value* unit_llvm_ir_gen::load_reference(llvm::Type* type, llvm::Value* ref) {
+    if (auto it = _vector_lanes.find(ref); it != _vector_lanes.end()) {
+        auto vector = _builder->CreateLoad(it->second.type, it->second.vector);
+        return _builder->CreateExtractElement(vector, it->second.index);
+    }
+    return _builder->CreateLoad(type, ref);
+}
+
+llvm::Value* unit_llvm_ir_gen::store_reference(llvm::Value* value, llvm::Value* ref) {
+    if (auto it = _vector_lanes.find(ref); it != _vector_lanes.end()) {
+        auto vector = _builder->CreateLoad(it->second.type, it->second.vector);
+        return _builder->CreateStore(_builder->CreateInsertElement(vector, value, it->second.index), it->second.vector);
+    }
+    return _builder->CreateStore(value, ref);
 }
 
 //
@@ -2085,7 +2181,14 @@ void unit_llvm_ir_gen::visit_subscript_expression(subscript_expression& expr) {
 //
 
 void symbol_resolver::visit_function_invocation_expression(function_invocation_expression &expr) {
-    expr.callee_expr()->accept(*this);
+    auto callee = std::dynamic_pointer_cast<symbol_expression>(expr.callee_expr());
+    auto builtin = callee ? function_invocation_expression::builtin_from_name(callee->get_name()) : function_invocation_expression::NO_BUILTIN;
+    if (builtin != function_invocation_expression::NO_BUILTIN && std::holds_alternative<std::monostate>(resolve_symbol(*callee))) {
+        // Builtin function, unless hidden by a user symbol of the same name.
+        expr.set_builtin(builtin);
+    } else {
+        expr.callee_expr()->accept(*this);
+    }
     for (auto arg : expr.arguments()) {
         arg->accept(*this);
     }
@@ -2093,6 +2196,11 @@ void symbol_resolver::visit_function_invocation_expression(function_invocation_e
 }
 
 void type_reference_resolver::visit_function_invocation_expression(function_invocation_expression &expr) {
+    if(expr.is_builtin()) {
+        process_vector_builtin(expr);
+        return;
+    }
+
     auto callee = std::dynamic_pointer_cast<symbol_expression>(expr.callee_expr());
     auto member_callee = std::dynamic_pointer_cast<member_of_object_expression>(expr.callee_expr());
 
@@ -2131,6 +2239,8 @@ void type_reference_resolver::visit_function_invocation_expression(function_invo
                         // Function prototype and expression type are set at resolution
                         callee->set_target(func);
                         expr.set_type(func->get_return_type());
+                        // The object is bound to 'this', a reference.
+                        check_reference_alignment(member_callee->sub_expr(), sub_expr_type);
                     } else {
                         // TODO throw an exception
                         std::cerr << "Error : cannot find member function '" << callee->get_name().to_string() << "' in struct '" << st->get_short_name() << "'" << std::endl;
@@ -2206,7 +2316,137 @@ void type_reference_resolver::visit_function_invocation_expression(function_invo
     }
 }
 
+void type_reference_resolver::process_vector_builtin(function_invocation_expression &expr) {
+    for(auto& arg : expr.arguments()) {
+        arg->accept(*this);
+    }
+
+    // Vector operand type, dereferenced if needed.
+    auto vector_of = [](const std::shared_ptr<expression>& arg) {
+        auto type = arg->get_type();
+        if(type::is_reference(type)) {
+            type = type->get_subtype();
+        }
+        return std::dynamic_pointer_cast<vector_type>(type);
+    };
+
+    if(expr.arguments().empty() || !vector_of(expr.arguments().front())) {
+        throw_error(0x000C, std::nullopt, "Vector builtin functions expect a vector as first argument");
+    }
+    auto vec_type = vector_of(expr.arguments().front());
+    expr.assign_argument(0, adapt_type(expr.arguments().front(), vec_type));
+
+    if(expr.get_builtin() != function_invocation_expression::VECTOR_SHUFFLE) {
+        // Reductions
+        if(expr.arguments().size() != 1) {
+            throw_error(0x000D, std::nullopt, "Vector reductions expect exactly one argument");
+        }
+        expr.set_type(vec_type->get_lane_type());
+        return;
+    }
+
+    // Shuffle: first vector, optional second vector of the same type, then lane indices.
+    size_t first_index = 1;
+    if(expr.arguments().size() > 1 && vector_of(expr.arguments()[1])) {
+        if(vector_of(expr.arguments()[1]) != vec_type) {
+            throw_error(0x000E, std::nullopt, "Shuffled vectors must be of the same type");
+        }
+        expr.assign_argument(1, adapt_type(expr.arguments()[1], vec_type));
+        first_index = 2;
+    }
+    if(expr.arguments().size() == first_index) {
+        throw_error(0x000F, std::nullopt, "Vector shuffle expects at least one lane index");
+    }
+    for(size_t n = first_index; n < expr.arguments().size(); ++n) {
+        auto value = std::dynamic_pointer_cast<value_expression>(expr.arguments()[n]);
+        if(!value || !type::is_prim_integer(value->get_type())) {
+            throw_error(0x0010, std::nullopt, "Vector shuffle lane indices must be integer literals");
+        }
+    }
+    expr.set_type(vec_type->get_lane_type()->get_vector(expr.arguments().size() - first_index));
+}
+
+void unit_llvm_ir_gen::process_vector_builtin(function_invocation_expression &expr) {
+    std::vector<llvm::Value*> args;
+    for(auto arg : expr.arguments()) {
+        _value = nullptr;
+        arg->accept(*this);
+        if(!_value) {
+            // Problem with argument generation
+            // TODO throw exception
+            std::cerr << "Problem with generation of an argument of a vector builtin function." << std::endl;
+            return;
+        }
+        args.push_back(_value);
+    }
+
+    auto vec_type = args.empty() ? nullptr : std::dynamic_pointer_cast<vector_type>(expr.arguments().front()->get_type());
+    if(!vec_type) {
+        throw_error(0x0007, std::nullopt, "Vector builtin functions expect a vector as first argument");
+    }
+    auto lane = std::dynamic_pointer_cast<primitive_type>(vec_type->get_lane_type());
+    llvm::Type* lane_type = _context->get_llvm_type(lane);
+
+    // Float reductions are not ordered: lanes are combined in any order, as a SIMD tree instead of a sequential chain.
+    switch(expr.get_builtin()) {
+        case function_invocation_expression::VECTOR_REDUCE_ADD:
+            if(lane->is_float()) {
+                auto call = _builder->CreateFAddReduce(llvm::ConstantFP::getNegativeZero(lane_type), args[0]);
+                call->setHasAllowReassoc(true);
+                _value = call;
+            } else {
+                _value = _builder->CreateAddReduce(args[0]);
+            }
+            break;
+        case function_invocation_expression::VECTOR_REDUCE_MUL:
+            if(lane->is_float()) {
+                auto call = _builder->CreateFMulReduce(llvm::ConstantFP::get(lane_type, 1.0), args[0]);
+                call->setHasAllowReassoc(true);
+                _value = call;
+            } else {
+                _value = _builder->CreateMulReduce(args[0]);
+            }
+            break;
+        case function_invocation_expression::VECTOR_REDUCE_MIN:
+            _value = lane->is_float() ? _builder->CreateFPMinReduce(args[0]) : _builder->CreateIntMinReduce(args[0], lane->is_signed());
+            break;
+        case function_invocation_expression::VECTOR_REDUCE_MAX:
+            _value = lane->is_float() ? _builder->CreateFPMaxReduce(args[0]) : _builder->CreateIntMaxReduce(args[0], lane->is_signed());
+            break;
+        case function_invocation_expression::VECTOR_SHUFFLE: {
+            size_t first_index = 1;
+            llvm::Value* second = llvm::PoisonValue::get(args[0]->getType());
+            if(args.size() < 2) {
+                throw_error(0x0008, std::nullopt, "Vector shuffle expects at least one lane index");
+            }
+            if(type::is_vector(expr.arguments()[1]->get_type())) {
+                second = args[1];
+                first_index = 2;
+            }
+            uint64_t lane_count = vec_type->get_size() * (first_index == 2 ? 2 : 1);
+            std::vector<int> mask;
+            for(size_t n = first_index; n < args.size(); ++n) {
+                auto index = llvm::dyn_cast<llvm::ConstantInt>(args[n]);
+                if(!index || index->getZExtValue() >= lane_count) {
+                    throw_error(0x0009, std::nullopt, "Vector shuffle lane index is out of the shuffled lanes");
+                }
+                mask.push_back(static_cast<int>(index->getZExtValue()));
+            }
+            _value = _builder->CreateShuffleVector(args[0], second, mask);
+            break;
+        }
+        default:
+            _value = nullptr;
+            break;
+    }
+}
+
 void unit_llvm_ir_gen::visit_function_invocation_expression(function_invocation_expression &expr) {
+    if(expr.is_builtin()) {
+        process_vector_builtin(expr);
+        return;
+    }
+
     auto callee = std::dynamic_pointer_cast<symbol_expression>(expr.callee_expr());
     auto member_callee = std::dynamic_pointer_cast<member_of_object_expression>(expr.callee_expr());
 
@@ -2232,21 +2472,42 @@ void unit_llvm_ir_gen::visit_function_invocation_expression(function_invocation_
 
         args.push_back(_value);
     }
-    for(auto arg : expr.arguments()) {
+
+    // Find the function definition
+    auto function = callee->get_function();
+    const auto& params = function->parameters();
+    auto abi_params = get_abi_params(*function);
+    std::vector<std::pair<unsigned int, llvm::Type*>> byval_args;
+
+    for(size_t n = 0; n < expr.arguments().size(); ++n) {
         _value = nullptr;
-        arg->accept(*this);
+        expr.arguments()[n]->accept(*this);
         if(!_value) {
             // Problem with argument generation
             // TODO throw exception
             std::cerr << "Problem with generation of an argument of a function call." << std::endl;
         }
+        if (n < params.size()) {
+            if (const auto& parts = abi_params[n].parts; !parts.empty()) {
+                // Structure passed in registers, pass its coerced parts.
+                auto values = to_abi_values(_value, _context->get_llvm_type(params[n]->get_type()), parts);
+                args.insert(args.end(), values.begin(), values.end());
+                continue;
+            } else if (abi_params[n].in_memory) {
+                // Structure passed in memory, pass a pointer to a copy.
+                auto type = _context->get_llvm_type(params[n]->get_type());
+                auto tmp = create_entry_alloca(type, "byval_tmp");
+                _builder->CreateStore(_value, tmp);
+                byval_args.emplace_back(args.size(), type);
+                args.push_back(tmp);
+                continue;
+            }
+        }
         args.push_back(_value);
     }
 
     // TODO Check function argument count
 
-    // Find the function definition
-    auto function = callee->get_function();
     auto it = _context->_functions.find(function);
     if(it==_context->_functions.end()) {
         // Error: function definition is not found.
@@ -2261,7 +2522,26 @@ void unit_llvm_ir_gen::visit_function_invocation_expression(function_invocation_
     }
     // TODO look for external functions.
 
-    _value = _builder->CreateCall(llvm_func, args);
+    llvm::CallInst* call = _builder->CreateCall(llvm_func, args);
+    call->setCallingConv(llvm_func->getCallingConv());
+    for (const auto& [index, type] : byval_args) {
+        call->addParamAttr(index, llvm::Attribute::getWithByValType(**_context, type));
+        call->addParamAttr(index, llvm::Attribute::getWithAlignment(**_context, llvm::Align(8)));
+    }
+    _value = call;
+
+    if (auto parts = get_abi_coerced_types(function->get_return_type()); !parts.empty()) {
+        // Structure returned in registers, rebuild it from its coerced parts.
+        std::vector<llvm::Value*> values;
+        if (parts.size() == 1) {
+            values.push_back(call);
+        } else {
+            for (unsigned int n = 0; n < parts.size(); ++n) {
+                values.push_back(_builder->CreateExtractValue(call, n));
+            }
+        }
+        _value = from_abi_values(values, _context->get_llvm_type(function->get_return_type()));
+    }
 }
 
 //
@@ -2296,6 +2576,15 @@ void type_reference_resolver::visit_cast_expression(cast_expression& expr) {
         }
     }
 
+    if(auto vec_type = std::dynamic_pointer_cast<vector_type>(target_type); vec_type && source_type != target_type) {
+        // Scalar broadcast: the scalar is first converted to the lane type.
+        auto lane = adapt_type(expr.sub_expr(), vec_type->get_lane_type());
+        if(!lane) {
+            throw_error(0x0011, std::nullopt, "Only scalars of primitive type can be cast to vector");
+        }
+        expr.assign(lane);
+    }
+
     // TODO check if cast is possible (expr.expr().get_type() && expr.get_cast_type() compatibility)
 
     expr.set_type(expr.get_cast_type());
@@ -2312,6 +2601,16 @@ void unit_llvm_ir_gen::visit_cast_expression(cast_expression& expr) {
         std::cerr << "Error: in casting expression, both source and target types must be resolved." << std::endl;
     }
 
+    if(auto vec_type = std::dynamic_pointer_cast<vector_type>(target_type)) {
+        // Broadcast a scalar (already of the lane type) to all the lanes.
+        _value = nullptr;
+        expr.sub_expr()->accept(*this);
+        if(_value && source_type != target_type) {
+            _value = _builder->CreateVectorSplat(vec_type->get_size(), _value);
+        }
+        return;
+    }
+
     if(type::is_pointer(source_type) && type::is_prim_bool(target_type)) {
         // TODO add pointer to boolean casting
     }
@@ -2378,13 +2677,13 @@ void unit_llvm_ir_gen::visit_cast_expression(cast_expression& expr) {
             if(src->is_unsigned()) {
                 if(*tgt == primitive_type::FLOAT) {
                     _value = _builder->CreateUIToFP(_value, _builder->getFloatTy());
-                } else if(*tgt == primitive_type::FLOAT) {
+                } else if(*tgt == primitive_type::DOUBLE) {
                     _value = _builder->CreateUIToFP(_value, _builder->getDoubleTy());
                 } /* else must not happen */
             } else {
                 if(*tgt == primitive_type::FLOAT) {
                     _value = _builder->CreateSIToFP(_value, _builder->getFloatTy());
-                } else if(*tgt == primitive_type::FLOAT) {
+                } else if(*tgt == primitive_type::DOUBLE) {
                     _value = _builder->CreateSIToFP(_value, _builder->getDoubleTy());
                 } /* else must not happen */
             }
@@ -18,6 +18,8 @@
 #include "resolvers.hpp"
 #include "unit_llvm_ir_gen.hpp"
 
+#include "llvm/Analysis/VectorUtils.h"
+
 namespace k::model::gen {
 
 using namespace k::model;
@@ -85,7 +87,21 @@ void unit_llvm_ir_gen::visit_return_statement(return_statement& stmt) {
         expr->accept(*this);
 
         if (_value) {
-            _builder->CreateRet(_value);
+            auto ret_type = stmt.get_function()->get_return_type();
+            if (auto parts = get_abi_coerced_types(ret_type); !parts.empty()) {
+                // Structure returned in registers, return its coerced parts.
+                auto values = to_abi_values(_value, _context->get_llvm_type(ret_type), parts);
+                llvm::Value* ret = values.front();
+                if (values.size() > 1) {
+                    ret = llvm::UndefValue::get(get_abi_return_type(parts));
+                    for (unsigned int n = 0; n < values.size(); ++n) {
+                        ret = _builder->CreateInsertValue(ret, values[n], n);
+                    }
+                }
+                _builder->CreateRet(ret);
+            } else {
+                _builder->CreateRet(_value);
+            }
         } else {
             // TODO Must be an error.
             _builder->CreateRetVoid();
@@ -210,38 +226,7 @@ void type_reference_resolver::visit_while_statement(while_statement& stmt)
 }
 
 void unit_llvm_ir_gen::visit_while_statement(while_statement& stmt) {
-
-    // Retrieve current block and create nested and continue blocks
-    llvm::Function* func = _builder->GetInsertBlock()->getParent();
-    llvm::BasicBlock* while_block = llvm::BasicBlock::Create(**_context, "while-condition");
-    llvm::BasicBlock* nested_block = llvm::BasicBlock::Create(**_context, "while-nested");
-    llvm::BasicBlock* cont_block = llvm::BasicBlock::Create(**_context, "while-continue");
-
-    // While test block
-    _builder->CreateBr(while_block);
-    func->insert(func->end(), while_block);
-    _builder->SetInsertPoint(while_block);
-
-    // Condition expression
-    _value = nullptr;
-    stmt.get_test_expr()->accept(*this);
-    auto test_value = _value;
-    _value = nullptr;
-
-    // Do branching
-    _builder->CreateCondBr(test_value, nested_block, cont_block);
-
-    // Nest block
-    func->insert(func->end(), nested_block);
-    _builder->SetInsertPoint(nested_block);
-    stmt.get_nested_stmt()->accept(*this);
-
-    // Go back to test
-    _builder->CreateBr(while_block);
-
-    // Generate "continuation" block
-    func->insert(func->end(), cont_block);
-    _builder->SetInsertPoint(cont_block);
+    gen_rotated_loop("while", stmt.get_test_expr(), *stmt.get_nested_stmt(), nullptr, stmt.get_hints());
 }
 
 //
@@ -300,58 +285,120 @@ void type_reference_resolver::visit_for_statement(for_statement& stmt)
 }
 
 void unit_llvm_ir_gen::visit_for_statement(for_statement& stmt) {
-
-    // Retrieve current block and create nested and continue blocks
-    llvm::Function* func = _builder->GetInsertBlock()->getParent();
-    llvm::BasicBlock* for_block = llvm::BasicBlock::Create(**_context, "for-condition");
-    llvm::BasicBlock* nested_block = llvm::BasicBlock::Create(**_context, "for-nested");
-    llvm::BasicBlock* cont_block = llvm::BasicBlock::Create(**_context, "for-continue");
-
     // Generate variable decl, if any
     if(auto decl = stmt.get_decl_stmt()) {
         decl->accept(*this);
     }
 
-    // If test block
-    _builder->CreateBr(for_block);
-    func->insert(func->end(), for_block);
-    _builder->SetInsertPoint(for_block);
-
-    // Condition expression
-    if(auto test_expr = stmt.get_test_expr()) {
-        _value = nullptr;
-        stmt.get_test_expr()->accept(*this);
-        auto test_value = _value;
-        _value = nullptr;
+    gen_rotated_loop("for", stmt.get_test_expr(), *stmt.get_nested_stmt(), stmt.get_step_expr(), stmt.get_hints());
+}
 
-        // Do branching
-        _builder->CreateCondBr(test_value, nested_block, cont_block);
-    } else {
-        _builder->CreateBr(nested_block);
+llvm::BranchInst* unit_llvm_ir_gen::gen_loop_branch(const std::shared_ptr<expression>& test_expr, llvm::BasicBlock* nested_block, llvm::BasicBlock* cont_block) {
+    if(!test_expr) {
+        return _builder->CreateBr(nested_block);
     }
 
+    _value = nullptr;
+    test_expr->accept(*this);
+    auto test_value = _value;
+    _value = nullptr;
+
+    return _builder->CreateCondBr(test_value, nested_block, cont_block);
+}
+
+void unit_llvm_ir_gen::gen_rotated_loop(const std::string& name, const std::shared_ptr<expression>& test_expr, statement& nested_stmt,
+                                        const std::shared_ptr<expression>& step_expr, const loop_hints& hints) {
+    // Retrieve current block and create nested and continue blocks
+    llvm::Function* func = _builder->GetInsertBlock()->getParent();
+    llvm::BasicBlock* nested_block = llvm::BasicBlock::Create(**_context, name + "-nested");
+    llvm::BasicBlock* cont_block = llvm::BasicBlock::Create(**_context, name + "-continue");
+
+    // Guard: test once before entering the loop
+    gen_loop_branch(test_expr, nested_block, cont_block);
 
     // Nest block
     func->insert(func->end(), nested_block);
     _builder->SetInsertPoint(nested_block);
-    stmt.get_nested_stmt()->accept(*this);
+    nested_stmt.accept(*this);
 
     // Step, if any
-    if(auto step = stmt.get_step_expr()) {
+    if(step_expr) {
         _value = nullptr;
-        step->accept(*this);
-        auto step_value = _value;
+        step_expr->accept(*this);
         _value = nullptr;
     }
 
-    // Go back to test
-    _builder->CreateBr(for_block);
+    // Latch: test again and loop back
+    auto latch = gen_loop_branch(test_expr, nested_block, cont_block);
+
+    if(!hints.empty()) {
+        llvm::MDNode* access_group = nullptr;
+        if(hints.no_alias) {
+            // All memory accesses of the loop body, including nested loops, are in the loop access group.
+            access_group = llvm::MDNode::getDistinct(**_context, {});
+            for(auto block = nested_block->getIterator(); block != func->end(); ++block) {
+                for(auto& inst : *block) {
+                    if(inst.mayReadOrWriteMemory()) {
+                        inst.setMetadata(llvm::LLVMContext::MD_access_group,
+                                         llvm::uniteAccessGroups(inst.getMetadata(llvm::LLVMContext::MD_access_group), access_group));
+                    }
+                }
+            }
+        }
+        latch->setMetadata(llvm::LLVMContext::MD_loop, make_loop_metadata(hints, access_group));
+    }
 
     // Generate "continuation" block
     func->insert(func->end(), cont_block);
     _builder->SetInsertPoint(cont_block);
 }
 
+llvm::MDNode* unit_llvm_ir_gen::make_loop_metadata(const loop_hints& hints, llvm::MDNode* access_group) {
+    llvm::LLVMContext& ctx = **_context;
+    auto property = [&](const char* name, llvm::Metadata* value = nullptr) -> llvm::Metadata* {
+        llvm::SmallVector<llvm::Metadata*, 2> ops{llvm::MDString::get(ctx, name)};
+        if(value) {
+            ops.push_back(value);
+        }
+        return llvm::MDNode::get(ctx, ops);
+    };
+    auto int_value = [&](unsigned int value) {
+        return llvm::ConstantAsMetadata::get(_builder->getInt32(value));
+    };
+
+    // First operand is the loop identifier itself
+    llvm::SmallVector<llvm::Metadata*, 4> properties{nullptr};
+
+    if(hints.unroll) {
+        if(*hints.unroll == 0) {
+            properties.push_back(property("llvm.loop.unroll.enable"));
+        } else if(*hints.unroll == 1) {
+            properties.push_back(property("llvm.loop.unroll.disable"));
+        } else {
+            properties.push_back(property("llvm.loop.unroll.count", int_value(*hints.unroll)));
+        }
+    }
+
+    if(hints.vectorize) {
+        if(*hints.vectorize == 1) {
+            properties.push_back(property("llvm.loop.vectorize.width", int_value(1)));
+        } else {
+            properties.push_back(property("llvm.loop.vectorize.enable", llvm::ConstantAsMetadata::get(_builder->getTrue())));
+            if(*hints.vectorize > 1) {
+                properties.push_back(property("llvm.loop.vectorize.width", int_value(*hints.vectorize)));
+            }
+        }
+    }
+
+    if(access_group) {
+        properties.push_back(property("llvm.loop.parallel_accesses", access_group));
+    }
+
+    auto loop_id = llvm::MDNode::getDistinct(ctx, properties);
+    loop_id->replaceOperandWith(0, loop_id);
+    return loop_id;
+}
+
 //
 // Expression statement
 //
@@ -430,6 +477,7 @@ void unit_llvm_ir_gen::visit_variable_statement(variable_statement& var) {
     std::shared_ptr<k::model::type> var_type = var.get_type();
     llvm::Type *  type = _context->get_llvm_type(var_type);
     llvm::AllocaInst* alloca = build.CreateAlloca(type, nullptr, var.get_short_name());
+    align_storage(alloca, var_type);
     _context->_variables.insert({var.shared_as<variable_statement>(), alloca});
 
     // But initialize at the decl place
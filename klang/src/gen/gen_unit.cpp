@@ -15,9 +15,12 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include "constant_evaluator.hpp"
 #include "resolvers.hpp"
 #include "unit_llvm_ir_gen.hpp"
 
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/Operator.h>
 #include <llvm/IR/Verifier.h>
 #include <llvm/Transforms/Utils/ModuleUtils.h>
 
@@ -228,9 +231,8 @@ void type_reference_resolver::visit_global_variable_definition(global_variable_d
             // Compatible type, no need to cast.
         }
 
-        if (!std::dynamic_pointer_cast<value_expression>(expr)) {
-            // If variable initialization is not constant
-            // TODO Support casted constant expression (and any other resolvable complex constant init expression)
+        if (!constant_evaluator(_context).evaluate_global_variable(var.shared_as<global_variable_definition>())) {
+            // If variable initialization is not constant, initialize it at runtime
             var.ancestor<unit>()->get_global_constructor_function().add_global_variable_definition(var.shared_as<global_variable_definition>());
         }
 
@@ -245,12 +247,13 @@ void unit_llvm_ir_gen::visit_global_variable_definition(global_variable_definiti
     // Generate initialization
     llvm::Constant* constInitValue = nullptr;
     if(auto initExpr = var.get_init_expr()) {
-        // TODO initialize the variable with the expression
-        if (auto valueExpr = std::dynamic_pointer_cast<value_expression>(initExpr)) {
-            // Constant init expression
-            if (auto constant = get_llvm_constant_from_value_expr(*valueExpr)) {
-                // TODO Implement type conversion
-                constInitValue = constant;
+        auto global_var = var.shared_as<global_variable_definition>();
+        if (!var.ancestor<unit>()->get_global_constructor_function().has_global_variable_definition(global_var)) {
+            // Constant init expression, evaluated at compile time, with the rule the resolver used to tell it constant.
+            constInitValue = constant_evaluator(_context).evaluate_global_variable(global_var);
+            if (!constInitValue || constInitValue->getType() != llvm_type) {
+                throw_error(0x000A, std::nullopt, "Global variable '{}' has no constant initial value of its type",
+                            {var.get_name().to_string()});
             }
         }
     }
@@ -262,6 +265,10 @@ void unit_llvm_ir_gen::visit_global_variable_definition(global_variable_definiti
 
 
     auto variable = new llvm::GlobalVariable(*_context->_module, llvm_type, false, llvm::GlobalValue::ExternalLinkage, constInitValue, var.get_mangled_name());
+    if (uint64_t align = _context->get_alignment(type); align > get_module().getDataLayout().getABITypeAlign(llvm_type).value()) {
+        // Structure with a custom layout, its LLVM type is packed.
+        variable->setAlignment(llvm::Align(align));
+    }
     _context->_global_vars.insert({var.shared_as<global_variable_definition>(), variable});
 }
 
@@ -347,14 +354,29 @@ void unit_llvm_ir_gen::visit_function(function &function) {
         // First parameter is the 'this' pointer
         param_types.push_back(_context->get_llvm_type(function.get_this_parameter()->get_type()));
     }
-    for(const auto& param : function.parameters()) {
-        param_types.push_back(_context->get_llvm_type(param->get_type()));
+    auto abi_params = get_abi_params(function);
+    std::vector<unsigned int> byval_args;
+    for(size_t n = 0; n < function.parameters().size(); ++n) {
+        const auto& param = function.parameters()[n];
+        // Small structures are passed in registers, as one parameter per coerced part.
+        const auto& parts = abi_params[n].parts;
+        if (!parts.empty()) {
+            param_types.insert(param_types.end(), parts.begin(), parts.end());
+        } else if (abi_params[n].in_memory) {
+            // Out of registers, passed in memory.
+            byval_args.push_back(param_types.size());
+            param_types.push_back(llvm::PointerType::get(**_context, 0));
+        } else {
+            param_types.push_back(_context->get_llvm_type(param->get_type()));
+        }
     }
 
     // Return type, if any:
     llvm::Type* ret_type = nullptr;
     if(const auto& ret = function.get_return_type()) {
-        ret_type = _context->get_llvm_type(ret);
+        // Small structures are returned in registers.
+        auto parts = get_abi_coerced_types(ret);
+        ret_type = parts.empty() ? _context->get_llvm_type(ret) : get_abi_return_type(parts);
     } else {
         ret_type = llvm::Type::getVoidTy(**_context);
     }
@@ -365,6 +387,61 @@ void unit_llvm_ir_gen::visit_function(function &function) {
 
     _context->_functions.insert({function.shared_as<k::model::function>(), func});
 
+    for (unsigned int n = 0, p = 0; n < abi_params.size(); ++n) {
+        if (abi_params[n].in_memory) {
+            auto type = _context->get_llvm_type(function.parameters()[n]->get_type());
+            func->addParamAttr(byval_args[p], llvm::Attribute::getWithByValType(**_context, type));
+            func->addParamAttr(byval_args[p++], llvm::Attribute::getWithAlignment(**_context, llvm::Align(8)));
+        }
+    }
+
+    // Function defined by another module, nothing more to generate.
+    if (function.is_declaration_only()) {
+        return;
+    }
+
+    // Functions not reachable from outside the unit can use local linkage and the fast calling convention.
+    if (!function.is_exported()) {
+        func->setLinkage(llvm::GlobalValue::InternalLinkage);
+        func->setCallingConv(llvm::CallingConv::Fast);
+    }
+
+    // Allow target-specific code generation (vectorization width...) for the whole function.
+    if (!_target_cpu.empty()) {
+        func->addFnAttr("target-cpu", _target_cpu);
+    }
+    if (!_target_features.empty()) {
+        func->addFnAttr("target-features", _target_features);
+    }
+
+    // Floating point math relaxations, set on all floating point instructions generated for the function,
+    // and as function attributes for the backend.
+    fast_math_flags fp_flags = function.get_fast_math().value_or(_fast_math);
+    llvm::FastMathFlags fmf;
+    fmf.setAllowReassoc(fp_flags.reassoc);
+    fmf.setAllowContract(fp_flags.contract);
+    fmf.setNoNaNs(fp_flags.nnan);
+    fmf.setNoInfs(fp_flags.ninf);
+    fmf.setNoSignedZeros(fp_flags.nsz);
+    fmf.setAllowReciprocal(fp_flags.arcp);
+    fmf.setApproxFunc(fp_flags.afn);
+    _builder->setFastMathFlags(fmf);
+    if (fp_flags.nnan) {
+        func->addFnAttr("no-nans-fp-math", "true");
+    }
+    if (fp_flags.ninf) {
+        func->addFnAttr("no-infs-fp-math", "true");
+    }
+    if (fp_flags.nsz) {
+        func->addFnAttr("no-signed-zeros-fp-math", "true");
+    }
+    if (fp_flags.afn) {
+        func->addFnAttr("approx-func-fp-math", "true");
+    }
+    if (fp_flags.all()) {
+        func->addFnAttr("unsafe-fp-math", "true");
+    }
+
     // create the function content:
     llvm::BasicBlock *block = llvm::BasicBlock::Create(**_context, "entry", func);
     _builder->SetInsertPoint(block);
@@ -373,32 +450,62 @@ void unit_llvm_ir_gen::visit_function(function &function) {
     auto arg_it = func->arg_begin();
     if (function.is_member() /* TODO and is not static */) {
         // First parameter is the 'this' pointer
+        // It cannot be re-bound, so it is used directly without local storage.
         llvm::Argument *arg = &*(arg_it++);
         arg->setName("this");
-        // Create dedicated local storage for "this" argument
-        llvm::AllocaInst* alloca = _builder->CreateAlloca(llvm::PointerType::get(_context->llvm_context(), 0), nullptr, "this");
-        _context->_function_this_variables.insert({function.shared_as<model::function>(), alloca});
-        _context->_parameter_variables.insert({function.get_this_parameter(), alloca});
-        // Read "this" param value and store it in dedicated local var
-        _builder->CreateStore(arg, alloca);
-    }
-    for(const auto& param : function.parameters()) {
+        _context->_function_this_values.insert({function.shared_as<model::function>(), arg});
+        _context->_parameter_values.insert({function.get_this_parameter(), arg});
+    }
+    for(size_t n = 0; n < function.parameters().size(); ++n) {
         // Iterate to get all explicit parameters
-        llvm::Argument *arg = &*(arg_it++);
-        arg->setName(param->get_short_name());
+        const auto& param = function.parameters()[n];
+        if (type::is_reference(param->get_type())) {
+            // References cannot be re-bound, so they are used directly without local storage.
+            llvm::Argument *arg = &*(arg_it++);
+            arg->setName(param->get_short_name());
+            _context->_parameter_values.insert({param, arg});
+            continue;
+        }
+
         // Create dedicated local storage for argument
         llvm::AllocaInst* alloca = _builder->CreateAlloca(_context->get_llvm_type(param->get_type()), nullptr, param->get_short_name());
+        align_storage(alloca, param->get_type());
         _context->_parameter_variables.insert({param, alloca});
-        // Read param value and store it in dedicated local var
-        _builder->CreateStore(arg, alloca);
+
+        if (const auto& parts = abi_params[n].parts; !parts.empty()) {
+            // Structure passed in registers, store its parts in the local storage.
+            alloca->setAlignment(llvm::Align(std::max<uint64_t>(alloca->getAlign().value(), 8)));
+            std::vector<llvm::Value*> values;
+            for (size_t n = 0; n < parts.size(); ++n) {
+                llvm::Argument *arg = &*(arg_it++);
+                arg->setName(param->get_short_name() + "_" + std::to_string(n));
+                values.push_back(arg);
+            }
+            store_abi_values(alloca, values);
+        } else if (abi_params[n].in_memory) {
+            // Structure passed in memory, copy it in the local storage.
+            llvm::Argument *arg = &*(arg_it++);
+            arg->setName(param->get_short_name());
+            _builder->CreateStore(_builder->CreateAlignedLoad(alloca->getAllocatedType(), arg, llvm::Align(8)), alloca);
+        } else {
+            llvm::Argument *arg = &*(arg_it++);
+            arg->setName(param->get_short_name());
+            // Read param value and store it in dedicated local var
+            _builder->CreateStore(arg, alloca);
+        }
     }
 
     // Produce content
     function.get_block()->accept(*this);
+    _vector_lanes.clear();
 
     // Force adding a return void as last instruction.
     _builder->CreateRetVoid();
 
+    _builder->clearFastMathFlags();
+
+    align_custom_layout_accesses(*func);
+
     // Pre-optimize function
     optimize_function_dead_inst_elimination(*func);
 
@@ -406,6 +513,152 @@ void unit_llvm_ir_gen::visit_function(function &function) {
     llvm::verifyFunction(*func);
 }
 
+std::vector<llvm::Type*> unit_llvm_ir_gen::get_abi_coerced_types(const std::shared_ptr<type>& type) {
+    auto st_type = std::dynamic_pointer_cast<struct_type>(type);
+    if (!_sysv_struct_abi || !st_type || st_type->has_custom_layout()) {
+        // Structures with a custom layout have explicit padding elements, they are passed as is.
+        return {};
+    }
+    auto st = llvm::dyn_cast_or_null<llvm::StructType>(_context->get_llvm_type(type));
+    return struct_abi::get_sysv_coerced_types(st, get_module().getDataLayout());
+}
+
+std::vector<unit_llvm_ir_gen::abi_param> unit_llvm_ir_gen::get_abi_params(function& func) {
+    std::vector<abi_param> res(func.parameters().size());
+    if (!_sysv_struct_abi) {
+        return res;
+    }
+
+    // Remaining general purpose (rdi, rsi, rdx, rcx, r8, r9) and SSE (xmm0-7) argument registers.
+    unsigned int gprs = 6, sses = 8;
+    if (func.is_member()) {
+        // 'this' pointer
+        gprs--;
+    }
+    if (const auto& ret = func.get_return_type(); ret && get_abi_coerced_types(ret).empty()) {
+        auto ret_type = _context->get_llvm_type(ret);
+        if (ret_type->isStructTy() && get_module().getDataLayout().getTypeAllocSize(ret_type) > 16) {
+            // Hidden pointer to the returned structure
+            gprs--;
+        }
+    }
+
+    for (size_t n = 0; n < res.size(); ++n) {
+        const auto& param_type = func.parameters()[n]->get_type();
+        auto parts = get_abi_coerced_types(param_type);
+        unsigned int gpr_count = 0, sse_count = 0;
+        if (!parts.empty()) {
+            for (auto part : parts) {
+                (part->isIntegerTy() ? gpr_count : sse_count)++;
+            }
+        } else {
+            auto type = _context->get_llvm_type(param_type);
+            if (type->isPointerTy()) {
+                gpr_count = 1;
+            } else if (type->isIntegerTy()) {
+                gpr_count = type->getIntegerBitWidth() > 64 ? 2 : 1;
+            } else if (type->isFloatTy() || type->isDoubleTy() || type->isVectorTy()) {
+                sse_count = 1;
+            }
+        }
+        if (gpr_count > gprs || sse_count > sses) {
+            // Not enough registers left for the whole value, passed on the stack.
+            res[n].in_memory = !parts.empty();
+            continue;
+        }
+        gprs -= gpr_count;
+        sses -= sse_count;
+        res[n].parts = std::move(parts);
+    }
+    return res;
+}
+
+void unit_llvm_ir_gen::align_storage(llvm::AllocaInst* alloca, const std::shared_ptr<type>& type) {
+    uint64_t align = _context->get_alignment(type);
+    if (align > alloca->getAlign().value()) {
+        alloca->setAlignment(llvm::Align(align));
+    }
+}
+
+std::optional<llvm::Align> unit_llvm_ir_gen::get_custom_layout_alignment(llvm::Value* ptr) {
+    auto gep = llvm::dyn_cast<llvm::GEPOperator>(ptr);
+    if (!gep) {
+        return std::nullopt;
+    }
+    auto base_align = get_custom_layout_alignment(gep->getPointerOperand());
+    if (!base_align) {
+        auto st = llvm::dyn_cast<llvm::StructType>(gep->getSourceElementType());
+        if (!st || !st->isPacked()) {
+            return std::nullopt;
+        }
+        auto st_type = _context->get_struct_type(st);
+        if (!st_type) {
+            return llvm::Align(1);
+        }
+        base_align = llvm::Align(st_type->get_alignment());
+    }
+    const auto& layout = get_module().getDataLayout();
+    llvm::APInt offset(layout.getIndexTypeSizeInBits(gep->getType()), 0);
+    if (!gep->accumulateConstantOffset(layout, offset)) {
+        return llvm::Align(1);
+    }
+    return llvm::commonAlignment(*base_align, offset.getZExtValue());
+}
+
+void unit_llvm_ir_gen::align_custom_layout_accesses(llvm::Function& func) {
+    for (auto& inst : llvm::instructions(func)) {
+        if (auto load = llvm::dyn_cast<llvm::LoadInst>(&inst)) {
+            if (auto align = get_custom_layout_alignment(load->getPointerOperand()); align && *align < load->getAlign()) {
+                load->setAlignment(*align);
+            }
+        } else if (auto store = llvm::dyn_cast<llvm::StoreInst>(&inst)) {
+            if (auto align = get_custom_layout_alignment(store->getPointerOperand()); align && *align < store->getAlign()) {
+                store->setAlignment(*align);
+            }
+        }
+    }
+}
+
+llvm::Type* unit_llvm_ir_gen::get_abi_return_type(const std::vector<llvm::Type*>& parts) {
+    if (parts.size() == 1) {
+        return parts.front();
+    }
+    return llvm::StructType::get(**_context, parts);
+}
+
+llvm::AllocaInst* unit_llvm_ir_gen::create_entry_alloca(llvm::Type* type, const std::string& name) {
+    auto& entry = _builder->GetInsertBlock()->getParent()->getEntryBlock();
+    llvm::IRBuilder<> build(&entry, entry.begin());
+    llvm::AllocaInst* alloca = build.CreateAlloca(type, nullptr, name);
+    // Coerced parts are accessed by eightbytes.
+    alloca->setAlignment(llvm::Align(std::max<uint64_t>(alloca->getAlign().value(), 8)));
+    return alloca;
+}
+
+void unit_llvm_ir_gen::store_abi_values(llvm::Value* ptr, const std::vector<llvm::Value*>& values) {
+    for (size_t n = 0; n < values.size(); ++n) {
+        auto part_ptr = n == 0 ? ptr : _builder->CreateConstInBoundsGEP1_64(llvm::Type::getInt8Ty(**_context), ptr, n * 8);
+        _builder->CreateAlignedStore(values[n], part_ptr, llvm::Align(8));
+    }
+}
+
+std::vector<llvm::Value*> unit_llvm_ir_gen::to_abi_values(llvm::Value* value, llvm::Type* type, const std::vector<llvm::Type*>& parts) {
+    auto tmp = create_entry_alloca(type, "abi_tmp");
+    _builder->CreateStore(value, tmp);
+    std::vector<llvm::Value*> values;
+    for (size_t n = 0; n < parts.size(); ++n) {
+        auto part_ptr = n == 0 ? tmp : _builder->CreateConstInBoundsGEP1_64(llvm::Type::getInt8Ty(**_context), tmp, n * 8);
+        values.push_back(_builder->CreateAlignedLoad(parts[n], part_ptr, llvm::Align(8)));
+    }
+    return values;
+}
+
+llvm::Value* unit_llvm_ir_gen::from_abi_values(const std::vector<llvm::Value*>& values, llvm::Type* type) {
+    auto tmp = create_entry_alloca(type, "abi_tmp");
+    store_abi_values(tmp, values);
+    return _builder->CreateLoad(type, tmp);
+}
+
 void unit_llvm_ir_gen::optimize_function_dead_inst_elimination(llvm::Function& func) {
     for(auto& block : func) {
         llvm::BasicBlock *bb;
@@ -458,6 +711,9 @@ void unit_llvm_ir_gen::visit_global_constructor_function(global_constructor_func
             std::cerr << "Cannot find the global constructor function, something wrong occured." << std::endl;
         }
 
+        // Only reachable through llvm.global_ctors, keep it local so modules of several units can be linked together.
+        it_func->second->setLinkage(llvm::GlobalValue::InternalLinkage);
+
         // Register the function
         llvm::appendToGlobalCtors(get_module(), it_func->second, 65535);
     }
@@ -0,0 +1,403 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit_indirection.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/MDBuilder.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+#include "unit_llvm_ir_gen.hpp"
+
+namespace k::model::gen {
+
+namespace {
+
+/** Name of the host function called by instrumented code. */
+const char* tier_up_function_name = "__klang_tier_up";
+
+/**
+ * Functions instrumented by all jit_indirection instances, by identifier.
+ * Instrumented code only knows function identifiers, which must not depend on the instance, so modules stay
+ * cacheable.
+ */
+struct function_registry {
+    std::mutex mutex;
+    std::unordered_map<uint64_t, std::pair<jit_indirection*, size_t>> functions;
+    uint64_t next_id = 0;
+};
+
+function_registry& registry() {
+    static function_registry reg;
+    return reg;
+}
+
+/**
+ * Keep only the definitions of some functions and of the local functions and constants they may use.
+ * Everything else becomes declarations, resolved to the definitions of previously added modules.
+ */
+void keep_definitions(llvm::Module& module, const std::vector<llvm::Function*>& functions) {
+    for (const char* name : {"llvm.global_ctors", "llvm.global_dtors"}) {
+        if (auto* global = module.getNamedGlobal(name)) {
+            global->eraseFromParent();
+        }
+    }
+    for (auto& func : module) {
+        if (!func.isDeclaration() && !func.hasLocalLinkage() && std::find(functions.begin(), functions.end(), &func) == functions.end()) {
+            func.deleteBody();
+        }
+    }
+    for (auto& global : module.globals()) {
+        if (!global.isDeclaration() && !(global.hasLocalLinkage() && global.isConstant())) {
+            global.setInitializer(nullptr);
+            global.setLinkage(llvm::GlobalValue::ExternalLinkage);
+        }
+    }
+}
+
+} // anonymous namespace
+
+jit_indirection::jit_indirection(llvm::orc::LLJIT& lljit, llvm::orc::JITDylib& dylib, llvm::orc::JITTargetMachineBuilder target_builder,
+                                 unsigned int threshold, optimization_level level, optimization_level initial_level) :
+        _lljit(lljit),
+        _dylib(dylib),
+        _target_builder(std::move(target_builder)),
+        _threshold(threshold),
+        _level(level),
+        _initial_level(initial_level),
+        _stubs(llvm::orc::createLocalIndirectStubsManagerBuilder(lljit.getTargetTriple())())
+{
+    llvm::orc::SymbolMap symbols;
+    symbols[_lljit.mangleAndIntern(tier_up_function_name)] = llvm::orc::ExecutorSymbolDef(
+            llvm::orc::ExecutorAddr::fromPtr(&jit_indirection::tier_up_entry),
+            llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable);
+    llvm::cantFail(_dylib.define(llvm::orc::absoluteSymbols(std::move(symbols))));
+
+    if (_threshold > 0) {
+        _worker = std::thread(&jit_indirection::run, this);
+    }
+}
+
+jit_indirection::~jit_indirection() {
+    {
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        for (const auto& function : _functions) {
+            registry().functions.erase(function.id);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+        _queue.clear();
+    }
+    _work_available.notify_all();
+    if (_worker.joinable()) {
+        _worker.join();
+    }
+}
+
+void jit_indirection::tier_up_entry(uint64_t id) {
+    jit_indirection* indirection = nullptr;
+    size_t index;
+    {
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        auto it = registry().functions.find(id);
+        if (it == registry().functions.end()) {
+            return;
+        }
+        std::tie(indirection, index) = it->second;
+    }
+    indirection->request_tier_up(index);
+}
+
+void jit_indirection::request_tier_up(size_t index) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_stopping) {
+            return;
+        }
+        _queue.push_back(index);
+    }
+    _work_available.notify_one();
+}
+
+void jit_indirection::wait() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _idle.wait(lock, [this]{ return _queue.empty() && !_busy; });
+}
+
+void jit_indirection::run() {
+    while (true) {
+        size_t index;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _busy = false;
+            if (_queue.empty()) {
+                _idle.notify_all();
+            }
+            _work_available.wait(lock, [this]{ return _stopping || !_queue.empty(); });
+            if (_stopping) {
+                return;
+            }
+            index = _queue.front();
+            _queue.pop_front();
+            _busy = true;
+        }
+
+        if (auto err = tier_up(index)) {
+            std::cerr << "Cannot re-optimize function: " << llvm::toString(std::move(err)) << std::endl;
+        }
+    }
+}
+
+std::vector<std::string> jit_indirection::instrument(llvm::Module& module, size_t module_index) {
+    llvm::LLVMContext& ctx = module.getContext();
+    llvm::Type* i32 = llvm::Type::getInt32Ty(ctx);
+    llvm::Type* i64 = llvm::Type::getInt64Ty(ctx);
+    llvm::FunctionCallee tier_up_function;
+    if (_threshold > 0) {
+        tier_up_function = module.getOrInsertFunction(tier_up_function_name, llvm::FunctionType::get(llvm::Type::getVoidTy(ctx), {i64}, false));
+    }
+
+    std::vector<llvm::Function*> functions;
+    for (auto& func : module) {
+        if (!func.isDeclaration() && func.hasExternalLinkage()) {
+            functions.push_back(&func);
+        }
+    }
+
+    std::vector<std::string> names;
+    for (auto* func : functions) {
+        std::string name = func->getName().str();
+        uint64_t id;
+        {
+            std::lock_guard<std::mutex> lock(registry().mutex);
+            id = registry().next_id++;
+            registry().functions[id] = {this, _functions.size()};
+        }
+        _function_indexes[name] = _functions.size();
+        _functions.push_back({name, module_index, id});
+        names.push_back(name);
+
+        // Every call, including recursive ones, goes through the stub bearing the original name.
+        func->setName(name + "$tier0");
+        auto* stub = llvm::Function::Create(func->getFunctionType(), llvm::GlobalValue::ExternalLinkage, name, module);
+        stub->setCallingConv(func->getCallingConv());
+        func->replaceAllUsesWith(stub);
+
+        if (_threshold == 0) {
+            continue;
+        }
+
+        // Count entries after allocas, so they stay static.
+        auto* counter = new llvm::GlobalVariable(module, i32, false, llvm::GlobalValue::InternalLinkage,
+                                                 llvm::ConstantInt::get(i32, 0), name + "$count");
+        llvm::BasicBlock& entry = func->getEntryBlock();
+        auto it = entry.begin();
+        while (llvm::isa<llvm::AllocaInst>(*it)) {
+            ++it;
+        }
+        llvm::BasicBlock* body = entry.splitBasicBlock(it, "tier0.body");
+        entry.getTerminator()->eraseFromParent();
+        llvm::BasicBlock* hot = llvm::BasicBlock::Create(ctx, "tier0.hot", func, body);
+
+        llvm::IRBuilder<> builder(&entry);
+        auto* count = builder.CreateAtomicRMW(llvm::AtomicRMWInst::Add, counter, llvm::ConstantInt::get(i32, 1),
+                                              llvm::MaybeAlign(4), llvm::AtomicOrdering::Monotonic);
+        // Only the call reaching the threshold requests the re-optimization.
+        auto* reached = builder.CreateICmpEQ(count, llvm::ConstantInt::get(i32, _threshold - 1));
+        builder.CreateCondBr(reached, hot, body, llvm::MDBuilder(ctx).createBranchWeights(1, _threshold));
+
+        builder.SetInsertPoint(hot);
+        builder.CreateCall(tier_up_function, {llvm::ConstantInt::get(i64, id)});
+        builder.CreateBr(body);
+    }
+    return names;
+}
+
+llvm::Error jit_indirection::add_module(llvm::orc::ThreadSafeModule module, llvm::orc::ResourceTrackerSP tracker) {
+    std::vector<std::string> names;
+    module.withModuleDo([&](llvm::Module& mod) {
+        // Mutable internal globals must be visible from re-optimized modules.
+        for (auto& global : mod.globals()) {
+            if (global.hasLocalLinkage() && !global.isConstant()) {
+                global.setLinkage(llvm::GlobalValue::ExternalLinkage);
+                global.setVisibility(llvm::GlobalValue::HiddenVisibility);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        size_t module_index = _modules.size();
+        llvm::raw_svector_ostream stream(_modules.emplace_back());
+        llvm::WriteBitcodeToFile(mod, stream);
+
+        names = instrument(mod, module_index);
+    });
+    if (auto err = optimize(module, _initial_level)) {
+        return err;
+    }
+
+    // Stubs are created pointing nowhere, they are updated once tier 0 implementations are compiled.
+    llvm::orc::IndirectStubsManager::StubInitsMap inits;
+    for (const auto& name : names) {
+        inits[name] = {llvm::orc::ExecutorAddr(), llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable};
+    }
+    if (auto err = _stubs->createStubs(inits)) {
+        return err;
+    }
+
+    llvm::orc::SymbolMap stubs;
+    std::vector<std::pair<size_t, std::string>> implementations;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (const auto& name : names) {
+            stubs[_lljit.mangleAndIntern(name)] = _stubs->findStub(name, false);
+            implementations.emplace_back(_function_indexes[name], name + "$tier0");
+        }
+    }
+    if (auto err = _dylib.define(llvm::orc::absoluteSymbols(std::move(stubs)))) {
+        return err;
+    }
+
+    return redirect(std::move(module), implementations, false, std::move(tracker));
+}
+
+llvm::Error jit_indirection::tier_up(size_t index) {
+    function_entry function;
+    llvm::SmallVector<char, 0> bitcode;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        function = _functions[index];
+        if (function.reloaded) {
+            return llvm::Error::success();
+        }
+        bitcode = _modules[function.module];
+    }
+
+    auto context = std::make_unique<llvm::LLVMContext>();
+    auto loaded = llvm::parseBitcodeFile(llvm::MemoryBufferRef(llvm::StringRef(bitcode.data(), bitcode.size()), function.name), *context);
+    if (!loaded) {
+        return loaded.takeError();
+    }
+    std::unique_ptr<llvm::Module> module = std::move(*loaded);
+
+    llvm::Function* func = module->getFunction(function.name);
+    if (!func) {
+        return llvm::make_error<llvm::StringError>("function '" + function.name + "' not found in its module", llvm::inconvertibleErrorCode());
+    }
+    keep_definitions(*module, {func});
+    // Recursive calls stay direct in the optimized implementation.
+    std::string implementation = function.name + "$tier1";
+    func->setName(implementation);
+
+    llvm::orc::ThreadSafeModule optimized(std::move(module), std::move(context));
+    if (auto err = optimize(optimized, _level)) {
+        return err;
+    }
+
+    if (auto err = redirect(std::move(optimized), {{index, implementation}}, true)) {
+        return err;
+    }
+    ++_tiered_up;
+    return llvm::Error::success();
+}
+
+llvm::Error jit_indirection::reload(llvm::orc::ThreadSafeModule module, const std::vector<std::string>& names) {
+    std::vector<std::pair<size_t, std::string>> functions;
+    auto err = module.withModuleDo([&](llvm::Module& mod) -> llvm::Error {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::string suffix = "$reload" + std::to_string(++_reloads);
+        std::vector<llvm::Function*> kept;
+        for (const auto& name : names) {
+            auto it = _function_indexes.find(name);
+            if (it == _function_indexes.end()) {
+                return llvm::make_error<llvm::StringError>("function '" + name + "' is not reloadable", llvm::inconvertibleErrorCode());
+            }
+            llvm::Function* func = mod.getFunction(name);
+            if (!func || func->isDeclaration()) {
+                return llvm::make_error<llvm::StringError>("function '" + name + "' is not defined by the new module", llvm::inconvertibleErrorCode());
+            }
+            kept.push_back(func);
+            functions.emplace_back(it->second, name + suffix);
+        }
+
+        keep_definitions(mod, kept);
+        for (size_t n = 0; n < kept.size(); ++n) {
+            kept[n]->setName(functions[n].second);
+            _functions[functions[n].first].reloaded = true;
+        }
+        return llvm::Error::success();
+    });
+    if (err) {
+        return err;
+    }
+    // Reloaded functions are never re-optimized, so they get the tier-up level in tiered mode.
+    if (auto err = optimize(module, _threshold > 0 ? _level : _initial_level)) {
+        return err;
+    }
+    return redirect(std::move(module), functions, false);
+}
+
+llvm::Error jit_indirection::optimize(llvm::orc::ThreadSafeModule& module, optimization_level level) {
+    if (level == optimization_level::O0) {
+        return llvm::Error::success();
+    }
+    auto target = _target_builder.createTargetMachine();
+    if (!target) {
+        return target.takeError();
+    }
+    module.withModuleDo([&](llvm::Module& mod) {
+        unit_llvm_ir_gen::optimize_module(mod, level, target->get());
+    });
+    return llvm::Error::success();
+}
+
+llvm::Error jit_indirection::redirect(llvm::orc::ThreadSafeModule module, const std::vector<std::pair<size_t, std::string>>& functions,
+                                      bool skip_reloaded, llvm::orc::ResourceTrackerSP tracker) {
+    if (auto err = tracker ? _lljit.addIRModule(std::move(tracker), std::move(module)) : _lljit.addIRModule(_dylib, std::move(module))) {
+        return err;
+    }
+
+    llvm::orc::SymbolLookupSet implementations;
+    for (const auto& function : functions) {
+        implementations.add(_lljit.mangleAndIntern(function.second));
+    }
+    auto symbols = _lljit.getExecutionSession().lookup(llvm::orc::makeJITDylibSearchOrder(&_dylib), std::move(implementations));
+    if (!symbols) {
+        return symbols.takeError();
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (const auto& [index, implementation] : functions) {
+        if (skip_reloaded && _functions[index].reloaded) {
+            continue;
+        }
+        if (auto err = _stubs->updatePointer(_functions[index].name, (*symbols)[_lljit.mangleAndIntern(implementation)].getAddress())) {
+            return err;
+        }
+    }
+    return llvm::Error::success();
+}
+
+} // k::model::gen
@@ -0,0 +1,177 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef KLANG_JIT_INDIRECTION_HPP
+#define KLANG_JIT_INDIRECTION_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ExecutionEngine/Orc/IndirectionUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+
+#include "../compiler.hpp"
+
+namespace k::model::gen {
+
+/**
+ * Calls to the exported functions of JIT modules, through indirect stubs.
+ *
+ * Each exported function of an added module is renamed (its "tier 0" implementation) and its original symbol
+ * is defined as an indirect stub pointing to it. Calls from the host and from JIT code, including recursive calls,
+ * go through the stub, so the implementation can be swapped at any time by updating the stub pointer.
+ *
+ * Tier 0 implementations are instrumented with an entry counter. When a counter reaches the tier-up threshold,
+ * the function is re-optimized on a background thread from a copy of its original module, then its stub is
+ * redirected to the optimized implementation. Other exported functions are called through their stubs and
+ * global variables are shared with the tier 0 module.
+ *
+ * Functions can also be replaced by new implementations (hot reloading), generated from a new version of their
+ * module: the same way, only the replaced functions are kept from the new module and their stubs are redirected.
+ */
+class jit_indirection {
+protected:
+    struct function_entry {
+        /** Symbol name of the function, the one of its stub. */
+        std::string name;
+        /** Index of the bitcode of the module defining the function in _modules. */
+        size_t module;
+        /** Identifier passed by instrumented code, unique in the process. */
+        uint64_t id;
+        /** The function was replaced, its tier 0 implementation must not be re-optimized anymore. */
+        bool reloaded = false;
+    };
+
+    llvm::orc::LLJIT& _lljit;
+    llvm::orc::JITDylib& _dylib;
+    llvm::orc::JITTargetMachineBuilder _target_builder;
+    unsigned int _threshold;
+    optimization_level _level;
+    /** Optimization level of added modules and reloaded functions, applied once calls go through stubs. */
+    optimization_level _initial_level;
+
+    std::unique_ptr<llvm::orc::IndirectStubsManager> _stubs;
+
+    /** Bitcode of original modules, before instrumentation. */
+    std::vector<llvm::SmallVector<char, 0>> _modules;
+    std::vector<function_entry> _functions;
+    /** Indexes in _functions, by function name. */
+    std::unordered_map<std::string, size_t> _function_indexes;
+    /** Number of reloads, to name new implementations uniquely. */
+    size_t _reloads = 0;
+
+    /** Indexes in _functions of functions to re-optimize. */
+    std::deque<size_t> _queue;
+    bool _busy = false;
+    bool _stopping = false;
+    std::mutex _mutex;
+    std::condition_variable _work_available;
+    std::condition_variable _idle;
+    std::thread _worker;
+
+    std::atomic<size_t> _tiered_up = 0;
+
+    /**
+     * Entry point called by instrumented code when an entry counter reaches the threshold.
+     */
+    static void tier_up_entry(uint64_t id);
+
+    void request_tier_up(size_t index);
+    void run();
+    llvm::Error tier_up(size_t index);
+
+    /**
+     * Add a module defining new implementations of functions and redirect their stubs to them.
+     * Other definitions of the module are turned into declarations, resolved to the existing ones.
+     * @param module Module, whose function definitions are already renamed to their implementation names.
+     * @param functions Indexes in _functions of redirected functions, with their implementation names.
+     * @param skip_reloaded Do not redirect functions replaced in the meantime.
+     * @param tracker Resource tracker of the module, null for the default one of the JITDylib.
+     */
+    llvm::Error redirect(llvm::orc::ThreadSafeModule module, const std::vector<std::pair<size_t, std::string>>& functions,
+                         bool skip_reloaded, llvm::orc::ResourceTrackerSP tracker = nullptr);
+
+    /**
+     * Optimize a module, with its own target machine as it may run on the re-optimization thread.
+     */
+    llvm::Error optimize(llvm::orc::ThreadSafeModule& module, optimization_level level);
+
+    /**
+     * Rename exported functions, instrument them and collect their names.
+     */
+    std::vector<std::string> instrument(llvm::Module& module, size_t module_index);
+
+public:
+    /**
+     * @param lljit JIT instance, must outlive this object.
+     * @param dylib JITDylib where modules are added and stubs are defined.
+     * @param target_builder Builder of target machines used for re-optimization.
+     * @param threshold Number of calls of a function before it is re-optimized, 0 to never re-optimize.
+     * @param level Optimization level of re-optimized functions.
+     * @param initial_level Optimization level of added modules (tier 0) and of reloaded functions, O0 for none.
+     * Modules are optimized after calls to their exported functions are redirected to stubs, so these functions
+     * are neither inlined nor constant-propagated into their callers and can still be replaced.
+     */
+    jit_indirection(llvm::orc::LLJIT& lljit, llvm::orc::JITDylib& dylib, llvm::orc::JITTargetMachineBuilder target_builder,
+                    unsigned int threshold, optimization_level level, optimization_level initial_level = optimization_level::O0);
+    ~jit_indirection();
+
+    jit_indirection(const jit_indirection&) = delete;
+    jit_indirection& operator=(const jit_indirection&) = delete;
+
+    /**
+     * Add a module, calling its exported functions through stubs.
+     * The module must not be optimized yet, it is optimized at the initial level once instrumented.
+     * The module is compiled immediately, to initialize the stubs.
+     * @param tracker Resource tracker to add the module with, null for the default one of the JITDylib.
+     * Stubs are not removed with the module, so the module cannot be added again.
+     */
+    llvm::Error add_module(llvm::orc::ThreadSafeModule module, llvm::orc::ResourceTrackerSP tracker = nullptr);
+
+    /**
+     * Replace functions by their implementation in a new version of their module.
+     * Global variables and other functions stay in place, with their state.
+     * @param module New version of the module, compiled for the same target and not optimized yet.
+     * @param names Symbol names of the functions to replace, they must be exported functions of previously added modules.
+     */
+    llvm::Error reload(llvm::orc::ThreadSafeModule module, const std::vector<std::string>& names);
+
+    /**
+     * Block until all requested re-optimizations are done.
+     */
+    void wait();
+
+    /**
+     * Number of functions re-optimized so far.
+     */
+    size_t get_tiered_up_count() const {
+        return _tiered_up;
+    }
+};
+
+} // k::model::gen
+
+#endif //KLANG_JIT_INDIRECTION_HPP
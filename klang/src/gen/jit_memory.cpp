@@ -0,0 +1,256 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit_memory.hpp"
+
+#include <llvm/ExecutionEngine/JITLink/JITLink.h>
+#include <llvm/ExecutionEngine/Orc/MapperJITLinkMemoryManager.h>
+#include <llvm/ExecutionEngine/Orc/MemoryMapper.h>
+#include <llvm/ExecutionEngine/SectionMemoryManager.h>
+#include <llvm/Support/Process.h>
+
+#include <map>
+
+namespace k::model::gen {
+
+//
+// Memory usage
+//
+
+jit_memory_usage& jit_memory_usage::operator+=(const jit_memory_usage& other) {
+    code += other.code;
+    rodata += other.rodata;
+    data += other.data;
+    return *this;
+}
+
+jit_memory_usage& jit_memory_usage::operator-=(const jit_memory_usage& other) {
+    code -= other.code;
+    rodata -= other.rodata;
+    data -= other.data;
+    return *this;
+}
+
+//
+// Memory accounting
+//
+
+jit_memory_accounting::jit_memory_accounting(uint64_t limit) :
+        _limit(limit)
+{}
+
+bool jit_memory_accounting::reserve(const jit_memory_usage& usage) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_limit > 0 && _usage.total() + usage.total() > _limit) {
+        return false;
+    }
+    _usage += usage;
+    return true;
+}
+
+void jit_memory_accounting::add(const jit_memory_usage& usage) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _usage += usage;
+}
+
+void jit_memory_accounting::release(const jit_memory_usage& usage) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _usage -= usage;
+}
+
+jit_memory_usage jit_memory_accounting::get_usage() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _usage;
+}
+
+namespace {
+
+//
+// JITLink memory manager
+//
+
+/**
+ * Memory needed by the sections of a link graph, before allocation.
+ */
+jit_memory_usage graph_memory_usage(llvm::jitlink::LinkGraph& graph) {
+    jit_memory_usage usage;
+    for (auto& section : graph.sections()) {
+        if (section.getMemLifetimePolicy() == llvm::orc::MemLifetimePolicy::NoAlloc) {
+            continue;
+        }
+        uint64_t size = 0;
+        for (auto* block : section.blocks()) {
+            size += block->getSize();
+        }
+        auto protection = section.getMemProt();
+        if ((protection & llvm::orc::MemProt::Exec) != llvm::orc::MemProt::None) {
+            usage.code += size;
+        } else if ((protection & llvm::orc::MemProt::Write) != llvm::orc::MemProt::None) {
+            usage.data += size;
+        } else {
+            usage.rodata += size;
+        }
+    }
+    return usage;
+}
+
+class accounted_jitlink_memory_manager : public llvm::jitlink::JITLinkMemoryManager {
+protected:
+    std::unique_ptr<llvm::jitlink::JITLinkMemoryManager> _manager;
+    std::shared_ptr<jit_memory_accounting> _accounting;
+
+    /** Memory of finalized allocations, by allocation address, released when they are deallocated. */
+    std::mutex _mutex;
+    std::map<llvm::orc::ExecutorAddr, jit_memory_usage> _allocations;
+
+    class in_flight_alloc : public InFlightAlloc {
+    protected:
+        accounted_jitlink_memory_manager& _manager;
+        std::unique_ptr<InFlightAlloc> _alloc;
+        jit_memory_usage _usage;
+
+    public:
+        in_flight_alloc(accounted_jitlink_memory_manager& manager, std::unique_ptr<InFlightAlloc> alloc, const jit_memory_usage& usage) :
+                _manager(manager), _alloc(std::move(alloc)), _usage(usage) {
+        }
+
+        void abandon(OnAbandonedFunction on_abandoned) override {
+            _manager._accounting->release(_usage);
+            _alloc->abandon(std::move(on_abandoned));
+        }
+
+        void finalize(OnFinalizedFunction on_finalized) override {
+            // The in-flight allocation may be destroyed before the finalization completes.
+            auto& manager = _manager;
+            _alloc->finalize([&manager, usage = _usage, on_finalized = std::move(on_finalized)](llvm::Expected<FinalizedAlloc> alloc) mutable {
+                if (alloc) {
+                    std::lock_guard<std::mutex> lock(manager._mutex);
+                    manager._allocations[alloc->getAddress()] = usage;
+                } else {
+                    manager._accounting->release(usage);
+                }
+                on_finalized(std::move(alloc));
+            });
+        }
+    };
+
+public:
+    accounted_jitlink_memory_manager(std::unique_ptr<llvm::jitlink::JITLinkMemoryManager> manager, std::shared_ptr<jit_memory_accounting> accounting) :
+            _manager(std::move(manager)), _accounting(std::move(accounting)) {
+    }
+
+    using JITLinkMemoryManager::allocate;
+    using JITLinkMemoryManager::deallocate;
+
+    void allocate(const llvm::jitlink::JITLinkDylib* library, llvm::jitlink::LinkGraph& graph, OnAllocatedFunction on_allocated) override {
+        jit_memory_usage usage = graph_memory_usage(graph);
+        if (!_accounting->reserve(usage)) {
+            on_allocated(llvm::make_error<llvm::StringError>(
+                    "JIT memory limit exceeded: " + std::to_string(usage.total()) + " bytes needed by '" + graph.getName()
+                    + "', " + std::to_string(_accounting->get_usage().total()) + " of " + std::to_string(_accounting->get_limit())
+                    + " bytes used", llvm::inconvertibleErrorCode()));
+            return;
+        }
+        _manager->allocate(library, graph, [this, usage, on_allocated = std::move(on_allocated)](AllocResult alloc) mutable {
+            if (!alloc) {
+                _accounting->release(usage);
+                on_allocated(alloc.takeError());
+                return;
+            }
+            on_allocated(std::make_unique<in_flight_alloc>(*this, std::move(*alloc), usage));
+        });
+    }
+
+    void deallocate(std::vector<FinalizedAlloc> allocs, OnDeallocatedFunction on_deallocated) override {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (const auto& alloc : allocs) {
+                auto it = _allocations.find(alloc.getAddress());
+                if (it != _allocations.end()) {
+                    _accounting->release(it->second);
+                    _allocations.erase(it);
+                }
+            }
+        }
+        _manager->deallocate(std::move(allocs), std::move(on_deallocated));
+    }
+};
+
+//
+// RuntimeDyld memory manager
+//
+
+class accounted_section_memory_manager : public llvm::SectionMemoryManager {
+protected:
+    std::shared_ptr<jit_memory_accounting> _accounting;
+    jit_memory_usage _usage;
+
+    void account(const jit_memory_usage& usage) {
+        _accounting->add(usage);
+        _usage += usage;
+    }
+
+public:
+    explicit accounted_section_memory_manager(std::shared_ptr<jit_memory_accounting> accounting) :
+            _accounting(std::move(accounting)) {
+    }
+
+    ~accounted_section_memory_manager() override {
+        _accounting->release(_usage);
+    }
+
+    uint8_t* allocateCodeSection(uintptr_t size, unsigned alignment, unsigned section_id, llvm::StringRef section_name) override {
+        account({.code = size});
+        return SectionMemoryManager::allocateCodeSection(size, alignment, section_id, section_name);
+    }
+
+    uint8_t* allocateDataSection(uintptr_t size, unsigned alignment, unsigned section_id, llvm::StringRef section_name, bool read_only) override {
+        account(read_only ? jit_memory_usage{.rodata = size} : jit_memory_usage{.data = size});
+        return SectionMemoryManager::allocateDataSection(size, alignment, section_id, section_name, read_only);
+    }
+};
+
+} // anonymous namespace
+
+llvm::Expected<std::unique_ptr<llvm::jitlink::JITLinkMemoryManager>>
+jit_memory_accounting::create_jitlink_memory_manager(std::shared_ptr<jit_memory_accounting> accounting, uint64_t slab_size) {
+    std::unique_ptr<llvm::jitlink::JITLinkMemoryManager> manager;
+    if (slab_size > 0) {
+        uint64_t page_size = llvm::sys::Process::getPageSizeEstimate();
+        auto slab_manager = llvm::orc::MapperJITLinkMemoryManager::CreateWithMapper<llvm::orc::InProcessMemoryMapper>(
+                llvm::alignTo(slab_size, page_size));
+        if (!slab_manager) {
+            return slab_manager.takeError();
+        }
+        manager = std::move(*slab_manager);
+    } else {
+        auto process_manager = llvm::jitlink::InProcessMemoryManager::Create();
+        if (!process_manager) {
+            return process_manager.takeError();
+        }
+        manager = std::move(*process_manager);
+    }
+    return std::make_unique<accounted_jitlink_memory_manager>(std::move(manager), std::move(accounting));
+}
+
+std::unique_ptr<llvm::RuntimeDyld::MemoryManager>
+jit_memory_accounting::create_rtdyld_memory_manager(std::shared_ptr<jit_memory_accounting> accounting) {
+    return std::make_unique<accounted_section_memory_manager>(std::move(accounting));
+}
+
+} // k::model::gen
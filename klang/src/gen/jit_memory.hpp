@@ -0,0 +1,111 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef KLANG_JIT_MEMORY_HPP
+#define KLANG_JIT_MEMORY_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include <llvm/ExecutionEngine/JITLink/JITLinkMemoryManager.h>
+#include <llvm/ExecutionEngine/RuntimeDyld.h>
+
+namespace k::model::gen {
+
+/**
+ * Memory used by JIT-compiled code and data, in bytes.
+ */
+struct jit_memory_usage {
+    /** Executable sections. */
+    uint64_t code = 0;
+    /** Read-only data sections. */
+    uint64_t rodata = 0;
+    /** Writable data sections. */
+    uint64_t data = 0;
+
+    uint64_t total() const {
+        return code + rodata + data;
+    }
+
+    jit_memory_usage& operator+=(const jit_memory_usage& other);
+    jit_memory_usage& operator-=(const jit_memory_usage& other);
+};
+
+/**
+ * Accounting of the memory allocated by the object linking layer of a JIT instance, with an optional limit.
+ * Memory is accounted when sections are allocated and released when the module owning them is removed.
+ *
+ * Memory managers are provided for both object linkers:
+ * - JITLink: the limit is checked before allocating the memory of an object, linking fails if it is exceeded.
+ * - RuntimeDyld: memory is only accounted, as RuntimeDyld aborts the process on allocation failures.
+ */
+class jit_memory_accounting {
+protected:
+    mutable std::mutex _mutex;
+    uint64_t _limit;
+    jit_memory_usage _usage;
+
+public:
+    /**
+     * @param limit Maximum memory, in bytes, 0 for unlimited.
+     */
+    explicit jit_memory_accounting(uint64_t limit = 0);
+
+    /**
+     * Account memory, only if it does not exceed the limit.
+     * @return True if the memory is accounted.
+     */
+    bool reserve(const jit_memory_usage& usage);
+
+    /**
+     * Account memory, regardless of the limit.
+     */
+    void add(const jit_memory_usage& usage);
+
+    /**
+     * Release accounted memory.
+     */
+    void release(const jit_memory_usage& usage);
+
+    jit_memory_usage get_usage() const;
+
+    uint64_t get_limit() const {
+        return _limit;
+    }
+
+    /**
+     * Create a JITLink memory manager accounting its allocations.
+     * @param accounting Accounting of the allocations.
+     * @param slab_size Size of the address space reservations memory is sub-allocated from, in bytes, 0 to allocate
+     * each object separately. Memory of deallocated objects is reused by the next ones.
+     */
+    static llvm::Expected<std::unique_ptr<llvm::jitlink::JITLinkMemoryManager>>
+    create_jitlink_memory_manager(std::shared_ptr<jit_memory_accounting> accounting, uint64_t slab_size = 0);
+
+    /**
+     * Create a RuntimeDyld memory manager, for one object, accounting its allocations.
+     * Memory is released when the manager is destroyed, that is when the object is removed.
+     */
+    static std::unique_ptr<llvm::RuntimeDyld::MemoryManager>
+    create_rtdyld_memory_manager(std::shared_ptr<jit_memory_accounting> accounting);
+};
+
+} // k::model::gen
+
+#endif //KLANG_JIT_MEMORY_HPP
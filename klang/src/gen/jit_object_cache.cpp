@@ -0,0 +1,179 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit_object_cache.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SHA256.h>
+#include <llvm/Support/raw_ostream.h>
+
+namespace k::model::gen {
+
+namespace fs = std::filesystem;
+
+jit_object_cache::jit_object_cache(const std::string& directory, uint64_t max_size, const std::string& target_key) :
+        _directory(directory),
+        _max_size(max_size),
+        _target_key(target_key)
+{
+    std::error_code ec;
+    fs::create_directories(_directory, ec);
+    if (ec) {
+        std::cerr << "Cannot create JIT object cache directory '" << _directory << "': " << ec.message() << std::endl;
+    }
+}
+
+std::string jit_object_cache::target_key(const llvm::orc::JITTargetMachineBuilder& builder, optimization_level level) {
+    std::string key;
+    llvm::raw_string_ostream stream(key);
+    stream << "llvm:" << LLVM_VERSION_STRING
+           << ";triple:" << builder.getTargetTriple().str()
+           << ";cpu:" << builder.getCPU()
+           << ";features:" << builder.getFeatures().getString()
+           << ";opt:" << static_cast<int>(level);
+    return stream.str();
+}
+
+std::string jit_object_cache::module_key(const llvm::Module& module) const {
+    llvm::SHA256 hash;
+    hash.update(_target_key);
+    std::string ir;
+    llvm::raw_string_ostream stream(ir);
+    module.print(stream, nullptr);
+    hash.update(stream.str());
+    return llvm::toHex(hash.final(), /*LowerCase=*/true);
+}
+
+std::string jit_object_cache::object_path(const std::string& key) const {
+    return (fs::path(_directory) / (key + ".o")).string();
+}
+
+std::unique_ptr<llvm::MemoryBuffer> jit_object_cache::getObject(const llvm::Module* module) {
+    std::string key = module_key(*module);
+    std::string path = object_path(key);
+
+    auto buffer = llvm::MemoryBuffer::getFile(path, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if (buffer) {
+        // Refresh the modification time, used as last use time for eviction.
+        std::error_code ec;
+        fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+        ++_hits;
+        return std::move(*buffer);
+    }
+
+    ++_misses;
+    std::lock_guard<std::mutex> lock(_mutex);
+    _pending[module] = key;
+    return nullptr;
+}
+
+void jit_object_cache::notifyObjectCompiled(const llvm::Module* module, llvm::MemoryBufferRef object) {
+    std::string key;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _pending.find(module);
+        if (it == _pending.end()) {
+            return;
+        }
+        key = std::move(it->second);
+        _pending.erase(it);
+    }
+
+    // Write in a temporary file then rename it, so concurrent processes never read partial objects.
+    int fd;
+    llvm::SmallString<128> temp_path;
+    if (llvm::sys::fs::createUniqueFile(object_path(key) + ".%%%%%%.tmp", fd, temp_path)) {
+        return;
+    }
+    {
+        llvm::raw_fd_ostream stream(fd, /*shouldClose=*/true);
+        stream << object.getBuffer();
+        if (stream.has_error()) {
+            stream.clear_error();
+            llvm::sys::fs::remove(temp_path);
+            return;
+        }
+    }
+    if (llvm::sys::fs::rename(temp_path, object_path(key))) {
+        llvm::sys::fs::remove(temp_path);
+        return;
+    }
+
+    if (_max_size > 0) {
+        prune();
+    }
+}
+
+void jit_object_cache::prune() {
+    if (_max_size == 0) {
+        return;
+    }
+
+    struct entry {
+        fs::path path;
+        uint64_t size;
+        fs::file_time_type last_use;
+    };
+    std::vector<entry> entries;
+    uint64_t total = 0;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::error_code ec;
+    for (const auto& file : fs::directory_iterator(_directory, ec)) {
+        if (file.path().extension() != ".o" || !file.is_regular_file(ec)) {
+            continue;
+        }
+        entry e{file.path(), file.file_size(ec), file.last_write_time(ec)};
+        if (!ec) {
+            total += e.size;
+            entries.push_back(std::move(e));
+        }
+    }
+    if (total <= _max_size) {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const entry& a, const entry& b) {
+        return a.last_use < b.last_use;
+    });
+    for (const auto& e : entries) {
+        if (total <= _max_size) {
+            break;
+        }
+        if (fs::remove(e.path, ec)) {
+            total -= e.size;
+            ++_evictions;
+        }
+    }
+}
+
+jit_object_cache::statistics jit_object_cache::get_statistics() const {
+    return statistics{_hits.load(), _misses.load(), _evictions.load()};
+}
+
+} // k::model::gen
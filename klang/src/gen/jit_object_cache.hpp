@@ -0,0 +1,113 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef KLANG_JIT_OBJECT_CACHE_HPP
+#define KLANG_JIT_OBJECT_CACHE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <llvm/ExecutionEngine/ObjectCache.h>
+
+#include "../compiler.hpp"
+
+namespace llvm::orc {
+class JITTargetMachineBuilder;
+}
+
+namespace k::model::gen {
+
+/**
+ * Persistent on-disk cache of objects compiled by the JIT.
+ * Objects are stored in a directory, one file per module, named after a hash of the module IR and of the target
+ * (triple, CPU, features, optimization level and LLVM version).
+ * When a cached object exists for a module, the JIT loads it instead of running the code generation.
+ * The cache size can be limited: least recently used objects are evicted first.
+ */
+class jit_object_cache : public llvm::ObjectCache {
+public:
+    struct statistics {
+        /** Number of modules whose object was loaded from the cache. */
+        size_t hits = 0;
+        /** Number of modules not found in the cache, so compiled. */
+        size_t misses = 0;
+        /** Number of objects evicted from the cache. */
+        size_t evictions = 0;
+    };
+
+protected:
+    std::string _directory;
+    uint64_t _max_size;
+    /** Description of the target, part of the object keys. */
+    std::string _target_key;
+
+    /**
+     * Keys of modules being compiled after a cache miss.
+     * Keys are computed before code generation as code generation passes may modify the module.
+     */
+    std::map<const llvm::Module*, std::string> _pending;
+    std::mutex _mutex;
+
+    std::atomic<size_t> _hits = 0;
+    std::atomic<size_t> _misses = 0;
+    std::atomic<size_t> _evictions = 0;
+
+    std::string module_key(const llvm::Module& module) const;
+    std::string object_path(const std::string& key) const;
+
+public:
+    /**
+     * Create a cache.
+     * @param directory Directory where objects are stored, created if needed.
+     * @param max_size Maximum size of cached objects, in bytes, 0 for unlimited.
+     * @param target_key Description of the target, see target_key().
+     */
+    jit_object_cache(const std::string& directory, uint64_t max_size, const std::string& target_key);
+
+    void notifyObjectCompiled(const llvm::Module* module, llvm::MemoryBufferRef object) override;
+    std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module* module) override;
+
+    const std::string& get_directory() const {
+        return _directory;
+    }
+
+    uint64_t get_max_size() const {
+        return _max_size;
+    }
+
+    statistics get_statistics() const;
+
+    /**
+     * Evict least recently used objects until the cache size fits its maximum size.
+     */
+    void prune();
+
+    /**
+     * Description of the target for which a JIT target machine builder creates target machines.
+     * @param builder JIT target machine builder.
+     * @param level Optimization level of modules and code generation.
+     */
+    static std::string target_key(const llvm::orc::JITTargetMachineBuilder& builder, optimization_level level);
+};
+
+} // k::model::gen
+
+#endif //KLANG_JIT_OBJECT_CACHE_HPP
@@ -0,0 +1,143 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit_perf_map.hpp"
+
+#include "../model/mangler.hpp"
+
+#include <llvm/ExecutionEngine/JITLink/JITLink.h>
+#include <llvm/Object/SymbolSize.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <iostream>
+#include <mutex>
+
+namespace k::model::gen {
+
+namespace {
+
+/**
+ * Record functions of each linked graph, once their final addresses are known.
+ */
+class perf_map_plugin : public llvm::orc::ObjectLinkingLayer::Plugin {
+public:
+    void modifyPassConfig(llvm::orc::MaterializationResponsibility& responsibility, llvm::jitlink::LinkGraph& graph,
+                          llvm::jitlink::PassConfiguration& config) override {
+        config.PostFixupPasses.push_back([](llvm::jitlink::LinkGraph& graph) -> llvm::Error {
+            for (auto* symbol : graph.defined_symbols()) {
+                if (symbol->hasName() && symbol->isCallable() && symbol->getSize() > 0) {
+                    jit_perf_map::add(symbol->getAddress().getValue(), symbol->getSize(), symbol->getName());
+                }
+            }
+            return llvm::Error::success();
+        });
+    }
+
+    llvm::Error notifyFailed(llvm::orc::MaterializationResponsibility& responsibility) override {
+        return llvm::Error::success();
+    }
+
+    llvm::Error notifyRemovingResources(llvm::orc::JITDylib& library, llvm::orc::ResourceKey key) override {
+        // Perf maps are append only, stale entries are shadowed by the code later linked at the same addresses.
+        return llvm::Error::success();
+    }
+
+    void notifyTransferringResources(llvm::orc::JITDylib& library, llvm::orc::ResourceKey dst_key, llvm::orc::ResourceKey src_key) override {
+    }
+};
+
+/**
+ * Record functions of each loaded object, using its debug view where sections are at their load addresses.
+ */
+class perf_map_listener : public llvm::JITEventListener {
+public:
+    void notifyObjectLoaded(ObjectKey key, const llvm::object::ObjectFile& object,
+                            const llvm::RuntimeDyld::LoadedObjectInfo& info) override {
+        auto debug_object = info.getObjectForDebug(object);
+        if (!debug_object.getBinary()) {
+            return;
+        }
+        for (const auto& [symbol, size] : llvm::object::computeSymbolSizes(*debug_object.getBinary())) {
+            auto type = symbol.getType();
+            if (!type || *type != llvm::object::SymbolRef::ST_Function) {
+                llvm::consumeError(type.takeError());
+                continue;
+            }
+            auto name = symbol.getName();
+            auto address = symbol.getAddress();
+            if (!name || !address) {
+                llvm::consumeError(name.takeError());
+                llvm::consumeError(address.takeError());
+                continue;
+            }
+            if (size > 0) {
+                jit_perf_map::add(*address, size, *name);
+            }
+        }
+    }
+};
+
+} // anonymous namespace
+
+std::string jit_perf_map::get_path() {
+    return "/tmp/perf-" + std::to_string(llvm::sys::Process::getProcessId()) + ".map";
+}
+
+std::string jit_perf_map::get_label(llvm::StringRef symbol) {
+    auto [name, variant] = symbol.split('$');
+    std::string label = mangler::demangle(name.str());
+    if (!variant.empty()) {
+        label += " [" + variant.str() + "]";
+    }
+    return label;
+}
+
+void jit_perf_map::add(uint64_t address, uint64_t size, llvm::StringRef symbol) {
+    static std::mutex mutex;
+    static std::unique_ptr<llvm::raw_fd_ostream> stream;
+
+    std::string label = get_label(symbol);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!stream) {
+        std::error_code err;
+        stream = std::make_unique<llvm::raw_fd_ostream>(get_path(), err, llvm::sys::fs::OF_Append | llvm::sys::fs::OF_Text);
+        if (err) {
+            std::cerr << "Cannot open perf map file '" << get_path() << "': " << err.message() << std::endl;
+            stream.reset();
+            return;
+        }
+    }
+    // Perf reads the map while the process is running, lines are flushed as soon as written.
+    *stream << llvm::format_hex_no_prefix(address, 1) << ' ' << llvm::format_hex_no_prefix(size, 1) << ' ' << label << '\n';
+    stream->flush();
+}
+
+std::unique_ptr<llvm::orc::ObjectLinkingLayer::Plugin> jit_perf_map::create_plugin() {
+    return std::make_unique<perf_map_plugin>();
+}
+
+llvm::JITEventListener& jit_perf_map::get_listener() {
+    static perf_map_listener listener;
+    return listener;
+}
+
+} // k::model::gen
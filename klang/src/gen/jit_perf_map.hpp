@@ -0,0 +1,74 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef KLANG_JIT_PERF_MAP_HPP
+#define KLANG_JIT_PERF_MAP_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/ExecutionEngine/JITEventListener.h>
+#include <llvm/ExecutionEngine/Orc/ObjectLinkingLayer.h>
+
+namespace k::model::gen {
+
+/**
+ * Perf map of the code generated by JIT instances, so "perf report" can attribute samples to JIT-compiled functions.
+ * Functions are appended to the process map file, "/tmp/perf-<pid>.map", when their object is linked,
+ * one "<address> <size> <name>" line per function, named after their demangled K name.
+ * Internal variants of functions (like tiered or reloaded ones, named "<symbol>$<variant>")
+ * are labelled with their variant, like "test::fibo(unsigned int) [tier1]".
+ *
+ * The map is shared by all JIT instances of the process. Objects are observed either by a JITLink plugin or by
+ * a RuntimeDyld event listener, depending on the object linking layer of the JIT.
+ */
+class jit_perf_map {
+public:
+    /**
+     * Path of the map file of the current process.
+     */
+    static std::string get_path();
+
+    /**
+     * Readable name of a JIT symbol: demangled K name, with its variant if any.
+     * Symbols which are not K symbols are returned unchanged.
+     */
+    static std::string get_label(llvm::StringRef symbol);
+
+    /**
+     * Append a function to the map file.
+     */
+    static void add(uint64_t address, uint64_t size, llvm::StringRef symbol);
+
+    /**
+     * Create a plugin recording the functions of objects linked by a JITLink object linking layer.
+     */
+    static std::unique_ptr<llvm::orc::ObjectLinkingLayer::Plugin> create_plugin();
+
+    /**
+     * Listener recording the functions of objects loaded by a RuntimeDyld object linking layer.
+     * The listener is shared by all layers and lives as long as the process.
+     */
+    static llvm::JITEventListener& get_listener();
+};
+
+} // k::model::gen
+
+#endif //KLANG_JIT_PERF_MAP_HPP
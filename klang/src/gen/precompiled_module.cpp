@@ -0,0 +1,218 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "precompiled_module.hpp"
+
+#include <llvm/Support/Endian.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <iostream>
+
+namespace k::model::gen {
+
+void precompiled_module::set_target(const std::string& triple, const std::string& cpu, const std::string& features) {
+    _target_triple = triple;
+    _target_cpu = cpu;
+    _target_features = features;
+}
+
+const precompiled_module::symbol* precompiled_module::find_symbol(const std::string& name) const {
+    std::vector<std::string> candidates;
+    if (name.starts_with("::")) {
+        candidates.push_back(name);
+    } else {
+        candidates.push_back(_module_name + "::" + name);
+        candidates.push_back("::" + name);
+    }
+    for (const auto& candidate : candidates) {
+        for (const auto& sym : _symbols) {
+            if (sym.name == candidate) {
+                return &sym;
+            }
+        }
+    }
+    return nullptr;
+}
+
+//
+// Serialization
+//
+
+static llvm::json::Array to_json(const std::vector<std::string>& strings) {
+    llvm::json::Array array;
+    for (const auto& str : strings) {
+        array.push_back(str);
+    }
+    return array;
+}
+
+bool precompiled_module::save(const std::string& path) const {
+    if (!_object) {
+        std::cerr << "Error : No object in precompiled module." << std::endl;
+        return false;
+    }
+
+    llvm::json::Array symbols;
+    for (const auto& sym : _symbols) {
+        symbols.push_back(llvm::json::Object{
+                {"kind", sym.kind == FUNCTION ? "function" : "variable"},
+                {"name", sym.name},
+                {"mangled_name", sym.mangled_name},
+                {"type", sym.type}
+        });
+    }
+    llvm::json::Array structures;
+    for (const auto& st : _structures) {
+        llvm::json::Array fields;
+        for (const auto& fld : st.fields) {
+            fields.push_back(llvm::json::Object{{"name", fld.name}, {"type", fld.type}});
+        }
+        structures.push_back(llvm::json::Object{{"name", st.name}, {"fields", std::move(fields)}});
+    }
+
+    std::string metadata;
+    llvm::raw_string_ostream metadata_stream(metadata);
+    metadata_stream << llvm::json::Value(llvm::json::Object{
+            {"module", _module_name},
+            {"target", llvm::json::Object{{"triple", _target_triple}, {"cpu", _target_cpu}, {"features", _target_features}}},
+            {"symbols", std::move(symbols)},
+            {"structures", std::move(structures)},
+            {"initializers", to_json(_initializers)},
+            {"finalizers", to_json(_finalizers)}
+    });
+    metadata_stream.flush();
+
+    std::error_code err;
+    llvm::raw_fd_ostream dest(path, err, llvm::sys::fs::OF_None);
+    if (err) {
+        std::cerr << "Could not open file: " << err.message() << std::endl;
+        return false;
+    }
+    dest.write(magic, sizeof(magic));
+    char size[4];
+    llvm::support::endian::write32le(size, metadata.size());
+    dest.write(size, sizeof(size));
+    dest << metadata;
+    dest << _object->getBuffer();
+    dest.flush();
+    return !dest.has_error();
+}
+
+static bool read_strings(const llvm::json::Object& object, llvm::StringRef key, std::vector<std::string>& res) {
+    auto* array = object.getArray(key);
+    if (!array) {
+        return false;
+    }
+    for (const auto& value : *array) {
+        auto str = value.getAsString();
+        if (!str) {
+            return false;
+        }
+        res.push_back(str->str());
+    }
+    return true;
+}
+
+static bool read_string(const llvm::json::Object& object, llvm::StringRef key, std::string& res) {
+    auto str = object.getString(key);
+    if (!str) {
+        return false;
+    }
+    res = str->str();
+    return true;
+}
+
+std::shared_ptr<precompiled_module> precompiled_module::load(const std::string& path) {
+    auto buffer = llvm::MemoryBuffer::getFile(path);
+    if (!buffer) {
+        std::cerr << "Could not open file '" << path << "': " << buffer.getError().message() << std::endl;
+        return nullptr;
+    }
+    llvm::StringRef content = (*buffer)->getBuffer();
+
+    constexpr size_t header_size = sizeof(magic) + 4;
+    if (content.size() < header_size || !content.starts_with(llvm::StringRef(magic, sizeof(magic)))) {
+        std::cerr << "'" << path << "' is not a precompiled K module." << std::endl;
+        return nullptr;
+    }
+    uint32_t metadata_size = llvm::support::endian::read32le(content.data() + sizeof(magic));
+    if (content.size() < header_size + metadata_size) {
+        std::cerr << "Truncated precompiled K module '" << path << "'." << std::endl;
+        return nullptr;
+    }
+
+    auto metadata = llvm::json::parse(content.substr(header_size, metadata_size));
+    if (!metadata) {
+        std::cerr << "Invalid precompiled K module '" << path << "': " << llvm::toString(metadata.takeError()) << std::endl;
+        return nullptr;
+    }
+
+    auto module = std::make_shared<precompiled_module>();
+    bool valid = false;
+    if (auto* root = metadata->getAsObject()) {
+        auto* target = root->getObject("target");
+        auto* symbols = root->getArray("symbols");
+        auto* structures = root->getArray("structures");
+        valid = target && symbols && structures
+                && read_string(*root, "module", module->_module_name)
+                && read_string(*target, "triple", module->_target_triple)
+                && read_string(*target, "cpu", module->_target_cpu)
+                && read_string(*target, "features", module->_target_features)
+                && read_strings(*root, "initializers", module->_initializers)
+                && read_strings(*root, "finalizers", module->_finalizers);
+
+        for (size_t n = 0; valid && n < symbols->size(); ++n) {
+            auto* object = (*symbols)[n].getAsObject();
+            symbol sym;
+            std::string kind;
+            valid = object
+                    && read_string(*object, "kind", kind)
+                    && read_string(*object, "name", sym.name)
+                    && read_string(*object, "mangled_name", sym.mangled_name)
+                    && read_string(*object, "type", sym.type);
+            sym.kind = kind == "function" ? FUNCTION : VARIABLE;
+            module->_symbols.push_back(std::move(sym));
+        }
+
+        for (size_t n = 0; valid && n < structures->size(); ++n) {
+            auto* object = (*structures)[n].getAsObject();
+            auto* fields = object ? object->getArray("fields") : nullptr;
+            structure st;
+            valid = fields && read_string(*object, "name", st.name);
+            for (size_t f = 0; valid && f < fields->size(); ++f) {
+                auto* fld_object = (*fields)[f].getAsObject();
+                field fld;
+                valid = fld_object && read_string(*fld_object, "name", fld.name) && read_string(*fld_object, "type", fld.type);
+                st.fields.push_back(std::move(fld));
+            }
+            module->_structures.push_back(std::move(st));
+        }
+    }
+    if (!valid) {
+        std::cerr << "Invalid precompiled K module '" << path << "': malformed metadata." << std::endl;
+        return nullptr;
+    }
+
+    // Copied to its own buffer, so the object is suitably aligned to be parsed.
+    module->_object = llvm::MemoryBuffer::getMemBufferCopy(content.substr(header_size + metadata_size), path);
+    return module;
+}
+
+} // k::model::gen
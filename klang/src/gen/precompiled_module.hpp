@@ -0,0 +1,177 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef KLANG_PRECOMPILED_MODULE_HPP
+#define KLANG_PRECOMPILED_MODULE_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <llvm/Support/MemoryBuffer.h>
+
+namespace k::model::gen {
+
+/**
+ * Precompiled K module: native object of a compiled unit, with the metadata needed to use it without its source.
+ * Precompiled modules are produced ahead of time by compiler::gen_precompiled_module() and loaded into a JIT
+ * instance with unit_llvm_jit::add_precompiled_module(), without parsing nor generating code again.
+ *
+ * Metadata are:
+ * - the target the object is compiled for,
+ * - the exported symbols, with their K names, mangled names and types, to look them up by their K names,
+ * - the structures, with their field types,
+ * - the initializer and finalizer functions of the module, run by the JIT instead of object constructors.
+ *
+ * File format: "KPM" magic and format version, metadata size (32 bits, little endian), metadata (JSON), object.
+ */
+class precompiled_module {
+public:
+    enum symbol_kind {
+        FUNCTION,
+        VARIABLE
+    };
+
+    struct symbol {
+        symbol_kind kind;
+        /** Fully qualified K name, like "::test::fibo". */
+        std::string name;
+        std::string mangled_name;
+        /** K type of variables, signature of functions, like "(unsigned int) : unsigned int". */
+        std::string type;
+    };
+
+    struct field {
+        std::string name;
+        std::string type;
+    };
+
+    struct structure {
+        /** Fully qualified K name. */
+        std::string name;
+        std::vector<field> fields;
+    };
+
+    static constexpr char magic[] = {'K', 'P', 'M', 1};
+
+protected:
+    /** Fully qualified name of the root namespace of the module, like "::test". */
+    std::string _module_name;
+    std::string _target_triple;
+    std::string _target_cpu;
+    std::string _target_features;
+
+    std::vector<symbol> _symbols;
+    std::vector<structure> _structures;
+    /** Mangled names of functions to call when the module is loaded, in call order. */
+    std::vector<std::string> _initializers;
+    /** Mangled names of functions to call when the module is unloaded, in call order. */
+    std::vector<std::string> _finalizers;
+
+    std::unique_ptr<llvm::MemoryBuffer> _object;
+
+public:
+    const std::string& get_module_name() const {
+        return _module_name;
+    }
+
+    void set_module_name(const std::string& name) {
+        _module_name = name;
+    }
+
+    const std::string& get_target_triple() const {
+        return _target_triple;
+    }
+
+    const std::string& get_target_cpu() const {
+        return _target_cpu;
+    }
+
+    const std::string& get_target_features() const {
+        return _target_features;
+    }
+
+    void set_target(const std::string& triple, const std::string& cpu, const std::string& features);
+
+    const std::vector<symbol>& get_symbols() const {
+        return _symbols;
+    }
+
+    void add_symbol(symbol sym) {
+        _symbols.push_back(std::move(sym));
+    }
+
+    const std::vector<structure>& get_structures() const {
+        return _structures;
+    }
+
+    void add_structure(structure st) {
+        _structures.push_back(std::move(st));
+    }
+
+    const std::vector<std::string>& get_initializers() const {
+        return _initializers;
+    }
+
+    void add_initializer(const std::string& mangled_name) {
+        _initializers.push_back(mangled_name);
+    }
+
+    const std::vector<std::string>& get_finalizers() const {
+        return _finalizers;
+    }
+
+    void add_finalizer(const std::string& mangled_name) {
+        _finalizers.push_back(mangled_name);
+    }
+
+    /**
+     * Native object of the module.
+     */
+    llvm::MemoryBufferRef get_object() const {
+        return _object ? _object->getMemBufferRef() : llvm::MemoryBufferRef();
+    }
+
+    void set_object(std::unique_ptr<llvm::MemoryBuffer> object) {
+        _object = std::move(object);
+    }
+
+    /**
+     * Find an exported symbol by its K name.
+     * As for compiler::find_elements(), the name is either absolute ("::test::fibo") or relative to the root
+     * namespace of the module ("fibo", "test::fibo").
+     * @return The symbol, null if not found.
+     */
+    const symbol* find_symbol(const std::string& name) const;
+
+    /**
+     * Write the module to a file.
+     * @return True if the file is written.
+     */
+    bool save(const std::string& path) const;
+
+    /**
+     * Read a module from a file.
+     * @return The module, null if the file cannot be read or is not a valid precompiled module.
+     */
+    static std::shared_ptr<precompiled_module> load(const std::string& path);
+};
+
+} // k::model::gen
+
+#endif //KLANG_PRECOMPILED_MODULE_HPP
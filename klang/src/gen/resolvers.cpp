@@ -16,7 +16,7 @@
  * limitations under the License.
  */
 //
-// Note: Last resolver log number: 0x30004
+// Note: Last resolver log number: 0x30011
 //
 
 #include "resolvers.hpp"
@@ -173,6 +173,11 @@ std::shared_ptr<expression> symbol_resolver::adapt_type(std::shared_ptr<expressi
         }
     }
 
+    if(type_src == type) {
+        // Same types (structures passed by value...) trivially agree
+        return expr;
+    }
+
     auto prim_src = std::dynamic_pointer_cast<primitive_type>(expr->get_type());
     auto prim_tgt = std::dynamic_pointer_cast<primitive_type>(type);
 
@@ -254,6 +259,7 @@ std::shared_ptr<expression> type_reference_resolver::adapt_type(std::shared_ptr<
         if(type::is_reference(type)) {
             if (type == type_src) {
                 // Reference to same type, return the expression
+                check_reference_alignment(expr, type->get_subtype());
                 return expr;
             } else {
                 // Reference to different types
@@ -267,6 +273,20 @@ std::shared_ptr<expression> type_reference_resolver::adapt_type(std::shared_ptr<
         }
     }
 
+    if(auto vec_tgt = std::dynamic_pointer_cast<vector_type>(type)) {
+        if(expr->get_type() == type) {
+            return expr;
+        }
+        // Scalar to vector: convert to the lane type, then broadcast to all lanes.
+        auto lane = adapt_type(expr, vec_tgt->get_lane_type());
+        if(!lane) {
+            return {};
+        }
+        auto splat = cast_expression::make_shared(lane, vec_tgt);
+        splat->set_type(vec_tgt);
+        return splat;
+    }
+
     auto prim_src = std::dynamic_pointer_cast<primitive_type>(expr->get_type());
     auto prim_tgt = std::dynamic_pointer_cast<primitive_type>(type);
 
@@ -288,4 +308,35 @@ std::shared_ptr<expression> type_reference_resolver::adapt_type(std::shared_ptr<
 
 
 
+std::optional<uint64_t> type_reference_resolver::get_custom_layout_field_alignment(const std::shared_ptr<expression>& expr) {
+    auto member = std::dynamic_pointer_cast<member_of_object_expression>(expr);
+    if(!member || !type::is_reference(member->sub_expr()->get_type())) {
+        return std::nullopt;
+    }
+    auto st_type = std::dynamic_pointer_cast<struct_type>(member->sub_expr()->get_type()->get_subtype());
+    if(!st_type) {
+        return std::nullopt;
+    }
+    auto field = st_type->get_member(member->symbol().get_name());
+    if(!field) {
+        return std::nullopt;
+    }
+    auto base_align = get_custom_layout_field_alignment(member->sub_expr());
+    if(!base_align) {
+        if(!st_type->has_custom_layout()) {
+            return std::nullopt;
+        }
+        base_align = st_type->get_alignment();
+    }
+    return llvm::commonAlignment(llvm::Align(*base_align), field->offset).value();
+}
+
+void type_reference_resolver::check_reference_alignment(const std::shared_ptr<expression>& expr, const std::shared_ptr<type>& type) {
+    if(auto align = get_custom_layout_field_alignment(expr); align && *align < _context->get_alignment(type)) {
+        auto member = std::dynamic_pointer_cast<member_of_object_expression>(expr);
+        throw_error(0x000B, std::nullopt, "Cannot bind a reference to the under-aligned field '{}' of a structure with a custom layout",
+                    {member->symbol().get_name().to_string()});
+    }
+}
+
 } // k::model::gen
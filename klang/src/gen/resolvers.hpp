@@ -222,6 +222,11 @@ protected:
     void visit_subscript_expression(subscript_expression&) override;
     void visit_function_invocation_expression(function_invocation_expression &) override;
 
+    /**
+     * Resolve the types of a vector builtin function invocation (reductions and shuffles).
+     */
+    void process_vector_builtin(function_invocation_expression &);
+
     void visit_cast_expression(cast_expression&)override;
 
     /**
@@ -238,6 +243,20 @@ protected:
      * @return The given arg expression if already compatible, the new wrapping casting expr if mapping, nullptr if not possible.
      */
     std::shared_ptr<expression> adapt_type(std::shared_ptr<expression> expr, const std::shared_ptr<type>& type);
+
+    /**
+     * Alignment of a field of a structure with a custom layout (packed or explicitly aligned), or of a field of such a field.
+     * @param expr Member-of-object expression.
+     * @return Alignment of the field, deduced from the structure alignment and the field offset, none if the expression
+     * is not a field of a structure with a custom layout.
+     */
+    std::optional<uint64_t> get_custom_layout_field_alignment(const std::shared_ptr<expression>& expr);
+
+    /**
+     * Check a reference can be bound to an expression: references are accessed with the natural alignment of their type,
+     * so they cannot refer to an under-aligned field of a structure with a custom layout.
+     */
+    void check_reference_alignment(const std::shared_ptr<expression>& expr, const std::shared_ptr<type>& type);
 };
 
 
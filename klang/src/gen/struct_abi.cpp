@@ -0,0 +1,119 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "struct_abi.hpp"
+
+#include <algorithm>
+
+namespace k::model::gen {
+
+std::vector<llvm::Type*> struct_abi::get_sysv_coerced_types(llvm::StructType* type, const llvm::DataLayout& layout) {
+    if (!type || type->isOpaque()) {
+        return {};
+    }
+
+    // Structures bigger than two eightbytes are passed in memory.
+    uint64_t size = layout.getTypeAllocSize(type);
+    if (size == 0 || size > 16) {
+        return {};
+    }
+
+    std::vector<leaf> leaves;
+    if (!flatten(type, 0, layout, leaves)) {
+        return {};
+    }
+
+    std::vector<llvm::Type*> parts;
+    for (uint64_t start = 0; start < size; start += 8) {
+        uint64_t end = std::min<uint64_t>(start + 8, size);
+        bool has_field = false, has_integer = false, has_double = false, has_high_float = false;
+        for (const auto& field : leaves) {
+            if (field.offset < start || field.offset >= end) {
+                continue;
+            }
+            uint64_t field_size = layout.getTypeStoreSize(field.type);
+            if (field.offset + field_size > start + 8) {
+                // Field spanning two eightbytes.
+                return {};
+            }
+            has_field = true;
+            if (field.type->isDoubleTy()) {
+                has_double = true;
+            } else if (field.type->isFloatTy()) {
+                has_high_float |= field.offset == start + 4;
+            } else {
+                has_integer = true;
+            }
+        }
+        if (!has_field) {
+            // Eightbyte made only of padding.
+            return {};
+        }
+
+        if (has_integer) {
+            // INTEGER class: passed in a general purpose register, coerced to an integer covering the eightbyte.
+            parts.push_back(llvm::IntegerType::get(type->getContext(), (end - start) * 8));
+        } else if (has_double) {
+            // SSE class
+            parts.push_back(llvm::Type::getDoubleTy(type->getContext()));
+        } else if (has_high_float) {
+            // SSE class, two floats packed in the same register.
+            parts.push_back(llvm::FixedVectorType::get(llvm::Type::getFloatTy(type->getContext()), 2));
+        } else {
+            // SSE class
+            parts.push_back(llvm::Type::getFloatTy(type->getContext()));
+        }
+    }
+    return parts;
+}
+
+bool struct_abi::flatten(llvm::Type* type, uint64_t offset, const llvm::DataLayout& layout, std::vector<leaf>& leaves) {
+    if (auto st = llvm::dyn_cast<llvm::StructType>(type)) {
+        if (st->isOpaque()) {
+            return false;
+        }
+        auto st_layout = layout.getStructLayout(st);
+        for (unsigned int n = 0; n < st->getNumElements(); ++n) {
+            uint64_t elem_offset = st_layout->getElementOffset(n);
+            if (!flatten(st->getElementType(n), offset + elem_offset, layout, leaves)) {
+                return false;
+            }
+        }
+        return true;
+    } else if (auto arr = llvm::dyn_cast<llvm::ArrayType>(type)) {
+        uint64_t elem_size = layout.getTypeAllocSize(arr->getElementType());
+        for (uint64_t n = 0; n < arr->getNumElements(); ++n) {
+            if (!flatten(arr->getElementType(), offset + n * elem_size, layout, leaves)) {
+                return false;
+            }
+        }
+        return true;
+    } else if ((type->isIntegerTy() && type->getIntegerBitWidth() <= 64) || type->isPointerTy() || type->isFloatTy() || type->isDoubleTy()) {
+        // Unaligned fields (packed structures) are passed in memory.
+        if (offset % layout.getABITypeAlign(type).value() != 0) {
+            return false;
+        }
+        leaves.push_back({offset, type});
+        return true;
+    } else {
+        // Vectors, 128-bit integers and extended precision floats are not coerced.
+        return false;
+    }
+}
+
+} // k::model::gen
@@ -0,0 +1,64 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef KLANG_STRUCT_ABI_HPP
+#define KLANG_STRUCT_ABI_HPP
+
+#include <llvm/IR/DataLayout.h>
+#include <llvm/IR/DerivedTypes.h>
+
+#include <vector>
+
+namespace k::model::gen {
+
+/**
+ * Structure calling convention helper.
+ * Classify structures passed or returned by value following the System V x86-64 ABI rules,
+ * so small structures are passed and returned in registers instead of through memory.
+ * A structure of at most 16 bytes is split in eightbytes, each one coerced to the type of the register
+ * class it is passed in: an integer (INTEGER class, if it contains any integer or pointer field)
+ * or a float, a double or a <2 x float> vector (SSE class, if it contains only floating point fields).
+ */
+class struct_abi {
+public:
+    /**
+     * Compute the types a structure is coerced to when passed or returned by value.
+     * @param type Structure type.
+     * @param layout Data layout of the target.
+     * @return Coerced types, one per eightbyte, empty if the structure must be passed as is
+     * (too big, empty, containing vectors, unaligned or unsupported fields).
+     */
+    static std::vector<llvm::Type*> get_sysv_coerced_types(llvm::StructType* type, const llvm::DataLayout& layout);
+
+protected:
+    /** Scalar field of a structure at a given byte offset. */
+    struct leaf {
+        uint64_t offset;
+        llvm::Type* type;
+    };
+
+    /**
+     * Flatten an aggregate into its scalar fields.
+     * @return False if the aggregate contains unsupported fields.
+     */
+    static bool flatten(llvm::Type* type, uint64_t offset, const llvm::DataLayout& layout, std::vector<leaf>& leaves);
+};
+
+} // k::model::gen
+
+#endif //KLANG_STRUCT_ABI_HPP
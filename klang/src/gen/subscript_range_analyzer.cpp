@@ -0,0 +1,364 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "subscript_range_analyzer.hpp"
+
+#include <charconv>
+#include <limits>
+
+namespace k::model::gen {
+
+void subscript_range_analyzer::analyze()
+{
+    // Usages of all variables must be known before looking at loops, as a variable
+    // may be modified after being used as subscript index in a loop body.
+    _phase = COLLECT_USAGES;
+    _usages.clear();
+    visit_unit(_unit);
+
+    _phase = MARK_SUBSCRIPTS;
+    _ranges.clear();
+    visit_unit(_unit);
+}
+
+std::optional<uint64_t> subscript_range_analyzer::get_max_value(const std::shared_ptr<const type>& type) {
+    auto prim = std::dynamic_pointer_cast<const primitive_type>(type);
+    if (!prim || !prim->is_integer()) {
+        return {};
+    }
+    size_t bits = prim->is_unsigned() ? prim->type_size() : prim->type_size() - 1;
+    if (bits >= 64) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+    return (uint64_t{1} << bits) - 1;
+}
+
+std::optional<uint64_t> subscript_range_analyzer::get_integer_constant(const std::shared_ptr<expression>& expr) {
+    if (auto cast = std::dynamic_pointer_cast<cast_expression>(expr)) {
+        auto value = get_integer_constant(cast->sub_expr());
+        auto max = get_max_value(cast->get_cast_type());
+        if (value && max && *value <= *max) {
+            return value;
+        }
+        return {};
+    }
+    if (auto value_expr = std::dynamic_pointer_cast<value_expression>(expr); value_expr && value_expr->is_literal()) {
+        const auto& literal = value_expr->any_literal();
+        if (std::holds_alternative<lex::integer>(literal)) {
+            const auto& integer = literal.get<lex::integer>();
+            auto content = integer.int_content();
+            uint64_t value;
+            auto [ptr, ec] = std::from_chars(content.data(), content.data() + content.size(), value, integer.base);
+            if (ec == std::errc() && ptr == content.data() + content.size()) {
+                return value;
+            }
+        }
+    }
+    return {};
+}
+
+std::shared_ptr<variable_definition> subscript_range_analyzer::get_read_variable(const std::shared_ptr<expression>& expr, uint64_t limit) {
+    if (auto cast = std::dynamic_pointer_cast<cast_expression>(expr)) {
+        auto max = get_max_value(cast->get_cast_type());
+        if (!max || *max < limit) {
+            return {};
+        }
+        return get_read_variable(cast->sub_expr(), limit);
+    }
+    if (auto load = std::dynamic_pointer_cast<load_value_expression>(expr)) {
+        if (auto symbol = std::dynamic_pointer_cast<symbol_expression>(load->sub_expr())) {
+            return symbol->get_variable_def();
+        }
+    }
+    return {};
+}
+
+std::optional<subscript_range_analyzer::loop_range> subscript_range_analyzer::get_loop_range(for_statement& stmt) {
+    // Loop variable, declared and initialized with a constant
+    auto var = stmt.get_decl_stmt();
+    if (!var || !var->get_init_expr()) {
+        return {};
+    }
+    auto var_max = get_max_value(var->get_type());
+    auto start = get_integer_constant(var->get_init_expr());
+    if (!var_max || !start) {
+        return {};
+    }
+
+    // Test: "var < end" or "var <= last"
+    auto test = stmt.get_test_expr();
+    bool inclusive = false;
+    if (std::dynamic_pointer_cast<lesser_equal_expression>(test)) {
+        inclusive = true;
+    } else if (!std::dynamic_pointer_cast<lesser_expression>(test)) {
+        return {};
+    }
+    auto comparison = std::dynamic_pointer_cast<binary_expression>(test);
+    auto bound = get_integer_constant(comparison->right());
+    if (!bound || get_read_variable(comparison->left(), *var_max) != var) {
+        return {};
+    }
+    if (inclusive && *bound == std::numeric_limits<uint64_t>::max()) {
+        return {};
+    }
+    uint64_t end = inclusive ? *bound + 1 : *bound;
+
+    // Step: "var += step" or "var = var + step"
+    std::optional<uint64_t> step;
+    auto step_expr = stmt.get_step_expr();
+    if (auto add_assign = std::dynamic_pointer_cast<additition_assignation_expression>(step_expr)) {
+        auto symbol = std::dynamic_pointer_cast<symbol_expression>(add_assign->left());
+        if (!symbol || symbol->get_variable_def() != var) {
+            return {};
+        }
+        step = get_integer_constant(add_assign->right());
+    } else if (auto assign = std::dynamic_pointer_cast<simple_assignation_expression>(step_expr)) {
+        auto symbol = std::dynamic_pointer_cast<symbol_expression>(assign->left());
+        if (!symbol || symbol->get_variable_def() != var) {
+            return {};
+        }
+        auto sum = assign->right();
+        while (auto cast = std::dynamic_pointer_cast<cast_expression>(sum)) {
+            auto max = get_max_value(cast->get_cast_type());
+            if (!max || *max < *var_max) {
+                return {};
+            }
+            sum = cast->sub_expr();
+        }
+        auto add = std::dynamic_pointer_cast<addition_expression>(sum);
+        if (!add) {
+            return {};
+        }
+        if (get_read_variable(add->left(), *var_max) == var) {
+            step = get_integer_constant(add->right());
+        } else if (get_read_variable(add->right(), *var_max) == var) {
+            step = get_integer_constant(add->left());
+        }
+    }
+    if (!step || *step == 0) {
+        return {};
+    }
+
+    // The variable must not overflow when stepping past the last value.
+    if (end > 0 && (end - 1 > *var_max || *step > *var_max - (end - 1))) {
+        return {};
+    }
+
+    // The step must be the only modification of the variable.
+    if (_usages[var.get()] != 1) {
+        return {};
+    }
+
+    return loop_range{var.get(), end};
+}
+
+//
+// Unit and definitions
+//
+
+void subscript_range_analyzer::visit_unit(unit& unit)
+{
+    visit_namespace(*_unit.get_root_namespace());
+}
+
+void subscript_range_analyzer::visit_namespace(ns& ns)
+{
+    for(auto& child : ns.get_children()) {
+        child->accept(*this);
+    }
+}
+
+void subscript_range_analyzer::visit_structure(structure& st)
+{
+    for(auto& child : st.get_children()) {
+        child->accept(*this);
+    }
+}
+
+void subscript_range_analyzer::visit_function(function& fn)
+{
+    if(auto block = fn.get_block()) {
+        visit_block(*block);
+    }
+}
+
+void subscript_range_analyzer::visit_global_variable_definition(global_variable_definition& var)
+{
+    if(auto expr = var.get_init_expr()) {
+        expr->accept(*this);
+    }
+}
+
+void subscript_range_analyzer::visit_member_variable_definition(member_variable_definition& var)
+{
+    if(auto expr = var.get_init_expr()) {
+        expr->accept(*this);
+    }
+}
+
+//
+// Statements
+//
+
+void subscript_range_analyzer::visit_block(block& block)
+{
+    for(auto& stmt : block.get_statements()) {
+        stmt->accept(*this);
+    }
+}
+
+void subscript_range_analyzer::visit_return_statement(return_statement& stmt)
+{
+    if(auto expr = stmt.get_expression()) {
+        expr->accept(*this);
+    }
+}
+
+void subscript_range_analyzer::visit_if_else_statement(if_else_statement& stmt)
+{
+    stmt.get_test_expr()->accept(*this);
+    stmt.get_then_stmt()->accept(*this);
+    if(auto else_stmt = stmt.get_else_stmt()) {
+        else_stmt->accept(*this);
+    }
+}
+
+void subscript_range_analyzer::visit_while_statement(while_statement& stmt)
+{
+    stmt.get_test_expr()->accept(*this);
+    stmt.get_nested_stmt()->accept(*this);
+}
+
+void subscript_range_analyzer::visit_for_statement(for_statement& stmt)
+{
+    if(auto decl = stmt.get_decl_stmt()) {
+        decl->accept(*this);
+    }
+    if(auto expr = stmt.get_test_expr()) {
+        expr->accept(*this);
+    }
+    if(auto step = stmt.get_step_expr()) {
+        step->accept(*this);
+    }
+
+    std::optional<loop_range> range;
+    if (_phase == MARK_SUBSCRIPTS) {
+        range = get_loop_range(stmt);
+    }
+    if (range) {
+        _ranges.push_back(*range);
+    }
+    stmt.get_nested_stmt()->accept(*this);
+    if (range) {
+        _ranges.pop_back();
+    }
+}
+
+void subscript_range_analyzer::visit_expression_statement(expression_statement& stmt)
+{
+    if(auto expr = stmt.get_expression()) {
+        expr->accept(*this);
+    }
+}
+
+void subscript_range_analyzer::visit_variable_statement(variable_statement& var)
+{
+    if(auto expr = var.get_init_expr()) {
+        expr->accept(*this);
+    }
+}
+
+//
+// Expressions
+//
+
+void subscript_range_analyzer::visit_symbol_expression(symbol_expression& symbol)
+{
+    // Plain reads are handled by load-value expressions, any other usage may modify the variable.
+    if (_phase == COLLECT_USAGES) {
+        if (auto var = symbol.get_variable_def()) {
+            _usages[var.get()]++;
+        }
+    }
+}
+
+void subscript_range_analyzer::visit_unary_expression(unary_expression& expr)
+{
+    if(auto& sub = expr.sub_expr()) {
+        sub->accept(*this);
+    }
+}
+
+void subscript_range_analyzer::visit_binary_expression(binary_expression& expr)
+{
+    if(auto& left = expr.left()) {
+        left->accept(*this);
+    }
+    if(auto& right = expr.right()) {
+        right->accept(*this);
+    }
+}
+
+void subscript_range_analyzer::visit_load_value_expression(load_value_expression& expr)
+{
+    if (std::dynamic_pointer_cast<symbol_expression>(expr.sub_expr())) {
+        // Plain read of a variable
+        return;
+    }
+    visit_unary_expression(expr);
+}
+
+void subscript_range_analyzer::visit_subscript_expression(subscript_expression& expr)
+{
+    visit_binary_expression(expr);
+    if (_phase != MARK_SUBSCRIPTS) {
+        return;
+    }
+
+    // Only sized arrays have known bounds.
+    auto array_type = expr.left()->get_type();
+    while (type::is_reference(array_type)) {
+        array_type = array_type->get_subtype();
+    }
+    auto sized_array = std::dynamic_pointer_cast<sized_array_type>(array_type);
+    if (!sized_array) {
+        return;
+    }
+    uint64_t size = sized_array->get_size();
+
+    if (auto index = get_integer_constant(expr.right())) {
+        expr.set_index_in_bounds(*index < size);
+        return;
+    }
+    for (const auto& range : _ranges) {
+        if (range.end <= size && get_read_variable(expr.right(), range.end > 0 ? range.end - 1 : 0).get() == range.variable) {
+            expr.set_index_in_bounds(true);
+            return;
+        }
+    }
+}
+
+void subscript_range_analyzer::visit_function_invocation_expression(function_invocation_expression& expr)
+{
+    expr.callee_expr()->accept(*this);
+    for(auto& arg : expr.arguments()) {
+        arg->accept(*this);
+    }
+}
+
+} // k::model::gen
@@ -0,0 +1,135 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef KLANG_SUBSCRIPT_RANGE_ANALYZER_HPP
+#define KLANG_SUBSCRIPT_RANGE_ANALYZER_HPP
+
+#include "../model/model.hpp"
+#include "../model/model_visitor.hpp"
+
+#include "../model/context.hpp"
+
+#include <map>
+#include <optional>
+#include <vector>
+
+namespace k::model::gen {
+
+/**
+ * Subscript range analyzer
+ * This helper class proves that some sized array subscripts are in bounds and marks them as such
+ * (see subscript_expression::is_index_in_bounds()), so no runtime check is generated for them.
+ * An index is proven in bounds when it is:
+ * - an integer constant lower than the array size,
+ * - the variable of an enclosing counted "for" loop whose upper bound does not exceed the array size.
+ * A counted loop declares an integer variable initialized with a constant, tests it with "<" or "<=" against
+ * a constant and increments it by a positive constant ("i += c" or "i = i + c").
+ * The variable must not be modified, bound to a reference nor have its address taken anywhere else,
+ * so it keeps its range in the whole loop body.
+ * It must be run after type resolution and before code generation.
+ */
+class subscript_range_analyzer : public default_model_visitor {
+protected:
+
+    std::shared_ptr<context> _context;
+
+    unit& _unit;
+
+    /** Range of the variable of a counted loop, valid in the loop body. */
+    struct loop_range {
+        const variable_definition* variable;
+        /** Exclusive upper bound of the variable. */
+        uint64_t end;
+    };
+
+    enum {
+        /** Count variable usages which are not plain reads. */
+        COLLECT_USAGES,
+        /** Find counted loops and mark the subscripts they make in bounds. */
+        MARK_SUBSCRIPTS
+    } _phase = COLLECT_USAGES;
+
+    /** Number of usages of variables which are not plain reads (assignation, reference, address...). */
+    std::map<const variable_definition*, unsigned int> _usages;
+
+    /** Ranges of the variables of the enclosing counted loops. */
+    std::vector<loop_range> _ranges;
+
+public:
+
+    subscript_range_analyzer(std::shared_ptr<context> context, unit& unit) :
+    _context(context),
+    _unit(unit) {
+    }
+
+    void analyze();
+
+protected:
+
+    /**
+     * Maximal value of an integer type, capped to 64 bits.
+     * @return Maximal value, nothing if the type is not a primitive integer type.
+     */
+    static std::optional<uint64_t> get_max_value(const std::shared_ptr<const type>& type);
+
+    /**
+     * Value of an integer constant expression: an integer literal, possibly cast without losing its value.
+     * @return Constant value, nothing if the expression is not an integer constant.
+     */
+    static std::optional<uint64_t> get_integer_constant(const std::shared_ptr<expression>& expr);
+
+    /**
+     * Variable read by an expression: the loaded value of a variable, possibly cast to integer types able
+     * to represent all values up to a limit.
+     * @return Read variable, null if the expression is not a variable read.
+     */
+    static std::shared_ptr<variable_definition> get_read_variable(const std::shared_ptr<expression>& expr, uint64_t limit);
+
+    /**
+     * Compute the range of the variable of a counted loop.
+     * @return Range of the loop variable in its body, nothing if the loop is not a counted one.
+     */
+    std::optional<loop_range> get_loop_range(for_statement& stmt);
+
+    void visit_unit(unit&) override;
+
+    void visit_namespace(ns&) override;
+    void visit_structure(structure&) override;
+    void visit_function(function&) override;
+    void visit_global_variable_definition(global_variable_definition&) override;
+    void visit_member_variable_definition(member_variable_definition&) override;
+
+    void visit_block(block&) override;
+    void visit_return_statement(return_statement&) override;
+    void visit_if_else_statement(if_else_statement&) override;
+    void visit_while_statement(while_statement&) override;
+    void visit_for_statement(for_statement&) override;
+    void visit_expression_statement(expression_statement&) override;
+    void visit_variable_statement(variable_statement&) override;
+
+    void visit_symbol_expression(symbol_expression&) override;
+    void visit_unary_expression(unary_expression&) override;
+    void visit_binary_expression(binary_expression&) override;
+    void visit_load_value_expression(load_value_expression&) override;
+    void visit_subscript_expression(subscript_expression&) override;
+    void visit_function_invocation_expression(function_invocation_expression&) override;
+};
+
+} // k::model::gen
+
+#endif //KLANG_SUBSCRIPT_RANGE_ANALYZER_HPP
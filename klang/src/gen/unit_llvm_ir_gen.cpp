@@ -22,12 +22,13 @@
 
 #include <llvm/IR/Verifier.h>
 
-#include "llvm/Transforms/InstCombine/InstCombine.h"
-#include "llvm/Transforms/Scalar.h"
-#include "llvm/Transforms/Scalar/GVN.h"
+#include "llvm/Passes/PassBuilder.h"
 
 #include "llvm/Target/TargetMachine.h"
 
+#include <llvm/ExecutionEngine/Orc/EPCEHFrameRegistrar.h>
+#include <llvm/ExecutionEngine/Orc/ObjectLinkingLayer.h>
+
 namespace k {
 class compiler;
 }
@@ -49,13 +50,21 @@ generation_error::generation_error(const char *string) :
 // LLVM model generator
 //
 
-unit_llvm_ir_gen::unit_llvm_ir_gen(k::log::logger& logger, std::shared_ptr<context> context, unit& unit):
+unit_llvm_ir_gen::unit_llvm_ir_gen(k::log::logger& logger, std::shared_ptr<context> context, unit& unit, llvm::TargetMachine* target):
 lexeme_logger(logger, 0x40000),
 _context(context),
 _unit(unit)
 {
     _builder = std::make_unique<llvm::IRBuilder<>>(**_context);
     context->init_module(unit.get_unit_name());
+    if (target) {
+        get_module().setDataLayout(target->createDataLayout());
+        get_module().setTargetTriple(target->getTargetTriple().getTriple());
+        _target_cpu = target->getTargetCPU().str();
+        _target_features = target->getTargetFeatureString().str();
+        const auto& triple = target->getTargetTriple();
+        _sysv_struct_abi = triple.getArch() == llvm::Triple::x86_64 && !triple.isOSWindows();
+    }
 }
 
 llvm::Module& unit_llvm_ir_gen::get_module() {
@@ -71,58 +80,543 @@ void unit_llvm_ir_gen::verify() {
 }
 
 
-void unit_llvm_ir_gen::optimize_functions() {
-    // TODO switch to new pass manager
-    std::shared_ptr<llvm::legacy::FunctionPassManager> passes;
+void unit_llvm_ir_gen::optimize(optimization_level level, llvm::TargetMachine* target) {
+    optimize_module(_context->module(), level, target);
+}
+
+void unit_llvm_ir_gen::optimize_module(llvm::Module& module, optimization_level level, llvm::TargetMachine* target) {
+    llvm::OptimizationLevel llvm_level;
+    switch (level) {
+        case optimization_level::O0:
+            return;
+        case optimization_level::O1:
+            llvm_level = llvm::OptimizationLevel::O1;
+            break;
+        case optimization_level::O2:
+            llvm_level = llvm::OptimizationLevel::O2;
+            break;
+        case optimization_level::O3:
+            llvm_level = llvm::OptimizationLevel::O3;
+            break;
+        case optimization_level::Os:
+            llvm_level = llvm::OptimizationLevel::Os;
+            break;
+        case optimization_level::Oz:
+            llvm_level = llvm::OptimizationLevel::Oz;
+            break;
+    }
+
+    // Vectorize and unroll loops from O2, as clang does.
+    llvm::PipelineTuningOptions options;
+    bool vectorize = level != optimization_level::O1 && level != optimization_level::Oz;
+    options.LoopVectorization = vectorize;
+    options.SLPVectorization = vectorize;
+    options.LoopUnrolling = level != optimization_level::O1;
 
-    // Initialize Function pass manager
-    passes = std::make_shared<llvm::legacy::FunctionPassManager>(&_context->module());
-    // Do simple "peephole" optimizations and bit-twiddling options.
-    passes->add(llvm::createInstructionCombiningPass());
-    // Re-associate expressions.
-    passes->add(llvm::createReassociatePass());
-    // Eliminate Common SubExpressions.
-    passes->add(llvm::createGVNPass());
-    // Eliminate chains of dead computations.
-    passes->add(llvm::createDeadCodeEliminationPass());
-    // Simplify the control flow graph (deleting unreachable blocks, etc).
-    passes->add(llvm::createCFGSimplificationPass());
+    llvm::LoopAnalysisManager lam;
+    llvm::FunctionAnalysisManager fam;
+    llvm::CGSCCAnalysisManager cgam;
+    llvm::ModuleAnalysisManager mam;
 
-    passes->doInitialization();
+    llvm::PassBuilder builder(target, options);
+    builder.registerModuleAnalyses(mam);
+    builder.registerCGSCCAnalyses(cgam);
+    builder.registerFunctionAnalyses(fam);
+    builder.registerLoopAnalyses(lam);
+    builder.crossRegisterProxies(lam, fam, cgam, mam);
 
-    for(auto& func : _context->module()) {
-        passes->run(func);
-    }
+    llvm::ModulePassManager passes = builder.buildPerModuleDefaultPipeline(llvm_level);
+    passes.run(module, mam);
 }
 
 //
 // LLVM JIT
 //
 
-unit_llvm_jit::unit_llvm_jit(std::shared_ptr<compiler> compiler) :
+static std::unique_ptr<jit_object_cache> create_object_cache(const std::shared_ptr<compiler>& compiler, const jit_options& options) {
+    if (options.cache_directory.empty()) {
+        return nullptr;
+    }
+    auto target_builder = llvm::cantFail(compiler->get_jit_target_machine_builder(), "Cannot detect JIT host");
+    return std::make_unique<jit_object_cache>(options.cache_directory, options.cache_max_size,
+                                              jit_object_cache::target_key(target_builder, compiler->get_optimization_level()));
+}
+
+/**
+ * Whether JITLink supports a target, as decided by LLJIT itself: RuntimeDyld is used on other targets.
+ */
+static bool is_jitlink_supported(const llvm::Triple& triple) {
+    switch (triple.getArch()) {
+        case llvm::Triple::riscv64:
+        case llvm::Triple::loongarch64:
+            return true;
+        case llvm::Triple::x86_64:
+        case llvm::Triple::aarch64:
+            return !triple.isOSBinFormatCOFF();
+        case llvm::Triple::arm:
+        case llvm::Triple::armeb:
+        case llvm::Triple::thumb:
+        case llvm::Triple::thumbeb:
+            return triple.isOSBinFormatELF();
+        case llvm::Triple::ppc64:
+            return triple.isPPC64ELFv2ABI();
+        case llvm::Triple::ppc64le:
+            return triple.isOSBinFormatELF();
+        default:
+            return false;
+    }
+}
+
+template<typename Builder>
+static Builder& configure_lljit_builder(Builder& builder, const std::shared_ptr<compiler>& compiler, const jit_options& options,
+                                        jit_object_cache* cache, const std::shared_ptr<jit_memory_accounting>& memory) {
+    builder.setJITTargetMachineBuilder(llvm::cantFail(compiler->get_jit_target_machine_builder(), "Cannot detect JIT host"));
+    if (options.compile_threads > 0) {
+        // LLJIT dispatches session tasks to a pool of this size.
+        builder.setNumCompileThreads(options.compile_threads);
+    }
+    builder.setObjectLinkingLayerCreator([options, memory](llvm::orc::ExecutionSession& session, const llvm::Triple& triple)
+            -> llvm::Expected<std::unique_ptr<llvm::orc::ObjectLayer>> {
+        if (options.debugger || !is_jitlink_supported(triple)) {
+            // The GDB registration listener is only available to RuntimeDyld, which also handles targets JITLink does not.
+            auto layer = std::make_unique<llvm::orc::RTDyldObjectLinkingLayer>(session, [memory]() {
+                return jit_memory_accounting::create_rtdyld_memory_manager(memory);
+            });
+            if (options.debugger) {
+                layer->registerJITEventListener(*llvm::JITEventListener::createGDBRegistrationListener());
+            }
+            return layer;
+        }
+        auto memory_manager = jit_memory_accounting::create_jitlink_memory_manager(memory, options.memory_slab_size);
+        if (!memory_manager) {
+            return memory_manager.takeError();
+        }
+        auto layer = std::make_unique<llvm::orc::ObjectLinkingLayer>(session, std::move(*memory_manager));
+        auto eh_frame_registrar = llvm::orc::EPCEHFrameRegistrar::Create(session);
+        if (!eh_frame_registrar) {
+            return eh_frame_registrar.takeError();
+        }
+        layer->addPlugin(std::make_unique<llvm::orc::EHFrameRegistrationPlugin>(session, std::move(*eh_frame_registrar)));
+        return layer;
+    });
+    if (cache) {
+        bool concurrent = options.compile_threads > 0;
+        builder.setCompileFunctionCreator([cache, concurrent](llvm::orc::JITTargetMachineBuilder target_builder)
+                -> llvm::Expected<std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>> {
+            if (concurrent) {
+                // Creates a target machine per compilation, as target machines cannot be shared between threads.
+                return std::make_unique<llvm::orc::ConcurrentIRCompiler>(std::move(target_builder), cache);
+            }
+            auto target = target_builder.createTargetMachine();
+            if (!target) {
+                return target.takeError();
+            }
+            return std::make_unique<llvm::orc::TMOwningSimpleCompiler>(std::move(*target), cache);
+        });
+    }
+    return builder;
+}
+
+static std::unique_ptr<llvm::orc::LLJIT> create_lljit(const std::shared_ptr<compiler>& compiler, const jit_options& options,
+                                                      jit_object_cache* cache, const std::shared_ptr<jit_memory_accounting>& memory) {
+    if (options.lazy && !options.tiered && !options.reloadable) {
+        llvm::orc::LLLazyJITBuilder builder;
+        auto lljit = llvm::cantFail(configure_lljit_builder(builder, compiler, options, cache, memory).create(), "Cannot instantiate lazy JIT stack");
+        // Compile only the requested function, not the whole module, on first call.
+        lljit->setPartitionFunction(llvm::orc::CompileOnDemandLayer::compileRequested);
+        return lljit;
+    }
+    llvm::orc::LLJITBuilder builder;
+    return llvm::cantFail(configure_lljit_builder(builder, compiler, options, cache, memory).create(), "Cannot instantiate JIT stack");
+}
+
+unit_llvm_jit::unit_llvm_jit(std::shared_ptr<compiler> compiler, const jit_options& options) :
         _compiler(compiler),
-        _lljit(llvm::cantFail(llvm::orc::LLJITBuilder().create(), "Cannot instantiate JIT stack")),
+        _options(options),
+        _object_cache(create_object_cache(compiler, options)),
+        _memory(std::make_shared<jit_memory_accounting>(options.memory_limit)),
+        _lljit(create_lljit(compiler, options, _object_cache.get(), _memory)),
         _main_dynlib(_lljit->getMainJITDylib())
  {
     _main_dynlib.addGenerator(llvm::cantFail(llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(_lljit->getDataLayout().getGlobalPrefix())));
+    if (options.perf_map) {
+        auto& layer = _lljit->getObjLinkingLayer();
+        if (auto linking_layer = llvm::dyn_cast<llvm::orc::ObjectLinkingLayer>(&layer)) {
+            linking_layer->addPlugin(jit_perf_map::create_plugin());
+        } else if (auto rtdyld_layer = llvm::dyn_cast<llvm::orc::RTDyldObjectLinkingLayer>(&layer)) {
+            rtdyld_layer->registerJITEventListener(jit_perf_map::get_listener());
+        }
+    }
+    if (is_lazy()) {
+        // Partitions extracted by the compile on demand layer are optimized on their way to the compile layer.
+        _lljit->getIRTransformLayer().setTransform([this](llvm::orc::ThreadSafeModule module, llvm::orc::MaterializationResponsibility&) {
+            return optimize_partition(std::move(module));
+        });
+    }
+    if (options.tiered || options.reloadable) {
+        unsigned int threshold = options.tiered ? std::max(options.tier_up_threshold, 1u) : 0;
+        // Tier 0 is not optimized, reloadable modules are optimized once their functions are called through stubs.
+        _indirection = std::make_unique<jit_indirection>(*_lljit, _main_dynlib,
+                llvm::cantFail(compiler->get_jit_target_machine_builder(), "Cannot detect JIT host"),
+                threshold, options.tier_up_level, options.tiered ? optimization_level::O0 : compiler->get_optimization_level());
+    }
 }
 
 unit_llvm_jit::~unit_llvm_jit() {
     finalize_runtime();
 }
 
-std::unique_ptr<unit_llvm_jit> unit_llvm_jit::create(std::shared_ptr<compiler> compiler) {
-    return std::unique_ptr<unit_llvm_jit>(new unit_llvm_jit(compiler));
+std::unique_ptr<unit_llvm_jit> unit_llvm_jit::create(std::shared_ptr<compiler> compiler, const jit_options& options) {
+    return std::unique_ptr<unit_llvm_jit>(new unit_llvm_jit(compiler, options));
+}
+
+bool unit_llvm_jit::optimizes_modules(const llvm::orc::JITDylib& library) const {
+    if (_indirection) {
+        // Modules are optimized after adding function stubs (tier 0 is not optimized at all in tiered mode).
+        return &library == &_main_dynlib;
+    }
+    return is_lazy();
+}
+
+llvm::Expected<llvm::TargetMachine*> unit_llvm_jit::get_partition_target() {
+    std::lock_guard<std::mutex> lock(_partition_targets_mutex);
+    auto& target = _partition_targets[std::this_thread::get_id()];
+    if (!target) {
+        auto target_builder = _compiler->get_jit_target_machine_builder();
+        if (!target_builder) {
+            return target_builder.takeError();
+        }
+        auto created = target_builder->createTargetMachine();
+        if (!created) {
+            return created.takeError();
+        }
+        target = std::move(*created);
+    }
+    return target.get();
+}
+
+llvm::Expected<llvm::orc::ThreadSafeModule> unit_llvm_jit::optimize_partition(llvm::orc::ThreadSafeModule module) {
+    // Partitions may be optimized concurrently, on compile threads: each thread uses its own target machine.
+    auto target = get_partition_target();
+    if (!target) {
+        return target.takeError();
+    }
+    module.withModuleDo([&](llvm::Module& mod) {
+        unit_llvm_ir_gen::optimize_module(mod, _compiler->get_optimization_level(), *target);
+        if (!_options.track_compiled_functions) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(_compiled_functions_mutex);
+        for (const auto& func : mod) {
+            if (!func.isDeclaration()) {
+                _compiled_functions.insert(func.getName().str());
+            }
+        }
+    });
+    return std::move(module);
 }
 
-void unit_llvm_jit::add_module(llvm::orc::ThreadSafeModule module) {
-    if (_lljit->addIRModule(std::move(module))) {
-        std::cerr << "Cannot register module in JIT instance." << std::endl;
+unit_llvm_jit::module_handle unit_llvm_jit::add_module(llvm::orc::ThreadSafeModule module, llvm::orc::JITDylib& library, std::shared_ptr<compiler> compiler) {
+    auto tracker = library.createResourceTracker();
+    llvm::Error err = _indirection && &library == &_main_dynlib
+            ? _indirection->add_module(std::move(module), tracker)
+            : _options.lazy && !_indirection
+            ? static_cast<llvm::orc::LLLazyJIT&>(*_lljit).getCompileOnDemandLayer().add(tracker, std::move(module))
+            : _lljit->addIRModule(tracker, std::move(module));
+    if (err) {
+        std::cerr << "Cannot register module in JIT instance: " << llvm::toString(std::move(err)) << std::endl;
+        return nullptr;
     }
+
+    std::unique_lock<std::shared_mutex> lock(_modules_mutex);
+    _modules.emplace_back(tracker, std::move(compiler));
+    return tracker;
 }
 
-llvm::Expected<llvm::orc::ExecutorAddr> unit_llvm_jit::lookup_symbol_address(const std::string& name) {
-    return _lljit->lookup(_main_dynlib, llvm::StringRef( (name.starts_with("_K") ? name : _compiler->get_element_mangled_name(name)) ));
+llvm::orc::JITDylib* unit_llvm_jit::get_library(const std::string& name) {
+    return name.empty() ? &_main_dynlib : _lljit->getExecutionSession().getJITDylibByName(name);
+}
+
+bool unit_llvm_jit::create_library(const std::string& name, const std::vector<std::string>& dependencies) {
+    if (get_library(name)) {
+        std::cerr << "JIT library '" << name << "' already exists." << std::endl;
+        return false;
+    }
+
+    std::vector<llvm::orc::JITDylib*> links;
+    for (const auto& dependency : dependencies) {
+        auto* dylib = get_library(dependency);
+        if (!dylib) {
+            std::cerr << "Unknown JIT library '" << dependency << "'." << std::endl;
+            return false;
+        }
+        links.push_back(dylib);
+    }
+
+    // Created with platform and process symbols libraries in its link order.
+    auto library = _lljit->createJITDylib(name);
+    if (!library) {
+        std::cerr << "Cannot create JIT library '" << name << "': " << llvm::toString(library.takeError()) << std::endl;
+        return false;
+    }
+    // Dependencies are searched before process symbols.
+    llvm::orc::JITDylibSearchOrder order;
+    order.emplace_back(&*library, llvm::orc::JITDylibLookupFlags::MatchAllSymbols);
+    for (auto* dylib : links) {
+        order.emplace_back(dylib, llvm::orc::JITDylibLookupFlags::MatchExportedSymbolsOnly);
+    }
+    library->withLinkOrderDo([&](const llvm::orc::JITDylibSearchOrder& defaults) {
+        for (const auto& link : defaults) {
+            if (link.first != &*library) {
+                order.push_back(link);
+            }
+        }
+    });
+    library->setLinkOrder(std::move(order), false);
+
+    _libraries.push_back(&*library);
+    return true;
+}
+
+unit_llvm_jit::module_handle unit_llvm_jit::add_compiler(const std::shared_ptr<compiler>& comp, const std::string& library) {
+    auto* dylib = get_library(library);
+    if (!dylib) {
+        std::cerr << "Unknown JIT library '" << library << "'." << std::endl;
+        return nullptr;
+    }
+
+    auto module = comp->take_module(!optimizes_modules(*dylib));
+    if (!module) {
+        std::cerr << "Cannot generate code for JIT module." << std::endl;
+        return nullptr;
+    }
+
+    auto handle = add_module(std::move(module), *dylib, comp);
+    if (handle && _state == INITIALIZED) {
+        if (auto err = _lljit->initialize(*dylib)) {
+            std::cerr << "Error during JIT module initialization: " << llvm::toString(std::move(err)) << std::endl;
+        }
+    }
+    return handle;
+}
+
+unit_llvm_jit::module_handle unit_llvm_jit::add_precompiled_module(const std::shared_ptr<precompiled_module>& module, const std::string& library) {
+    auto* dylib = get_library(library);
+    if (!dylib) {
+        std::cerr << "Unknown JIT library '" << library << "'." << std::endl;
+        return nullptr;
+    }
+    if (!module || !module->get_object().getBufferSize()) {
+        std::cerr << "Cannot add an empty precompiled module." << std::endl;
+        return nullptr;
+    }
+
+    // Vendors may differ between the host triple of the JIT and the default triple of compilers.
+    llvm::Triple module_triple(module->get_target_triple());
+    const llvm::Triple& jit_triple = _lljit->getTargetTriple();
+    if (module_triple.getArch() != jit_triple.getArch() || module_triple.getOS() != jit_triple.getOS()
+            || module_triple.getObjectFormat() != jit_triple.getObjectFormat()) {
+        std::cerr << "Precompiled module '" << module->get_module_name() << "' is compiled for '" << module_triple.str()
+                  << "', incompatible with JIT target '" << jit_triple.str() << "'." << std::endl;
+        return nullptr;
+    }
+
+    auto tracker = dylib->createResourceTracker();
+    if (auto err = _lljit->addObjectFile(tracker, llvm::MemoryBuffer::getMemBuffer(module->get_object(), false))) {
+        std::cerr << "Cannot register precompiled module in JIT instance: " << llvm::toString(std::move(err)) << std::endl;
+        return nullptr;
+    }
+    {
+        std::unique_lock<std::shared_mutex> lock(_modules_mutex);
+        _precompiled_modules.emplace_back(tracker, module);
+    }
+
+    if (_state == INITIALIZED) {
+        call_functions(*dylib, module->get_initializers());
+    }
+    return tracker;
+}
+
+bool unit_llvm_jit::call_functions(llvm::orc::JITDylib& library, const std::vector<std::string>& names) {
+    bool res = true;
+    for (const auto& name : names) {
+        auto addr = _lljit->lookup(library, name);
+        if (!addr) {
+            std::cerr << "Cannot find JIT function '" << name << "': " << llvm::toString(addr.takeError()) << std::endl;
+            res = false;
+            continue;
+        }
+        addr->toPtr<void(*)()>()();
+    }
+    return res;
+}
+
+bool unit_llvm_jit::remove_module(const module_handle& handle) {
+    if (!handle) {
+        return false;
+    }
+    {
+        std::unique_lock<std::shared_mutex> lock(_modules_mutex);
+        std::erase_if(_modules, [&](const auto& module) { return module.first == handle; });
+        std::erase_if(_precompiled_modules, [&](const auto& module) { return module.first == handle; });
+    }
+    {
+        // Symbols of other modules may have been resolved to the removed ones.
+        std::unique_lock<std::shared_mutex> lock(_symbols_mutex);
+        _symbols.clear();
+    }
+    if (auto err = handle->remove()) {
+        std::cerr << "Cannot remove JIT module: " << llvm::toString(std::move(err)) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool unit_llvm_jit::reload_functions(const std::string_view& source, const std::vector<std::string>& names) {
+    if (!_indirection) {
+        std::cerr << "Reloading functions requires a reloadable or tiered JIT instance." << std::endl;
+        return false;
+    }
+
+    auto comp = _compiler->create_sibling();
+    std::vector<std::string> mangled_names;
+    try {
+        comp->parse_source(source);
+        for (const auto& name : names) {
+            mangled_names.push_back(name.starts_with("_K") ? name : comp->get_element_mangled_name(name));
+        }
+    } catch (const std::runtime_error& e) {
+        std::cerr << "Cannot compile reloaded functions: " << e.what() << std::endl;
+        return false;
+    }
+
+    // Optimized once only the reloaded functions are kept, their callees being called through stubs.
+    auto module = comp->take_module(false);
+    if (!module) {
+        std::cerr << "Cannot generate code for reloaded functions." << std::endl;
+        return false;
+    }
+    if (auto err = _indirection->reload(std::move(module), mangled_names)) {
+        std::cerr << "Cannot reload functions: " << llvm::toString(std::move(err)) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::string unit_llvm_jit::get_symbol_mangled_name(const std::string& name, llvm::orc::JITDylib& library) const {
+    if (name.starts_with("_K")) {
+        return name;
+    }
+
+    // Libraries searched by lookups in the library, in the same order: the library itself then its dependencies.
+    std::vector<const llvm::orc::JITDylib*> order{&library};
+    library.withLinkOrderDo([&](const llvm::orc::JITDylibSearchOrder& links) {
+        for (const auto& link : links) {
+            if (link.first != &library) {
+                order.push_back(link.first);
+            }
+        }
+    });
+
+    std::shared_lock<std::shared_mutex> lock(_modules_mutex);
+    for (const auto* dylib : order) {
+        for (const auto& module : _modules) {
+            if (&module.first->getJITDylib() == dylib && !module.second->find_elements(name).empty()) {
+                return module.second->get_element_mangled_name(name);
+            }
+        }
+        for (const auto& module : _precompiled_modules) {
+            if (&module.first->getJITDylib() != dylib) {
+                continue;
+            }
+            if (auto* symbol = module.second->find_symbol(name)) {
+                return symbol->mangled_name;
+            }
+        }
+    }
+    // Elements of libraries not searched are not visible: their symbol is not resolved from this library.
+    for (const auto& module : _modules) {
+        if (!module.second->find_elements(name).empty()) {
+            return module.second->get_element_mangled_name(name);
+        }
+    }
+    return _compiler->get_element_mangled_name(name);
+}
+
+llvm::Expected<llvm::orc::ExecutorAddr> unit_llvm_jit::lookup_symbol_address(const std::string& name, const std::string& library) {
+    auto* dylib = get_library(library);
+    if (!dylib) {
+        return llvm::make_error<llvm::StringError>("Unknown JIT library '" + library + "'", llvm::inconvertibleErrorCode());
+    }
+
+    {
+        std::shared_lock<std::shared_mutex> lock(_symbols_mutex);
+        auto it = _symbols.find({dylib, name});
+        if (it != _symbols.end()) {
+            return it->second;
+        }
+    }
+
+    auto addr = _lljit->lookup(*dylib, get_symbol_mangled_name(name, *dylib));
+    if (addr) {
+        std::unique_lock<std::shared_mutex> lock(_symbols_mutex);
+        _symbols.emplace(std::make_pair(dylib, name), *addr);
+    }
+    return addr;
+}
+
+std::vector<llvm::orc::ExecutorAddr> unit_llvm_jit::lookup_symbols(const std::vector<std::string>& names, const std::string& library) {
+    std::vector<llvm::orc::ExecutorAddr> addrs(names.size());
+    auto* dylib = get_library(library);
+    if (!dylib) {
+        std::cerr << "Unknown JIT library '" << library << "'." << std::endl;
+        return addrs;
+    }
+
+    // Symbols not resolved yet, with their index in names.
+    std::vector<std::pair<llvm::orc::SymbolStringPtr, size_t>> missing;
+    llvm::orc::SymbolLookupSet lookup_set;
+    {
+        std::shared_lock<std::shared_mutex> lock(_symbols_mutex);
+        for (size_t n = 0; n < names.size(); ++n) {
+            auto it = _symbols.find({dylib, names[n]});
+            if (it != _symbols.end()) {
+                addrs[n] = it->second;
+                continue;
+            }
+            std::string mangled;
+            try {
+                mangled = get_symbol_mangled_name(names[n], *dylib);
+            } catch (const std::runtime_error&) {
+                // Unknown element, left null.
+                continue;
+            }
+            auto symbol = _lljit->mangleAndIntern(mangled);
+            // Weakly referenced, so missing symbols do not fail the whole lookup.
+            lookup_set.add(symbol, llvm::orc::SymbolLookupFlags::WeaklyReferencedSymbol);
+            missing.emplace_back(symbol, n);
+        }
+    }
+    if (missing.empty()) {
+        return addrs;
+    }
+
+    auto symbols = _lljit->getExecutionSession().lookup(llvm::orc::makeJITDylibSearchOrder(dylib), std::move(lookup_set));
+    if (!symbols) {
+        std::cerr << "Symbol lookup error: " << llvm::toString(symbols.takeError()) << std::endl;
+        return addrs;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(_symbols_mutex);
+    for (const auto& [symbol, n] : missing) {
+        auto it = symbols->find(symbol);
+        if (it != symbols->end()) {
+            addrs[n] = it->second.getAddress();
+            _symbols.emplace(std::make_pair(dylib, names[n]), addrs[n]);
+        }
+    }
+    return addrs;
 }
 
 void unit_llvm_jit::initialize_runtime() {
@@ -131,6 +625,14 @@ void unit_llvm_jit::initialize_runtime() {
             if(_lljit->initialize(_main_dynlib)) {
                 std::cerr << "Error during JIT module initialization." << std::endl;
             }
+            for (auto* library : _libraries) {
+                if(_lljit->initialize(*library)) {
+                    std::cerr << "Error during JIT library '" << library->getName() << "' initialization." << std::endl;
+                }
+            }
+            for (const auto& [handle, module] : _precompiled_modules) {
+                call_functions(handle->getJITDylib(), module->get_initializers());
+            }
             _state = INITIALIZED;
             break;
         case INITIALIZED:
@@ -148,6 +650,14 @@ void unit_llvm_jit::finalize_runtime() {
             std::cerr << "Cannot finalize JIT module before initialization." << std::endl;
             break;
         case INITIALIZED:
+            for (auto it = _precompiled_modules.rbegin(); it != _precompiled_modules.rend(); ++it) {
+                call_functions(it->first->getJITDylib(), it->second->get_finalizers());
+            }
+            for (auto it = _libraries.rbegin(); it != _libraries.rend(); ++it) {
+                if(_lljit->deinitialize(**it)) {
+                    std::cerr << "Error during JIT library '" << (*it)->getName() << "' finalization." << std::endl;
+                }
+            }
             if(_lljit->deinitialize(_main_dynlib)) {
                 std::cerr << "Error during JIT module finalization." << std::endl;
             }
@@ -50,6 +50,19 @@
 #include "../lex/lexer.hpp"
 
 #include "../compiler.hpp"
+#include "jit_indirection.hpp"
+#include "jit_memory.hpp"
+#include "jit_object_cache.hpp"
+#include "jit_perf_map.hpp"
+#include "precompiled_module.hpp"
+#include "struct_abi.hpp"
+
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <shared_mutex>
+#include <thread>
 
 
 namespace k {
@@ -80,16 +93,67 @@ protected:
 
     std::stack<std::shared_ptr<structure>> _struct_stack;
 
+    /** Target CPU and features, set as attributes of generated functions if not empty. */
+    std::string _target_cpu;
+    std::string _target_features;
+
+    /** Generate a runtime check of the subscripts of sized arrays not proven in bounds. */
+    bool _checked_subscripts = false;
+
+    /** Pass and return small structures in registers, following the System V x86-64 ABI (see struct_abi). */
+    bool _sysv_struct_abi = false;
+
+    /** Floating point math relaxations of functions not specifying their own ones. */
+    fast_math_flags _fast_math;
+
+    /** Vector lane designated by a lane reference: type and address of the vector, and lane index. */
+    struct vector_lane {
+        llvm::Type* type;
+        llvm::Value* vector;
+        llvm::Value* index;
+    };
+    /** Lanes designated by the lane references of the current function, by reference value. */
+    std::map<llvm::Value*, vector_lane> _vector_lanes;
+
     [[noreturn]] void throw_error(unsigned int code, const lex::opt_ref_any_lexeme& lexeme, const std::string& message, const std::vector<std::string>& args = {}) {
         error(code, lexeme, message, args);
         throw generation_error(message);
     }
 
 public:
-    unit_llvm_ir_gen(k::log::logger& logger, std::shared_ptr<context> context, unit& unit);
+    /**
+     * Create a generator for a unit.
+     * @param target Target machine to generate code for, if any. The module data layout and triple are set from it,
+     * and its CPU and features are set as "target-cpu" and "target-features" function attributes.
+     */
+    unit_llvm_ir_gen(k::log::logger& logger, std::shared_ptr<context> context, unit& unit, llvm::TargetMachine* target = nullptr);
 
     llvm::Module& get_module();
 
+    bool get_checked_subscripts() const {
+        return _checked_subscripts;
+    }
+
+    /**
+     * Check at runtime that subscripts of sized arrays are in bounds, and trap if not.
+     * Subscripts proven in bounds (see subscript_range_analyzer) are not checked.
+     */
+    void set_checked_subscripts(bool checked) {
+        _checked_subscripts = checked;
+    }
+
+    const fast_math_flags& get_fast_math() const {
+        return _fast_math;
+    }
+
+    /**
+     * Floating point math relaxations set on all floating point instructions of functions,
+     * unless they specify their own ones with "[[fast_math]]" or "[[strict_math]]" attributes.
+     */
+    void set_fast_math(const fast_math_flags& flags) {
+        _fast_math = flags;
+    }
+
     void visit_unit(unit &) override;
 
     void visit_namespace(ns &) override;
@@ -165,19 +229,205 @@ public:
 
     void dump();
     void verify();
-    void optimize_functions();
+
+    /**
+     * Optimize the generated module with the standard LLVM pipeline of the given level.
+     * @param level Optimization level, nothing is done for O0.
+     * @param target Target machine used to get target-specific cost models (mostly for vectorizers), can be null.
+     */
+    void optimize(optimization_level level, llvm::TargetMachine* target = nullptr);
+
+    /**
+     * Optimize a module with the standard LLVM pipeline of the given level.
+     * Module-level passes (inliner, IPSCCP, GlobalDCE...) run alongside function and loop passes and vectorizers.
+     */
+    static void optimize_module(llvm::Module& module, optimization_level level, llvm::TargetMachine* target = nullptr);
 
 protected:
     void optimize_function_dead_inst_elimination(llvm::Function& func);
+
+    /**
+     * Tell the optimizer a subscript index proven in bounds is lower than the array size, with an "llvm.assume".
+     * The assumption is made on the index value itself, so it is kept when the variable it is read from is promoted to a register.
+     * @param index Integer index value.
+     * @param size Size of the array.
+     */
+    void assume_index_range(llvm::Value* index, uint64_t size);
+
+    /**
+     * Load the value designated by a reference.
+     * Vector lanes are read by extracting them from the loaded vector.
+     * @param type Type of the referenced value.
+     * @param ref Reference value.
+     */
+    llvm::Value* load_reference(llvm::Type* type, llvm::Value* ref);
+
+    /**
+     * Store a value to the location designated by a reference.
+     * Vector lanes are written by inserting them in the loaded vector, then storing the vector.
+     * @param value Value to store.
+     * @param ref Reference value.
+     */
+    llvm::Value* store_reference(llvm::Value* value, llvm::Value* ref);
+
+    /**
+     * Generate a vector builtin function invocation inline: reductions as llvm.vector.reduce intrinsics
+     * and shuffles as shufflevector instructions.
+     */
+    void process_vector_builtin(function_invocation_expression& expr);
+
+    /**
+     * Generate a loop in rotated form: the test guards the loop entry, then is repeated at the end of the body
+     * to loop back, so loop passes and vectorizers get a canonical loop shape.
+     * @param name Prefix of generated block names.
+     * @param test_expr Test expression, null to loop forever.
+     * @param nested_stmt Loop body.
+     * @param step_expr Step expression evaluated after the body, if any.
+     * @param hints Loop hints, set as "llvm.loop" metadata on the loop back branch.
+     */
+    void gen_rotated_loop(const std::string& name, const std::shared_ptr<expression>& test_expr, statement& nested_stmt,
+                          const std::shared_ptr<expression>& step_expr, const loop_hints& hints);
+
+    /**
+     * Generate a loop test and its branch to the loop body if true, or to the continuation block if false.
+     * @return The branch instruction.
+     */
+    llvm::BranchInst* gen_loop_branch(const std::shared_ptr<expression>& test_expr, llvm::BasicBlock* nested_block, llvm::BasicBlock* cont_block);
+
+    /**
+     * Make "llvm.loop" metadata for loop hints.
+     * @param access_group Access group of the loop memory accesses if they never alias between iterations, null otherwise.
+     */
+    llvm::MDNode* make_loop_metadata(const loop_hints& hints, llvm::MDNode* access_group);
+
+    /**
+     * Types a value is coerced to when passed to or returned from a function.
+     * @return Coerced types, empty if the value is passed as is.
+     */
+    std::vector<llvm::Type*> get_abi_coerced_types(const std::shared_ptr<type>& type);
+
+    /** Passing of a parameter. */
+    struct abi_param {
+        /** Types the parameter is coerced to, passed in registers, empty if passed as is or in memory. */
+        std::vector<llvm::Type*> parts;
+        /** Structure passed in memory, as a "byval" pointer to a copy. */
+        bool in_memory = false;
+    };
+
+    /**
+     * Passing of the parameters of a function.
+     * Parameters are assigned to the System V x86-64 argument registers (6 general purpose and 8 SSE ones) in order.
+     * A structure whose coerced parts do not all fit in the remaining registers is passed in memory instead,
+     * and later parameters can still use the remaining registers, as C compilers do.
+     */
+    std::vector<abi_param> get_abi_params(function& func);
+
+    /**
+     * Return type of a function returning a value coerced to the given types:
+     * the type itself if there is only one, a literal structure of them otherwise.
+     */
+    llvm::Type* get_abi_return_type(const std::vector<llvm::Type*>& parts);
+
+    /**
+     * Raise the alignment of a local storage to the alignment of the type it holds.
+     * Structures with a custom layout (packed or explicitly aligned) have a packed LLVM type, only aligned on 1 byte.
+     */
+    void align_storage(llvm::AllocaInst* alloca, const std::shared_ptr<type>& type);
+
+    /**
+     * Alignment of a field address computed inside a structure with a custom layout.
+     * @return Alignment deduced from the structure alignment and the field offset, none if the address is not
+     * computed from a structure with a custom layout.
+     */
+    std::optional<llvm::Align> get_custom_layout_alignment(llvm::Value* ptr);
+
+    /**
+     * Lower the alignment of loads and stores of fields of structures with a custom layout to their actual one:
+     * field accesses are generated with the natural alignment of field types, which packed fields may not have.
+     */
+    void align_custom_layout_accesses(llvm::Function& func);
+
+    /**
+     * Create a local storage at the beginning of the current function entry block.
+     */
+    llvm::AllocaInst* create_entry_alloca(llvm::Type* type, const std::string& name);
+
+    /**
+     * Store coerced values at their eightbyte offsets in an aggregate storage.
+     */
+    void store_abi_values(llvm::Value* ptr, const std::vector<llvm::Value*>& values);
+
+    /**
+     * Convert an aggregate value to its coerced values, going through memory.
+     */
+    std::vector<llvm::Value*> to_abi_values(llvm::Value* value, llvm::Type* type, const std::vector<llvm::Type*>& parts);
+
+    /**
+     * Convert coerced values back to an aggregate value, going through memory.
+     */
+    llvm::Value* from_abi_values(const std::vector<llvm::Value*>& values, llvm::Type* type);
 };
 
 
 
+/**
+ * Typed handle to a JIT-compiled function.
+ * Handles are plain function pointers: they can be kept by callers to call the function without any lookup.
+ * They are valid as long as the JIT instance they come from is alive.
+ */
+template<typename Signature>
+class function_handle;
+
+template<typename R, typename... Args>
+class function_handle<R(Args...)> {
+public:
+    typedef R (*pointer)(Args...);
+
+protected:
+    pointer _function = nullptr;
+
+public:
+    function_handle() = default;
+    explicit function_handle(pointer function) : _function(function) {}
+
+    explicit operator bool() const {
+        return _function != nullptr;
+    }
+
+    pointer get() const {
+        return _function;
+    }
+
+    R operator()(Args... args) const {
+        return _function(std::forward<Args>(args)...);
+    }
+};
+
+
 class unit_llvm_jit {
+public:
+    /** Handle of a module added to the JIT, to remove it. */
+    typedef llvm::orc::ResourceTrackerSP module_handle;
+
 protected:
+    /** Compiler of the initial module, its settings are used to compile reloaded functions. */
     std::shared_ptr<compiler> _compiler;
+    jit_options _options;
+    /** Persistent object cache, if enabled. Must outlive the JIT stack. */
+    std::unique_ptr<jit_object_cache> _object_cache;
+    /** Memory used by JIT-compiled objects, shared with the memory managers of the JIT stack. */
+    std::shared_ptr<jit_memory_accounting> _memory;
+    /** Mangled names of the functions compiled so far, in lazy mode, if tracked. */
+    std::set<std::string> _compiled_functions;
+    mutable std::mutex _compiled_functions_mutex;
+    /** Target machines optimizing partitions in lazy mode, by thread, as they cannot be shared between threads. */
+    std::map<std::thread::id, std::unique_ptr<llvm::TargetMachine>> _partition_targets;
+    std::mutex _partition_targets_mutex;
+    /** JIT stack, a LLLazyJIT when lazy compilation is enabled. */
     std::unique_ptr<llvm::orc::LLJIT> _lljit;
     llvm::orc::JITDylib &_main_dynlib;
+    /** Function stubs and re-optimization of hot functions, in tiered and reloadable modes. */
+    std::unique_ptr<jit_indirection> _indirection;
 
     enum {
         DEFAULT,
@@ -185,14 +435,71 @@ protected:
         FINALIZED
     } _state = DEFAULT;
 
-    unit_llvm_jit(std::shared_ptr<compiler> compiler);
+    /** Libraries created in addition to the main one, in creation order. */
+    std::vector<llvm::orc::JITDylib*> _libraries;
 
-    friend class k::compiler;
-    static std::unique_ptr<unit_llvm_jit> create(std::shared_ptr<compiler> compiler);
+    /** Modules added to the JIT, with the compilers which generated them, to resolve K names. */
+    std::vector<std::pair<module_handle, std::shared_ptr<compiler>>> _modules;
+    /** Precompiled modules added to the JIT, to resolve K names and run their initializers and finalizers. */
+    std::vector<std::pair<module_handle, std::shared_ptr<precompiled_module>>> _precompiled_modules;
+    mutable std::shared_mutex _modules_mutex;
 
-    llvm::Expected<llvm::orc::ExecutorAddr> lookup_symbol_address(const std::string& name);
+    /** Addresses of already resolved symbols, by library and name given for lookup. */
+    std::map<std::pair<const llvm::orc::JITDylib*, std::string>, llvm::orc::ExecutorAddr> _symbols;
+    mutable std::shared_mutex _symbols_mutex;
 
-    void add_module(llvm::orc::ThreadSafeModule module);
+    unit_llvm_jit(std::shared_ptr<compiler> compiler, const jit_options& options);
+
+    friend class k::compiler;
+    static std::unique_ptr<unit_llvm_jit> create(std::shared_ptr<compiler> compiler, const jit_options& options = {});
+
+    /**
+     * Look up the address of a symbol, from the symbol cache if already resolved.
+     * @param name Mangled name (starting with "_K") or K name of the element.
+     * @param library Name of the library to look into, empty for the main library.
+     * @throw std::runtime_error If the K name does not correspond to exactly one element.
+     */
+    llvm::Expected<llvm::orc::ExecutorAddr> lookup_symbol_address(const std::string& name, const std::string& library = "");
+
+    /**
+     * Mangled name of a symbol, looking for K names in the modules and precompiled modules added to a library,
+     * then to the libraries it depends on, following its link order.
+     * @param library Library the symbol is looked up in.
+     * @throw std::runtime_error If the K name does not correspond to exactly one element.
+     */
+    std::string get_symbol_mangled_name(const std::string& name, llvm::orc::JITDylib& library) const;
+
+    /**
+     * Library of the given name, the main library for an empty name.
+     * @return Library, null if not found.
+     */
+    llvm::orc::JITDylib* get_library(const std::string& name);
+
+    module_handle add_module(llvm::orc::ThreadSafeModule module, llvm::orc::JITDylib& library, std::shared_ptr<compiler> compiler);
+
+    /**
+     * Modules added to the library are optimized by the JIT, so they must be added unoptimized.
+     * In lazy mode, each partition is optimized before being compiled. In tiered and reloadable modes, modules of
+     * the main library are optimized once their exported functions are called through stubs.
+     */
+    bool optimizes_modules(const llvm::orc::JITDylib& library) const;
+
+    /**
+     * Optimize a partition of a module before its compilation, in lazy mode.
+     */
+    llvm::Expected<llvm::orc::ThreadSafeModule> optimize_partition(llvm::orc::ThreadSafeModule module);
+
+    /**
+     * Target machine optimizing partitions on the calling thread, created on the first partition of the thread.
+     */
+    llvm::Expected<llvm::TargetMachine*> get_partition_target();
+
+    /**
+     * Call functions without parameters, in order.
+     * @param names Mangled names of the functions.
+     * @return True if all functions are found.
+     */
+    bool call_functions(llvm::orc::JITDylib& library, const std::vector<std::string>& names);
 
 public:
     ~unit_llvm_jit();
@@ -200,15 +507,151 @@ public:
     void initialize_runtime();
     void finalize_runtime();
 
+    bool is_lazy() const {
+        return _options.lazy && !_indirection;
+    }
+
+    bool is_tiered() const {
+        return _indirection && _options.tiered;
+    }
+
+    bool is_reloadable() const {
+        return _indirection != nullptr;
+    }
+
+    /**
+     * Replace functions by their implementation in a new version of the unit source.
+     * The source is compiled with the settings of the original unit and only the given functions are taken from it:
+     * global variables and other functions stay in place, with their state.
+     * Callers keep calling the same addresses, as calls go through stubs. Requires the reloadable or tiered mode.
+     * @param source New version of the unit source.
+     * @param names K names or mangled names of the functions to replace, their signatures must not change.
+     * @return True if the functions are replaced.
+     */
+    bool reload_functions(const std::string_view& source, const std::vector<std::string>& names);
+
+    bool reload_function(const std::string_view& source, const std::string& name) {
+        return reload_functions(source, {name});
+    }
+
+    /**
+     * Mangled names of the functions compiled so far, in lazy mode, when jit_options::track_compiled_functions is set.
+     * Functions are compiled on their first call, functions never called are not compiled.
+     */
+    std::set<std::string> get_compiled_functions() const {
+        std::lock_guard<std::mutex> lock(_compiled_functions_mutex);
+        return _compiled_functions;
+    }
+
+    /**
+     * Number of functions re-optimized so far, in tiered mode.
+     */
+    size_t get_tiered_up_count() const {
+        return _indirection ? _indirection->get_tiered_up_count() : 0;
+    }
+
+    /**
+     * Block until requested re-optimizations are done, in tiered mode.
+     */
+    void wait_tier_up() {
+        if (_indirection) {
+            _indirection->wait();
+        }
+    }
+
+    /**
+     * Persistent object cache, null if not enabled.
+     */
+    jit_object_cache* get_object_cache() {
+        return _object_cache.get();
+    }
+
+    /**
+     * Object cache hit, miss and eviction counters, all zero if the cache is not enabled.
+     */
+    jit_object_cache::statistics get_cache_statistics() const {
+        return _object_cache ? _object_cache->get_statistics() : jit_object_cache::statistics{};
+    }
+
+    /**
+     * Memory currently used by the code and data of JIT-compiled modules.
+     */
+    jit_memory_usage get_memory_usage() const {
+        return _memory->get_usage();
+    }
+
+    /**
+     * Maximum memory of JIT-compiled modules, 0 for unlimited.
+     */
+    uint64_t get_memory_limit() const {
+        return _memory->get_limit();
+    }
+
+    /**
+     * Create a library (JITDylib), to add modules into.
+     * Symbols not defined by the library are searched, in order, in its dependencies then in the process.
+     * Modules of different libraries can define the same symbols.
+     * @param name Unique name of the library.
+     * @param dependencies Names of the libraries the library depends on.
+     * @return True if the library is created.
+     */
+    bool create_library(const std::string& name, const std::vector<std::string>& dependencies = {});
+
+    /**
+     * Add the module generated by a compiler.
+     * K names of its elements can then be used for lookups. Initializers of the module are run if the runtime
+     * is already initialized.
+     * @param comp Compiler whose source is already parsed, its module is taken away.
+     * @param library Name of the library to add the module into, empty for the main library.
+     * @return Handle of the module, to remove it, null if it cannot be added.
+     */
+    module_handle add_compiler(const std::shared_ptr<compiler>& comp, const std::string& library = "");
+
+    /**
+     * Add a precompiled module, see compiler::gen_precompiled_module().
+     * Its object is linked as is, without generating code. K names of its symbols can then be used for lookups.
+     * Initializers of the module are run if the runtime is already initialized.
+     * @param module Precompiled module, compiled for the architecture and system of the JIT.
+     * @param library Name of the library to add the module into, empty for the main library.
+     * @return Handle of the module, to remove it, null if it cannot be added.
+     */
+    module_handle add_precompiled_module(const std::shared_ptr<precompiled_module>& module, const std::string& library = "");
+
+    /**
+     * Remove a module and release its code and data.
+     * Functions and variables of the module must not be used anymore, neither by the host nor by other modules.
+     * @return True if the module is removed.
+     */
+    bool remove_module(const module_handle& handle);
+
     template<typename T>
-    T lookup_symbol(const std::string& name) {
-        auto symb = lookup_symbol_address(name);
+    T lookup_symbol(const std::string& name, const std::string& library = "") {
+        auto symb = lookup_symbol_address(name, library);
         if (symb) {
-            return lookup_symbol_address(name)->toPtr<T>();
+            return symb->toPtr<T>();
         } else {
+            llvm::consumeError(symb.takeError());
             return nullptr;
         }
     }
+
+    /**
+     * Look up many symbols at once, in a single JIT session lookup.
+     * All the corresponding modules are compiled together, resolved addresses are cached.
+     * @param names Mangled names (starting with "_K") or K names of the elements.
+     * @param library Name of the library to look into, empty for the main library.
+     * @return Address of each symbol, in the order of names, null address for symbols not found.
+     */
+    std::vector<llvm::orc::ExecutorAddr> lookup_symbols(const std::vector<std::string>& names, const std::string& library = "");
+
+    /**
+     * Look up a function and return a typed handle to it.
+     * @return Handle to the function, an empty handle if not found.
+     */
+    template<typename Signature>
+    function_handle<Signature> get_function(const std::string& name, const std::string& library = "") {
+        return function_handle<Signature>(lookup_symbol<typename function_handle<Signature>::pointer>(name, library));
+    }
 };
 
 } // k::model::gen
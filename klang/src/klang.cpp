@@ -18,6 +18,10 @@
 
 #include <iostream>
 
+#include <atomic>
+#include <filesystem>
+#include <map>
+#include <optional>
 #include <string_view>
 #include <vector>
 #include <iostream>
@@ -29,6 +33,7 @@
 #include "compiler.hpp"
 #include "config.h"
 
+#include "common/job_scheduler.hpp"
 #include "common/logger.hpp"
 #include "parse/parser.hpp"
 #include "parse/ast_dump.hpp"
@@ -45,6 +50,7 @@
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetOptions.h"
 #include "llvm/TargetParser/Host.h"
+#include "llvm/TargetParser/Triple.h"
 
 namespace po = boost::program_options;
 
@@ -52,19 +58,46 @@ static std::string read_text_file_content(const std::string& path) {
     std::ostringstream ss;
     std::ifstream input_file(path);
     if (!input_file.is_open()) {
-        std::cerr << "Could not open the file '" << path << "'" << std::endl;
-        exit(EXIT_FAILURE);
+        throw std::runtime_error("Could not open the file '" + path + "'");
     }
     ss << input_file.rdbuf();
     return ss.str();
 }
 
+static std::optional<k::optimization_level> parse_optimization_level(const std::string& level) {
+    static const std::map<std::string, k::optimization_level> levels {
+        {"0", k::optimization_level::O0},
+        {"1", k::optimization_level::O1},
+        {"2", k::optimization_level::O2},
+        {"3", k::optimization_level::O3},
+        {"s", k::optimization_level::Os},
+        {"z", k::optimization_level::Oz}
+    };
+    auto it = levels.find(level);
+    if (it == levels.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
 
 int main(int argc, const char** argv) {
 
     std::string output_file;
     std::vector<std::string> input_files;
     std::string target_triple;
+    std::string march;
+    std::string cpu = "generic";
+    std::string features = "";
+    unsigned int jobs = 1;
+    unsigned int partitions = 1;
+    bool precompile = false;
+    bool checked_subscripts = false;
+    bool reorder_struct_fields = false;
+    bool struct_layout_report = false;
+    bool fast_math = false;
+    std::string fp_math;
+    std::string optimization = "2";
 
     llvm::InitializeAllTargetInfos();
     llvm::InitializeAllTargets();
@@ -76,7 +109,16 @@ int main(int argc, const char** argv) {
     cli_gobal_options.add_options()
             ("help,h", "Display this information.")
             ("version,v", "Display version information.")
-            ("output,o", po::value<std::string>(&output_file), "Place the output into <arg> file.")
+            ("output,o", po::value<std::string>(&output_file), "Place the output into <arg> file. With many input files, link them into this single object file.")
+            ("optimize,O", po::value<std::string>(&optimization)->implicit_value("2"), "Optimization level: 0, 1, 2 (default), 3, s or z.")
+            ("jobs,j", po::value<unsigned int>(&jobs), "Compile up to <arg> input files in parallel (0 for the number of hardware threads).")
+            ("precompile", po::bool_switch(&precompile), "Generate precompiled K modules (.kpm), loadable by the JIT without compiling again, instead of object files.")
+            ("checked-subscripts", po::bool_switch(&checked_subscripts), "Check at runtime that sized array subscripts are in bounds, trap if not.")
+            ("reorder-struct-fields", po::bool_switch(&reorder_struct_fields), "Reorder fields of structures without layout attributes by decreasing alignment, to reduce padding.")
+            ("struct-layout-report", po::bool_switch(&struct_layout_report), "Print the layout of structures: size, alignment and padding of each field.")
+            ("fast-math", po::bool_switch(&fast_math), "Relax floating point math: reassociate, contract, assume no NaN nor infinite...")
+            ("fp-math", po::value<std::string>(&fp_math), "Relax floating point math with a comma-separated list of flags among 'fast', 'reassoc', 'contract', 'nnan', 'ninf', 'nsz', 'arcp' and 'afn'.")
+            ("codegen-partitions", po::value<unsigned int>(&partitions), "Split each module into <arg> partitions optimized and compiled in parallel (0 for the number of hardware threads).")
             ("input-file", po::value<std::vector<std::string>>(&input_files), "input file")
             ;
 
@@ -86,6 +128,9 @@ int main(int argc, const char** argv) {
             ("print-target-triple", "Print the normalized target triple")
             ("print-targets", "Print the registered targets")
             ("target", po::value<std::string>(&target_triple), "Generate code for the given target")
+            ("march", po::value<std::string>(&march), "Generate code for the given architecture or CPU, 'native' for the host CPU and its features")
+            ("mcpu", po::value<std::string>(&cpu), "Generate code for the given CPU, 'native' for the host CPU")
+            ("mattr", po::value<std::string>(&features), "Target specific features (like '+avx2,-avx512f'), 'native' for the host CPU features")
             ;
 
     po::options_description cmdline_options;
@@ -118,23 +163,69 @@ int main(int argc, const char** argv) {
         target_triple = llvm::sys::getDefaultTargetTriple();
     }
 
+    if(march == "native") {
+        if(!vm.count("mcpu")) {
+            cpu = "native";
+        }
+        if(!vm.count("mattr")) {
+            features = "native";
+        }
+    } else if(!march.empty()) {
+        // Either an architecture (as llc -march) or a CPU (as gcc -march)
+        llvm::Triple triple(target_triple);
+        auto arch = llvm::Triple::getArchTypeForLLVMName(march);
+        if(arch != llvm::Triple::UnknownArch) {
+            triple.setArch(arch);
+            target_triple = triple.str();
+        } else if(!vm.count("mcpu")) {
+            cpu = march;
+        }
+    }
+    if(cpu == "native") {
+        cpu = k::compiler::host_cpu_name();
+    }
+    if(features == "native") {
+        features = k::compiler::host_cpu_features();
+    }
+
+    auto optimization_level = parse_optimization_level(optimization);
+    if (!optimization_level) {
+        std::cerr << "Unknown optimization level: " << optimization << std::endl;
+        return -1;
+    }
+
+    k::fast_math_flags fp_flags;
+    if (!fp_math.empty()) {
+        auto flags = k::fast_math_flags::parse(fp_math);
+        if (!flags) {
+            std::cerr << "Unknown floating point math flags: " << fp_math << std::endl;
+            return -1;
+        }
+        fp_flags = *flags;
+    }
+    if (fast_math) {
+        fp_flags = k::fast_math_flags::fast();
+    }
+
     std::string error;
     auto target = llvm::TargetRegistry::lookupTarget(target_triple, error);
     if(!target) {
         std::cerr << "Problem to find target: " << error << std::endl;
     }
 
-    std::string cpu = "generic";
-    std::string features = "";
-
     llvm::TargetOptions target_options;
     std::optional<llvm::Reloc::Model> reloc_model;
-    auto target_machine = target->createTargetMachine(
-            target_triple, cpu,
-            features,
-            target_options,
-            reloc_model);
-
+    // TargetMachine instances are not shareable between threads, each compilation job creates its own.
+    auto create_target_machine = [&]() {
+        return std::unique_ptr<llvm::TargetMachine>(target->createTargetMachine(
+                target_triple, cpu,
+                features,
+                target_options,
+                reloc_model,
+                std::nullopt,
+                k::to_codegen_opt_level(*optimization_level)));
+    };
+    auto target_machine = create_target_machine();
 
     if(vm.count("version")) {
         std::cout << "klangc - K lang compiler " << PROJECT_VER << std::endl;
@@ -153,6 +244,8 @@ int main(int argc, const char** argv) {
 
     if(vm.count("print-target-triple") || vm.count("print-effective-triple")) {
         std::cout << "Target: " << target_machine->getTargetTriple().getTriple() << std::endl;
+        std::cout << "CPU: " << target_machine->getTargetCPU().str() << std::endl;
+        std::cout << "Features: " << target_machine->getTargetFeatureString().str() << std::endl;
         return 4;
     }
 
@@ -162,17 +255,64 @@ int main(int argc, const char** argv) {
         return -1;
     }
 
-    if(input_files.size() > 1) {
-        std::cout << "klangc is supporting only one input file yet. Additional files will be ignored." << std::endl;
+    bool link = input_files.size() > 1 && !output_file.empty();
+    if (link && precompile) {
+        std::cerr << "Cannot precompile many input files into a single module." << std::endl;
+        return -1;
+    }
+
+    // Each input file is compiled by its own compiler, with its own model and LLVM contexts.
+    std::vector<std::shared_ptr<k::compiler>> compilers(input_files.size());
+    std::vector<std::unique_ptr<llvm::TargetMachine>> target_machines(input_files.size());
+    std::atomic<bool> failed = false;
+
+    {
+        k::job_scheduler scheduler(std::min<size_t>(jobs > 0 ? jobs : k::job_scheduler::default_worker_count(), input_files.size()));
+        for (size_t n = 0; n < input_files.size(); ++n) {
+            scheduler.submit([&, n]() {
+                const std::string& input_file = input_files[n];
+                try {
+                    std::string source = read_text_file_content(input_file);
+                    target_machines[n] = create_target_machine();
+                    auto compiler = k::compiler::create(target_machines[n].get());
+                    compiler->set_codegen_partitions(partitions);
+                    compiler->set_checked_subscripts(checked_subscripts);
+                    compiler->set_reorder_struct_fields(reorder_struct_fields);
+                    compiler->set_fast_math(fp_flags);
+                    compiler->parse_source(source, *optimization_level, false);
+                    if (struct_layout_report) {
+                        // Print the whole report at once, as files may be compiled in parallel.
+                        std::ostringstream report;
+                        report << input_file << ":" << std::endl;
+                        compiler->print_struct_layouts(report);
+                        std::cout << report.str() << std::flush;
+                    }
+                    if (link) {
+                        // Keep the compiler alive, its module is linked once all files are compiled.
+                        compilers[n] = compiler;
+                    } else {
+                        std::string object_file = output_file.empty()
+                                ? std::filesystem::path(input_file).replace_extension(precompile ? ".kpm" : ".o").string()
+                                : output_file;
+                        if (!(precompile ? compiler->gen_precompiled_module(object_file) : compiler->gen_object_file(object_file))) {
+                            failed = true;
+                        }
+                    }
+                } catch (const std::exception& e) {
+                    std::cerr << input_file << ": " << e.what() << std::endl;
+                    failed = true;
+                }
+            });
+        }
+        scheduler.wait();
     }
 
-    std::string source = read_text_file_content(input_files[0]);
+    if (failed) {
+        return -1;
+    }
 
-    try {
-        auto compiler = k::compiler::create(target_machine);
-        compiler->parse_source(source, true, false);
-        return compiler->gen_object_file(output_file) ? 0 : -1;
-    } catch(...) {
+    if (link) {
+        return k::compiler::gen_linked_object_file(compilers, output_file) ? 0 : -1;
     }
 
     return 0;
@@ -22,8 +22,12 @@
 #include "expressions.hpp"
 #include "model.hpp"
 #include "llvm/IR/Type.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/TargetSelect.h"
 
+#include <algorithm>
+#include <mutex>
+
 
 namespace k::model {
 
@@ -39,12 +43,15 @@ std::shared_ptr<context> context::create()
 
 context::context()
 {
-    // TODO initialize them only once
-    llvm::InitializeAllTargetInfos();
-    llvm::InitializeAllTargets();
-    llvm::InitializeAllTargetMCs();
-    llvm::InitializeAllAsmPrinters();
-    llvm::InitializeAllAsmParsers();
+    // Target registration is process-wide, do it only once even when contexts are created concurrently.
+    static std::once_flag targets_initialized;
+    std::call_once(targets_initialized, [](){
+        llvm::InitializeAllTargetInfos();
+        llvm::InitializeAllTargets();
+        llvm::InitializeAllTargetMCs();
+        llvm::InitializeAllAsmPrinters();
+        llvm::InitializeAllAsmParsers();
+    });
 
     _context = std::make_unique<llvm::LLVMContext>();
     init();
@@ -72,7 +79,8 @@ void context::init_primitive_types() {
         {primitive_type::UNSIGNED_INT, primitive_type::make_shared(primitive_type::UNSIGNED_INT, true, false, 4*8, llvm::Type::getInt32Ty(**this))},
         {primitive_type::LONG, primitive_type::make_shared(primitive_type::LONG, false, false, 8*8, llvm::Type::getInt64Ty(**this))},
         {primitive_type::UNSIGNED_LONG, primitive_type::make_shared(primitive_type::UNSIGNED_LONG, true, false, 8*8, llvm::Type::getInt64Ty(**this))},
-        // TODO Add 128 bits integers
+        {primitive_type::LONG_LONG, primitive_type::make_shared(primitive_type::LONG_LONG, false, false, 16*8, llvm::Type::getInt128Ty(**this))},
+        {primitive_type::UNSIGNED_LONG_LONG, primitive_type::make_shared(primitive_type::UNSIGNED_LONG_LONG, true, false, 16*8, llvm::Type::getInt128Ty(**this))},
         {primitive_type::FLOAT, primitive_type::make_shared(primitive_type::FLOAT, false, true, 4*8, llvm::Type::getFloatTy(**this))},
         {primitive_type::DOUBLE, primitive_type::make_shared(primitive_type::DOUBLE, false, true, 8*8, llvm::Type::getDoubleTy(**this))}
     });
@@ -80,6 +88,14 @@ void context::init_primitive_types() {
 
 void context::add_struct(std::shared_ptr<struct_type> st_type) {
     _struct_types.insert({st_type->name(), st_type});
+    if (auto llvm_type = st_type->get_llvm_type()) {
+        _llvm_struct_types.insert({llvm_type, st_type});
+    }
+}
+
+std::shared_ptr<struct_type> context::get_struct_type(llvm::Type* llvm_type) const {
+    auto it = _llvm_struct_types.find(llvm_type);
+    return it != _llvm_struct_types.end() ? it->second : nullptr;
 }
 
 std::shared_ptr<primitive_type> context::from_type(primitive_type::PRIMITIVE_TYPE type){
@@ -99,7 +115,8 @@ std::shared_ptr<type> context::from_string(const std::string& type_name) {
             {"unsigned int", primitive_type::UNSIGNED_INT},
             {"long", primitive_type::LONG},
             {"unsigned long", primitive_type::UNSIGNED_LONG},
-            // TODO Add (unsigned) long long
+            {"long long", primitive_type::LONG_LONG},
+            {"unsigned long long", primitive_type::UNSIGNED_LONG_LONG},
             {"float", primitive_type::FLOAT},
             {"double", primitive_type::DOUBLE}
     };        
@@ -129,7 +146,10 @@ std::shared_ptr<type> context::from_type_specifier(const k::parse::ast::type_spe
     if(auto ident = dynamic_cast<const k::parse::ast::identified_type_specifier*>(&type_spec)) {
         return create_unresolved(ident->name.to_name());
     } else if(auto kw = dynamic_cast<const k::parse::ast::keyword_type_specifier*>(&type_spec)) {
-        return from_keyword(kw->keyword);
+        if(kw->is_long_long) {
+            return from_string(kw->is_unsigned ? "unsigned long long" : "long long");
+        }
+        return from_keyword(kw->keyword, kw->is_unsigned);
     } else if(auto ptr = dynamic_cast<const k::parse::ast::pointer_type_specifier*>(&type_spec)) {
         auto subtype = from_type_specifier(*ptr->subtype);
         if(ptr->pointer_type==lex::operator_::STAR) {
@@ -145,6 +165,16 @@ std::shared_ptr<type> context::from_type_specifier(const k::parse::ast::type_spe
         } else {
             return subtype->get_array();
         }
+    } else if(auto vec = dynamic_cast<const k::parse::ast::vector_type_specifier*>(&type_spec)) {
+        auto subtype = from_type_specifier(*vec->subtype);
+        if(!type::is_prim_integer(subtype) && !type::is_prim_float(subtype)) {
+            throw std::runtime_error("Vector lanes must be of integer or floating point primitive type");
+        }
+        auto size = vec->lex_int.to_unsigned_int();
+        if(size == 0) {
+            throw std::runtime_error("Vector must have at least one lane");
+        }
+        return subtype->get_vector(size);
     } else {
         return {};
     }
@@ -165,8 +195,11 @@ std::shared_ptr<type> context::from_literal(const k::lex::any_literal &literal)
             case k::lex::LONG:
                 return from_type(
                         lit.unsigned_num ? primitive_type::UNSIGNED_LONG : primitive_type::LONG);
+            case k::lex::LONGLONG:
+                return from_type(
+                        lit.unsigned_num ? primitive_type::UNSIGNED_LONG_LONG : primitive_type::LONG_LONG);
             default:
-                // TODO Add (unsigned) long long and bigint
+                // TODO Add bigint
                 return {};
         }
     } else if (std::holds_alternative<lex::float_num>(literal)) {
@@ -222,6 +255,25 @@ llvm::Constant* context::get_llvm_constant_from_literal(const k::lex::any_litera
     }
 }
 
+llvm::Constant* context::get_llvm_constant_from_value(const k::value_type &value, const std::shared_ptr<const type>& type) {
+    auto prim = std::dynamic_pointer_cast<const primitive_type>(type);
+    if (!prim) {
+        return nullptr;
+    }
+    llvm::Type* llvm_type = prim->get_llvm_type();
+    return std::visit([&](auto&& val) -> llvm::Constant* {
+        using T = std::decay_t<decltype(val)>;
+        if constexpr (std::is_floating_point_v<T>) {
+            return prim->is_float() ? llvm::ConstantFP::get(llvm_type, (double) val) : nullptr;
+        } else if constexpr (std::is_integral_v<T>) {
+            return prim->is_float() ? nullptr : llvm::ConstantInt::get(llvm_type, (uint64_t) val, std::is_signed_v<T>);
+        } else {
+            // TODO handle other value types
+            return nullptr;
+        }
+    }, value);
+}
+
 std::shared_ptr<unresolved_type> context::create_unresolved(const name& type_id) {
     std::shared_ptr<unresolved_type> res{new unresolved_type(type_id)};
     _unresolved.push_back(res);
@@ -241,38 +293,117 @@ void context::resolve_types() {
     // Resolve structures:
     for(auto& [st_name, st_type] : _struct_types) {
         if (!st_type->is_resolved()) {
-            auto st = st_type->get_struct();
-            std::vector<struct_type::field> fields;
-            std::vector<llvm::Type*> types;
-            std::vector<llvm::Constant*> inits;
-            for(auto [var_name,var] : st->variables()) {
-                auto type = var->get_type();
-                if (!type->is_resolved()) {
-                    // TODO Structure only support primitive types or derivative yet (implicitly resolved)
-                    // So this shall not happen.
-                    throw std::runtime_error("Cannot resolve structure field type: " + type->to_string());
-                }
-                if (auto value_init = std::dynamic_pointer_cast<value_expression>(var->get_init_expr())) {
-                    // TODO HERE EKI !!!
-                    llvm::Constant* init_value = value_init->is_literal() ? get_llvm_constant_from_literal(value_init->any_literal()) : nullptr;
-                    if (init_value == nullptr) {
-                        // Cant generate constant initializer, use 0-based initializer instead
-                        init_value = type->generate_default_value_initializer();
-                    }
-                    inits.push_back(init_value);
-                } else {
-                    inits.push_back(type->generate_default_value_initializer());
-                }
-                fields.emplace_back(fields.size(), var_name, type);
-                types.push_back(get_llvm_type(type));
-            }
-            auto llvm_type = llvm::StructType::create(llvm_context(), llvm::ArrayRef<llvm::Type*>(types), st_name);
-            auto default_const_value = llvm::ConstantStruct::get(llvm::cast<llvm::StructType>(llvm_type), llvm::ArrayRef<llvm::Constant*>(inits));
-            st_type->set_llvm_type(std::move(fields), llvm_type, default_const_value);
+            layout_struct(st_name, st_type);
         }
     }
 }
 
+void context::layout_struct(const std::string& name, const std::shared_ptr<struct_type>& st_type) {
+    auto st = st_type->get_struct();
+    const auto& st_hints = st->get_layout_hints();
+
+    struct field_layout {
+        std::shared_ptr<member_variable_definition> var;
+        llvm::Type* llvm_type;
+        uint64_t size;
+        uint64_t align;
+    };
+
+    // Fields, in declaration order:
+    std::vector<field_layout> fields;
+    bool custom_layout = st_hints.packed || st_hints.align;
+    for(const auto& var : st->get_member_variables()) {
+        auto type = var->get_type();
+        if (!type->is_resolved()) {
+            // TODO Structure only support primitive types or derivative yet (implicitly resolved)
+            // So this shall not happen.
+            throw std::runtime_error("Cannot resolve structure field type: " + type->to_string());
+        }
+        const auto& hints = var->get_layout_hints();
+        llvm::Type* llvm_type = get_llvm_type(type);
+        uint64_t align = (st_hints.packed || hints.packed) ? 1 : get_alignment(type);
+        if (hints.align) {
+            align = std::max<uint64_t>(align, *hints.align);
+        }
+        custom_layout |= hints.packed || hints.align || align != _data_layout.getABITypeAlign(llvm_type).value();
+        fields.push_back({var, llvm_type, _data_layout.getTypeAllocSize(llvm_type), align});
+    }
+
+    // Reorder fields by decreasing alignment, to let smaller fields fill the padding of bigger ones.
+    bool reorder = st_hints.reorder.value_or(_reorder_struct_fields && st_hints.empty());
+    if (reorder) {
+        std::stable_sort(fields.begin(), fields.end(), [](const field_layout& a, const field_layout& b) {
+            return a.align > b.align;
+        });
+    }
+
+    // Compute field offsets:
+    std::vector<struct_type::field> st_fields;
+    std::vector<llvm::Type*> types;
+    std::vector<llvm::Constant*> inits;
+    uint64_t offset = 0;
+    uint64_t st_align = 1;
+    auto add_padding = [&](uint64_t target_offset) {
+        if (custom_layout && target_offset > offset) {
+            // Explicit padding in the packed LLVM structure.
+            auto padding = llvm::ArrayType::get(llvm::Type::getInt8Ty(llvm_context()), target_offset - offset);
+            types.push_back(padding);
+            inits.push_back(llvm::ConstantAggregateZero::get(padding));
+        }
+        offset = target_offset;
+    };
+    for(const auto& field : fields) {
+        add_padding(llvm::alignTo(offset, field.align));
+        st_align = std::max(st_align, field.align);
+
+        auto type = field.var->get_type();
+        llvm::Constant* init_value = nullptr;
+        if (auto value_init = std::dynamic_pointer_cast<value_expression>(field.var->get_init_expr())) {
+            // TODO HERE EKI !!!
+            init_value = value_init->is_literal() ? get_llvm_constant_from_literal(value_init->any_literal()) : nullptr;
+        }
+        if (init_value == nullptr) {
+            // Cant generate constant initializer, use 0-based initializer instead
+            init_value = type->generate_default_value_initializer();
+        }
+
+        st_fields.push_back(struct_type::field{
+            .index = types.size(),
+            .name = field.var->get_short_name(),
+            .field_type = type,
+            .offset = offset,
+            .size = field.size
+        });
+        types.push_back(field.llvm_type);
+        inits.push_back(init_value);
+        offset += field.size;
+    }
+    if (st_hints.align) {
+        st_align = std::max<uint64_t>(st_align, *st_hints.align);
+    }
+    // Tail padding, so arrays of structures keep their elements aligned.
+    add_padding(llvm::alignTo(offset, st_align));
+
+    auto llvm_type = llvm::StructType::create(llvm_context(), llvm::ArrayRef<llvm::Type*>(types), name, custom_layout);
+    auto default_const_value = llvm::ConstantStruct::get(llvm_type, llvm::ArrayRef<llvm::Constant*>(inits));
+    if (!custom_layout) {
+        // Natural layout, as computed by LLVM.
+        offset = _data_layout.getTypeAllocSize(llvm_type);
+        st_align = _data_layout.getABITypeAlign(llvm_type).value();
+    }
+    st_type->set_llvm_type(std::move(st_fields), llvm_type, default_const_value, offset, st_align, custom_layout);
+    _llvm_struct_types.insert({llvm_type, st_type});
+}
+
+uint64_t context::get_alignment(const std::shared_ptr<type>& type) {
+    if (auto st = std::dynamic_pointer_cast<struct_type>(type); st && st->is_resolved()) {
+        return st->get_alignment();
+    } else if (auto arr = std::dynamic_pointer_cast<sized_array_type>(type)) {
+        return get_alignment(arr->get_subtype());
+    }
+    return _data_layout.getABITypeAlign(get_llvm_type(type)).value();
+}
+
 void context::init_module(const std::string& module_name) {
     _module = std::make_unique<llvm::Module>(module_name, *_context);
 }
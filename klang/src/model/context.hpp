@@ -31,6 +31,7 @@
 #include "type.hpp"
 
 
+#include <llvm/IR/DataLayout.h>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
@@ -61,18 +62,27 @@ protected:
     // Types:
     std::map<primitive_type::PRIMITIVE_TYPE, std::shared_ptr<primitive_type>> _primitive_types;
     std::map<std::string, std::shared_ptr<struct_type>> _struct_types;
+    std::map<llvm::Type*, std::shared_ptr<struct_type>> _llvm_struct_types;
     std::vector<std::shared_ptr<unresolved_type>> _unresolved;
 
     // Entities:
     std::map<std::shared_ptr<global_variable_definition>, llvm::GlobalVariable*> _global_vars;
     std::map<std::shared_ptr<function>, llvm::Function*> _functions;
     std::map<std::shared_ptr<parameter>, llvm::AllocaInst*> _parameter_variables;
-    std::map<std::shared_ptr<function>, llvm::AllocaInst*> _function_this_variables;
+    // Parameters which cannot be re-bound (references, 'this') are used directly, without local storage.
+    std::map<std::shared_ptr<parameter>, llvm::Value*> _parameter_values;
+    std::map<std::shared_ptr<function>, llvm::Value*> _function_this_values;
     std::map<std::shared_ptr<variable_statement>, llvm::AllocaInst*> _variables;
 
     // LLVM module
     std::unique_ptr<llvm::Module> _module;
 
+    /** Data layout of the target, used to lay structures out. */
+    llvm::DataLayout _data_layout{""};
+
+    /** Reorder fields of structures without layout attributes by decreasing alignment. */
+    bool _reorder_struct_fields = false;
+
     context();
 
 public:
@@ -95,6 +105,56 @@ public:
 
     llvm::Constant* get_llvm_constant_from_literal(const k::lex::any_literal &literal);
 
+    /**
+     * Generate the constant of a value held by a value expression (not built from a literal).
+     * @param value Value to convert.
+     * @param type Primitive type of the constant.
+     * @return Constant, null if the value or the type is not supported.
+     */
+    llvm::Constant* get_llvm_constant_from_value(const k::value_type &value, const std::shared_ptr<const type>& type);
+
+    const llvm::DataLayout& get_data_layout() const {
+        return _data_layout;
+    }
+
+    /**
+     * Set the data layout of the target, must be set before type resolution.
+     */
+    void set_data_layout(const llvm::DataLayout& layout) {
+        _data_layout = layout;
+    }
+
+    bool get_reorder_struct_fields() const {
+        return _reorder_struct_fields;
+    }
+
+    /**
+     * Reorder the fields of structures by decreasing alignment to reduce padding.
+     * Structures with layout attributes ("packed", "align", "no_reorder") keep their declaration order,
+     * and so must structures shared with other languages.
+     */
+    void set_reorder_struct_fields(bool reorder) {
+        _reorder_struct_fields = reorder;
+    }
+
+    /**
+     * Structure types of the context, by name.
+     */
+    const std::map<std::string, std::shared_ptr<struct_type>>& get_struct_types() const {
+        return _struct_types;
+    }
+
+    /**
+     * Structure type of an LLVM structure type, null if none.
+     */
+    std::shared_ptr<struct_type> get_struct_type(llvm::Type* llvm_type) const;
+
+    /**
+     * Alignment of values of a type, in bytes.
+     * Structures with a custom layout are aligned as specified, not as their (packed) LLVM type.
+     */
+    uint64_t get_alignment(const std::shared_ptr<type>& type);
+
     void resolve_types();
 
     std::shared_ptr<type> resolve_type(const std::shared_ptr<type>& type);
@@ -115,6 +175,12 @@ protected:
 private:
     void init();
     void init_primitive_types();
+
+    /**
+     * Lay a structure out: order its fields, compute their offsets (with packing and alignment attributes)
+     * and create its LLVM type and default initializer.
+     */
+    void layout_struct(const std::string& name, const std::shared_ptr<struct_type>& st_type);
 };
 
 
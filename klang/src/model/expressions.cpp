@@ -452,4 +452,19 @@ void function_invocation_expression::accept(model_visitor &visitor) {
     visitor.visit_function_invocation_expression(*this);
 }
 
+function_invocation_expression::builtin_function function_invocation_expression::builtin_from_name(const name& name) {
+    static const std::map<std::string, builtin_function> builtins {
+            {"reduce_add", VECTOR_REDUCE_ADD},
+            {"reduce_mul", VECTOR_REDUCE_MUL},
+            {"reduce_min", VECTOR_REDUCE_MIN},
+            {"reduce_max", VECTOR_REDUCE_MAX},
+            {"shuffle", VECTOR_SHUFFLE}
+    };
+    if (name.has_root_prefix() || name.size() != 1) {
+        return NO_BUILTIN;
+    }
+    auto it = builtins.find(name.to_string());
+    return it != builtins.end() ? it->second : NO_BUILTIN;
+}
+
 } // namespace k::model
@@ -109,6 +109,7 @@ protected:
 
     friend class gen::symbol_resolver;
     friend class gen::type_reference_resolver;
+    friend class gen::constant_folder;
 
     void set_type(std::shared_ptr<type> type);
 
@@ -157,6 +158,10 @@ public:
         return _literal.value();
     }
 
+    const k::value_type& get_value() const {
+        return _value;
+    }
+
     void set_value(const k::value_type& value) {
         _value = value;
     }
@@ -251,6 +256,7 @@ protected:
 
     friend class gen::symbol_resolver;
     friend class gen::type_reference_resolver;
+    friend class gen::constant_folder;
 
     void assign(const std::shared_ptr<expression> &sub_expr) {
         _sub_expr = sub_expr;
@@ -306,6 +312,7 @@ protected:
     }
 
     friend class gen::type_reference_resolver;
+    friend class gen::constant_folder;
 
     void assign_right(const std::shared_ptr<expression> &right_expr) {
         _right_expr = right_expr;
@@ -1007,6 +1014,9 @@ public:
 
 class subscript_expression : public binary_expression {
 protected:
+    /** Index is proven to be in the bounds of the (sized) array, no runtime check is needed. */
+    bool _index_in_bounds = false;
+
     subscript_expression() = default;
 
     subscript_expression(const std::shared_ptr<expression> &callee_expr,
@@ -1024,14 +1034,42 @@ public:
         expr->assign(left_expr, right_expr);
         return std::shared_ptr<expression>{expr};
     }
+
+    bool is_index_in_bounds() const {
+        return _index_in_bounds;
+    }
+
+    void set_index_in_bounds(bool in_bounds) {
+        _index_in_bounds = in_bounds;
+    }
 };
 
 class function_invocation_expression : public expression {
+public:
+    /**
+     * Functions provided by the compiler, generated inline instead of being called.
+     */
+    enum builtin_function {
+        NO_BUILTIN,
+        /** reduce_add(v): sum of all lanes of a vector. */
+        VECTOR_REDUCE_ADD,
+        /** reduce_mul(v): product of all lanes of a vector. */
+        VECTOR_REDUCE_MUL,
+        /** reduce_min(v): minimum of all lanes of a vector. */
+        VECTOR_REDUCE_MIN,
+        /** reduce_max(v): maximum of all lanes of a vector. */
+        VECTOR_REDUCE_MAX,
+        /** shuffle(v, [w,] i0, i1...): vector of lanes picked from v (then w) by constant indices. */
+        VECTOR_SHUFFLE
+    };
+
 protected:
     /** Callee function to call. */
     std::shared_ptr<expression> _callee_expr;
     /** Right hand sub expression. */
     std::vector<std::shared_ptr<expression>> _arguments;
+    /** Builtin function, if the callee designates one. */
+    builtin_function _builtin = NO_BUILTIN;
 
 
     function_invocation_expression() = default;
@@ -1094,6 +1132,24 @@ public:
         }
     }
 
+    builtin_function get_builtin() const {
+        return _builtin;
+    }
+
+    bool is_builtin() const {
+        return _builtin != NO_BUILTIN;
+    }
+
+    void set_builtin(builtin_function builtin) {
+        _builtin = builtin;
+    }
+
+    /**
+     * Look for the builtin function of the given name.
+     * @return Builtin function or NO_BUILTIN if the name does not designate any.
+     */
+    static builtin_function builtin_from_name(const name& name);
+
     static std::shared_ptr<expression>
     make_shared(const std::shared_ptr<expression> &callee_expr, const std::vector<std::shared_ptr<expression>> &args) {
         std::shared_ptr<function_invocation_expression> expr{new function_invocation_expression()};
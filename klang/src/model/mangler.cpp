@@ -22,7 +22,7 @@
 #include "model.hpp"
 
 #include <iosfwd>
-#include <sstream>
+#include <string_view>
 
 
 #define K_LANG_SYMBOL_PREFIX "_K"
@@ -53,10 +53,15 @@
 #define TYPE_UINT           "j"
 #define TYPE_LONG           "x"
 #define TYPE_ULONG          "y"
+#define TYPE_INT128         "n"
+#define TYPE_UINT128        "o"
 #define TYPE_FLOAT          "f"
 #define TYPE_DOUBLE         "d"
 #define TYPE_LONG_DOUBLE    "e"
 
+#define TYPE_VECTOR                 "Dv"
+#define TYPE_VECTOR_SIZE_SEPARATOR  "_"
+
 
 namespace k::model {
 
@@ -66,16 +71,18 @@ std::string mangler::mangle_short_name(const std::string& short_name) {
 }
 
 std::string mangler::mangle_fq_name(const name& name, bool with_k_prefix) {
-    std::ostringstream mangled;
+    std::string mangled;
+    mangled.reserve(32);
     if (with_k_prefix) {
-        mangled << K_LANG_SYMBOL_PREFIX;
+        mangled += K_LANG_SYMBOL_PREFIX;
     }
-    mangled << SYMBOL_QUALIFIED_PREFIX;
+    mangled += SYMBOL_QUALIFIED_PREFIX;
     for (const auto& part : name.parts()) {
-        mangled << mangle_short_name(part);
+        mangled += std::to_string(part.size());
+        mangled += part;
     }
-    mangled << SYMBOL_QUALIFIED_SUFFIX;
-    return mangled.str();
+    mangled += SYMBOL_QUALIFIED_SUFFIX;
+    return mangled;
 }
 
 std::string mangler::mangle_namespace(const name& ns_name) {
@@ -91,31 +98,30 @@ std::string mangler::mangle_structure(const name& ns_name) {
 }
 
 std::string mangler::mangle_function(const function& func) const {
-    auto name = func.get_name();
+    const auto& name = func.get_name();
     if (!name.has_root_prefix()) {
         // Must be fully qualified name
         return "";
     }
 
-    std::ostringstream mangled;
-    mangled << K_LANG_SYMBOL_PREFIX SYMBOL_TYPE_FUNCTION;
+    std::string mangled = K_LANG_SYMBOL_PREFIX SYMBOL_TYPE_FUNCTION;
 
     if (func.is_member()) {
         // TODO test if static methof
-        mangled << SYMBOL_MEMBER;
+        mangled += SYMBOL_MEMBER;
     }
-    mangled << mangle_fq_name(name, false);
+    mangled += mangle_fq_name(name, false);
 
     if (func.get_parameter_size() == 0) {
-        mangled << TYPE_VOID; // void parameter list
+        mangled += TYPE_VOID; // void parameter list
     } else {
         for(size_t i = 0; i < func.get_parameter_size(); ++i) {
             auto param = func.get_parameter(i);
-            mangled << mangle_type(*param->get_type());
+            mangled += mangle_type(*param->get_type());
         }
     }
 
-    return mangled.str();
+    return mangled;
 }
 
 std::string mangler::mangle_type(const type& ty) const {
@@ -130,6 +136,8 @@ std::string mangler::mangle_type(const type& ty) const {
             case primitive_type::UNSIGNED_INT: return TYPE_UINT;
             case primitive_type::LONG: return TYPE_LONG;
             case primitive_type::UNSIGNED_LONG: return TYPE_ULONG;
+            case primitive_type::LONG_LONG: return TYPE_INT128;
+            case primitive_type::UNSIGNED_LONG_LONG: return TYPE_UINT128;
             case primitive_type::FLOAT: return TYPE_FLOAT;
             case primitive_type::DOUBLE: return TYPE_DOUBLE;
             default:
@@ -140,6 +148,9 @@ std::string mangler::mangle_type(const type& ty) const {
         return SYMBOL_MODIFIER_REF + mangle_type(*ref_ty->get_referenced_type());
     } else if (auto ptr_ty = dynamic_cast<const pointer_type*>(&ty)) {
         return SYMBOL_MODIFIER_PTR + mangle_type(*ptr_ty->get_pointed_type());
+    } else if (auto vec_ty = dynamic_cast<const vector_type*>(&ty)) {
+        // Same encoding than GCC/Clang vector extensions: 'Dv' + lane count + '_' + lane type
+        return TYPE_VECTOR + std::to_string(vec_ty->get_size()) + TYPE_VECTOR_SIZE_SEPARATOR + mangle_type(*vec_ty->get_lane_type());
     } else if (auto struct_ty = dynamic_cast<const struct_type*>(&ty)) {
         auto st = struct_ty->get_struct();
         if (!st) {
@@ -154,6 +165,141 @@ std::string mangler::mangle_type(const type& ty) const {
 
 }
 
+namespace {
+
+/**
+ * Recursive descent parser of mangled names.
+ * Each parsing function returns false (and leaves the position undefined) on invalid input.
+ */
+struct demangler {
+    std::string_view str;
+    size_t pos = 0;
+
+    bool at_end() const {
+        return pos >= str.size();
+    }
+
+    bool consume(std::string_view prefix) {
+        if (str.substr(pos).starts_with(prefix)) {
+            pos += prefix.size();
+            return true;
+        }
+        return false;
+    }
+
+    // 'N' + (length + short name)* + 'E'
+    bool parse_qualified_name(std::string& res) {
+        if (!consume(SYMBOL_QUALIFIED_PREFIX)) {
+            return false;
+        }
+        bool first = true;
+        while (!consume(SYMBOL_QUALIFIED_SUFFIX)) {
+            size_t length = 0;
+            size_t start = pos;
+            while (!at_end() && std::isdigit(static_cast<unsigned char>(str[pos]))) {
+                length = length * 10 + (str[pos++] - '0');
+            }
+            if (pos == start || length == 0 || pos + length > str.size()) {
+                return false;
+            }
+            if (!first) {
+                res += "::";
+            }
+            res += str.substr(pos, length);
+            pos += length;
+            first = false;
+        }
+        return !first;
+    }
+
+    bool parse_type(std::string& res) {
+        static const std::pair<std::string_view, std::string_view> basic_types[] = {
+                {TYPE_VOID, "void"}, {TYPE_BOOL, "bool"}, {TYPE_CHAR, "char"}, {TYPE_UCHAR, "unsigned char"},
+                {TYPE_SHORT, "short"}, {TYPE_USHORT, "unsigned short"}, {TYPE_INT, "int"}, {TYPE_UINT, "unsigned int"},
+                {TYPE_LONG, "long"}, {TYPE_ULONG, "unsigned long"}, {TYPE_INT128, "long long"}, {TYPE_UINT128, "unsigned long long"},
+                {TYPE_FLOAT, "float"}, {TYPE_DOUBLE, "double"},
+                {TYPE_LONG_DOUBLE, "long double"}
+        };
+        static const std::pair<std::string_view, std::string_view> modifiers[] = {
+                {SYMBOL_MODIFIER_PTR, "*"}, {SYMBOL_MODIFIER_REF_LVAL, "&"}, {SYMBOL_MODIFIER_REF_RVAL, "&&"},
+                {SYMBOL_MODIFIER_CONST, " const"}, {SYMBOL_MODIFIER_VOLATILE, " volatile"}, {SYMBOL_MODIFIER_RESTRICT, " restrict"}
+        };
+
+        for (const auto& [code, suffix] : modifiers) {
+            if (consume(code)) {
+                if (!parse_type(res)) {
+                    return false;
+                }
+                res += suffix;
+                return true;
+            }
+        }
+        if (consume(TYPE_VECTOR)) {
+            // 'Dv' + lane count + '_' + lane type
+            size_t start = pos;
+            while (!at_end() && std::isdigit(static_cast<unsigned char>(str[pos]))) {
+                ++pos;
+            }
+            std::string_view size = str.substr(start, pos - start);
+            if (size.empty() || !consume(TYPE_VECTOR_SIZE_SEPARATOR) || !parse_type(res)) {
+                return false;
+            }
+            res += "[[";
+            res += size;
+            res += "]]";
+            return true;
+        }
+        for (const auto& [code, type_name] : basic_types) {
+            if (consume(code)) {
+                res += type_name;
+                return true;
+            }
+        }
+        return parse_qualified_name(res);
+    }
+};
+
+} // anonymous namespace
+
+std::string mangler::demangle(const std::string& mangled) {
+    demangler parser{mangled};
+    if (!parser.consume(K_LANG_SYMBOL_PREFIX)) {
+        return mangled;
+    }
+
+    bool is_function = parser.consume(SYMBOL_TYPE_FUNCTION);
+    if (!is_function) {
+        parser.consume(SYMBOL_TYPE_VARIABLE);
+    }
+    bool is_const = parser.consume(SYMBOL_MODIFIER_CONST);
+    parser.consume(SYMBOL_MEMBER);
 
+    std::string res;
+    if (!parser.parse_qualified_name(res)) {
+        return mangled;
+    }
+    if (!is_function) {
+        return parser.at_end() ? res : mangled;
+    }
+
+    res += '(';
+    if (!parser.consume(TYPE_VOID) || !parser.at_end()) {
+        bool first = true;
+        while (!parser.at_end()) {
+            if (!first) {
+                res += ", ";
+            }
+            if (!parser.parse_type(res)) {
+                return mangled;
+            }
+            first = false;
+        }
+    }
+    res += ')';
+    if (is_const) {
+        res += " const";
+    }
+    return res;
+}
 
 } // k::model
@@ -75,6 +75,9 @@
  * - 'e' for long double (128 bits)
  * Qualified types (e.g., structures) are encoded using the same name mangling scheme as symbol names:
  * 'N' + encoded qualified name + [template parameter] + 'E'
+ *
+ * Demangled names are written as K qualified names, followed by parameter types for functions,
+ * like "test::fibo(unsigned int)" for "_KFN4test4fiboEj".
  */
 namespace k::model {
 
@@ -106,6 +109,12 @@ public:
     static std::string mangle_global_variable(const name& ns_name);
     static std::string mangle_structure(const name& ns_name);
 
+    /**
+     * Demangle a K symbol name.
+     * @param mangled Mangled name.
+     * @return Readable name, or the given name unchanged if it is not a valid K mangled name.
+     */
+    static std::string demangle(const std::string& mangled);
 
 };
 
@@ -39,14 +39,12 @@ static name to_name(const parse::ast::qualified_identifier &ident) {
 //
 // Base model element
 //
-std::shared_ptr<context> element::get_context() {
-    std::shared_ptr<element> current = shared_as<element>();
-    std::shared_ptr<element> parent = _parent;
-    while(parent) {
-        current = parent;
-        parent = parent->_parent;
-    }
-    if (auto root = current->shared_as<unit>()) {
+std::shared_ptr<context> element::get_context() const {
+    const element* current = this;
+    while(current->_parent) {
+        current = current->_parent.get();
+    }
+    if (auto root = dynamic_cast<const unit*>(current)) {
         return root->_context;
     }
     return {};
@@ -56,16 +54,37 @@ std::shared_ptr<context> element::get_context() {
 // Bases of named element
 //
 
-void named_element::update_names() {
-    _short_name = _name.back();
-    if (_name.has_root_prefix()) {
-        _fq_name = _name.to_string();
-        update_mangled_name();
-    } else {
-        _fq_name.clear();
-        _mangled_name.clear();
+std::string named_element::make_mangled_name() const {
+    return "";
+}
+
+const std::string& named_element::get_fq_name() const {
+    if (!_name.has_root_prefix()) {
+        return string_pool::empty();
+    }
+    // Concurrent first requests compute the same interned string, the first one stored is kept.
+    auto fq_name = _fq_name.load(std::memory_order_acquire);
+    if (!fq_name) {
+        auto interned = string_pool::intern(_name.to_string());
+        if (_fq_name.compare_exchange_strong(fq_name, interned, std::memory_order_acq_rel)) {
+            fq_name = interned;
+        }
     }
+    return *fq_name;
+}
 
+const std::string& named_element::get_mangled_name() const {
+    if (!_name.has_root_prefix()) {
+        return string_pool::empty();
+    }
+    auto mangled_name = _mangled_name.load(std::memory_order_acquire);
+    if (!mangled_name) {
+        auto interned = string_pool::intern(make_mangled_name());
+        if (_mangled_name.compare_exchange_strong(mangled_name, interned, std::memory_order_acq_rel)) {
+            mangled_name = interned;
+        }
+    }
+    return *mangled_name;
 }
 
 
@@ -237,10 +256,6 @@ std::shared_ptr<parameter> parameter::make_shared(std::shared_ptr<function> func
     return param;
 }
 
-void parameter::update_mangled_name() {
-    // Parameter is not mangled cause not exported
-}
-
 void parameter::accept(model_visitor& visitor) {
     visitor.visit_parameter(*this);
 }
@@ -255,8 +270,8 @@ std::shared_ptr<function> function::make_shared(std::shared_ptr<element> parent,
     return fn;
 }
 
-void function::update_mangled_name() {
-    _mangled_name = mangler(get_context()).mangle_function(*this);
+std::string function::make_mangled_name() const {
+    return mangler(get_context()).mangle_function(*this);
 }
 
 void function::create_this_parameter() {
@@ -315,12 +330,15 @@ void function::on_variable_defined(std::shared_ptr<variable_definition>) {
 }
 
 std::shared_ptr<parameter> function::append_parameter(const std::string &name, std::shared_ptr<type> type) {
+    // Parameters are part of the mangled name.
+    _mangled_name.store(nullptr);
     auto param = _parameters.emplace_back(parameter::make_shared(shared_as<function>(), name, type, _parameters.size()));
     _vars[name] = param;
     return param;
 }
 
 std::shared_ptr<parameter> function::insert_parameter(const std::string &name, std::shared_ptr<type> type, size_t pos) {
+    _mangled_name.store(nullptr);
     if (pos >= _parameters.size()) {
         size_t idx = _parameters.size();
         while (idx < pos) {
@@ -387,9 +405,9 @@ void global_tool_function::accept(model_visitor &visitor) {
     visitor.visit_global_tool_function(*this);
 }
 
-void global_tool_function::update_mangled_name() {
+std::string global_tool_function::make_mangled_name() const {
     // No mangle for this special functions
-    _mangled_name = get_short_name();
+    return get_short_name();
 }
 
 void global_tool_function::add_global_variable_definition(const std::shared_ptr<global_variable_definition>& gv) {
@@ -397,6 +415,10 @@ void global_tool_function::add_global_variable_definition(const std::shared_ptr<
     _global_vars.insert({gv, {}});
 }
 
+bool global_tool_function::has_global_variable_definition(const std::shared_ptr<global_variable_definition>& gv) const {
+    return _global_vars.find(gv) != _global_vars.end();
+}
+
 std::vector<std::shared_ptr<global_variable_definition>> global_tool_function::get_sorted_global_variables() const {
     std::vector<std::shared_ptr<global_variable_definition>> res;
 
@@ -478,10 +500,6 @@ std::shared_ptr<member_variable_definition> member_variable_definition::make_sha
     return var_def;
 }
 
-void member_variable_definition::update_mangled_name() {
-    // TODO Implement mangling scheme
-}
-
 void member_variable_definition::accept(model_visitor &visitor) {
     visitor.visit_member_variable_definition(*this);
 }
@@ -497,9 +515,9 @@ std::shared_ptr<structure> structure::make_shared(std::shared_ptr<element> paren
     return st;
 }
 
-void structure::update_mangled_name() {
+std::string structure::make_mangled_name() const {
     // Useless but for information
-    _mangled_name = _name.has_root_prefix() ? mangler::mangle_structure(_name) : "";
+    return mangler::mangle_structure(_name);
 }
 
 void structure::accept(model_visitor& visitor) {
@@ -539,6 +557,16 @@ void structure::on_variable_defined(std::shared_ptr<variable_definition> var) {
 }
 
 
+std::vector<std::shared_ptr<member_variable_definition>> structure::get_member_variables() const {
+    std::vector<std::shared_ptr<member_variable_definition>> vars;
+    for(const auto& child : _children) {
+        if(auto var = std::dynamic_pointer_cast<member_variable_definition>(child)) {
+            vars.push_back(var);
+        }
+    }
+    return vars;
+}
+
 std::shared_ptr<variable_definition> structure::lookup_variable(const std::string& name) const {
     // TODO add type checking
     // TODO add qualified name lookup
@@ -566,8 +594,8 @@ std::shared_ptr<global_variable_definition> global_variable_definition::make_sha
     return var_def;
 }
 
-void global_variable_definition::update_mangled_name() {
-    _mangled_name = _name.has_root_prefix() ? mangler::mangle_global_variable(_name) : "";
+std::string global_variable_definition::make_mangled_name() const {
+    return mangler::mangle_global_variable(_name);
 }
 
 
@@ -585,9 +613,9 @@ std::shared_ptr<ns> ns::make_shared(std::shared_ptr<element> parent, const std::
     return nspace;
 }
 
-void ns::update_mangled_name() {
+std::string ns::make_mangled_name() const {
     // Useless but for information
-    _mangled_name = _name.has_root_prefix() ? mangler::mangle_namespace(_name) : "";
+    return mangler::mangle_namespace(_name);
 }
 
 void ns::accept(model_visitor &visitor) {
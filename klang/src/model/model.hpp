@@ -19,8 +19,10 @@
 #ifndef KLANG_MODEL_HPP
 #define KLANG_MODEL_HPP
 
+#include <atomic>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 
@@ -28,6 +30,7 @@
 #include "../parse/ast.hpp"
 #include "../parse/parser.hpp"
 #include "../common/common.hpp"
+#include "../common/string_pool.hpp"
 #include "type.hpp"
 
 
@@ -61,6 +64,7 @@ class global_destructor_function;
 namespace gen {
 class type_reference_resolver;
 class unit_llvm_ir_gen;
+class constant_folder;
 }
 
 enum visibility {
@@ -99,7 +103,7 @@ protected:
 public:
     virtual ~element() = default;
 
-    std::shared_ptr<context> get_context();
+    std::shared_ptr<context> get_context() const;
 
     template<typename T>
     inline std::shared_ptr<T> shared_as() {
@@ -165,26 +169,35 @@ class named_element
 {
 protected:
     name _name;
-    std::string _short_name;
-    std::string _fq_name;
-    std::string _mangled_name;
+    /** Fully qualified and mangled names, computed on first request and interned, null until then. */
+    mutable std::atomic<string_pool::handle> _fq_name;
+    mutable std::atomic<string_pool::handle> _mangled_name;
 
-    virtual void update_names();
-    virtual void update_mangled_name() = 0;
+    /**
+     * Compute the mangled name, when first requested for an element with a fully qualified name.
+     * Elements are not mangled by default, like parameters and local variables.
+     */
+    virtual std::string make_mangled_name() const;
+
+    void reset_names() {
+        _fq_name.store(nullptr);
+        _mangled_name.store(nullptr);
+    }
 
 public:
     named_element() = default;
-    named_element(const named_element&) = default;
-    named_element(named_element&&) = default;
+    named_element(const named_element& other) : _name(other._name) {}
+    named_element(named_element&& other) : _name(std::move(other._name)) {}
+    virtual ~named_element() = default;
 
     void assign_name(const std::string& name) {
         _name = name;
-        update_names();
+        reset_names();
     }
 
     void assign_name(const name& name) {
         _name = name;
-        update_names();
+        reset_names();
     }
 
     named_element& operator=(const std::string& name) {
@@ -202,16 +215,20 @@ public:
     }
 
     const std::string& get_short_name() const {
-        return _short_name;
+        return _name.empty() ? string_pool::empty() : _name.back();
     }
 
-    const std::string& get_fq_name() const {
-        return _fq_name;
-    }
+    /**
+     * Fully qualified name, like "::the::test::plop".
+     * @return The name, empty if the element name is not fully qualified.
+     */
+    const std::string& get_fq_name() const;
 
-    const std::string& get_mangled_name() const {
-        return _mangled_name;
-    }
+    /**
+     * Mangled name, computed from the name and the signature of the element when first requested.
+     * @return The name, empty if the element is not mangled or its name is not fully qualified.
+     */
+    const std::string& get_mangled_name() const;
 };
 
 /**
@@ -306,22 +323,46 @@ protected:
 };
 
 
+/**
+ * Layout controls of a structure or of a structure field, given by attributes like "[[packed, align(16)]]".
+ */
+struct layout_hints {
+    /** No padding before the field, or between the structure fields: alignment is 1 byte unless explicitly aligned. */
+    bool packed = false;
+    /** Minimal alignment, in bytes (power of two). */
+    std::optional<unsigned int> align;
+    /** Reorder (or not) the structure fields by decreasing alignment, regardless of the compiler setting. */
+    std::optional<bool> reorder;
+
+    bool empty() const {
+        return !packed && !align && !reorder;
+    }
+};
+
+
 class member_variable_definition : public element, public variable_definition {
 protected:
 
     friend class structure;
     friend class gen::unit_llvm_ir_gen;
 
+    layout_hints _layout_hints;
+
     member_variable_definition(std::shared_ptr<structure> st);
 
     static std::shared_ptr<member_variable_definition> make_shared(std::shared_ptr<structure> st);
     static std::shared_ptr<member_variable_definition> make_shared(std::shared_ptr<structure> st, const std::string &name);
 
-    void update_mangled_name() override;
-
 public:
     void accept(model_visitor& visitor) override;
 
+    const layout_hints& get_layout_hints() const {
+        return _layout_hints;
+    }
+
+    void set_layout_hints(const layout_hints& hints) {
+        _layout_hints = hints;
+    }
 };
 
 
@@ -336,6 +377,8 @@ protected:
 
     std::shared_ptr<struct_type> _type;
 
+    layout_hints _layout_hints;
+
     structure(std::shared_ptr<element> parent) :
         element(parent) {}
 
@@ -351,7 +394,7 @@ protected:
         _type = st_type;
     }
 
-    void update_mangled_name() override;
+    std::string make_mangled_name() const override;
 
 public:
 
@@ -361,6 +404,19 @@ public:
         return _type;
     }
 
+    const layout_hints& get_layout_hints() const {
+        return _layout_hints;
+    }
+
+    void set_layout_hints(const layout_hints& hints) {
+        _layout_hints = hints;
+    }
+
+    /**
+     * Member variables, in declaration order.
+     */
+    std::vector<std::shared_ptr<member_variable_definition>> get_member_variables() const;
+
     //
     // Children functions
     //
@@ -390,8 +446,6 @@ protected:
     static std::shared_ptr<parameter> make_shared(std::shared_ptr<function> func, const std::string &name, size_t pos);
     static std::shared_ptr<parameter> make_shared(std::shared_ptr<function> func, const std::string &name, const std::shared_ptr<type> &type, size_t pos);
 
-    void update_mangled_name() override;
-
 public:
     void accept(model_visitor& visitor) override;
 
@@ -416,6 +470,12 @@ protected:
     std::shared_ptr<parameter> _this_param;
     std::shared_ptr<block> _block;
 
+    visibility _visibility = DEFAULT;
+    /** Function declared without body, defined by another module. */
+    bool _declaration_only = false;
+    /** Floating point math relaxations of the function, replacing the compiler ones if set. */
+    std::optional<fast_math_flags> _fast_math;
+
     function(std::shared_ptr<element> parent) :
         element(parent) {}
 
@@ -424,7 +484,7 @@ protected:
     std::shared_ptr<variable_definition> do_create_variable(const std::string &name) override;
     void on_variable_defined(std::shared_ptr<variable_definition>) override;
 
-    void update_mangled_name() override;
+    std::string make_mangled_name() const override;
 
     void create_this_parameter();
 
@@ -461,6 +521,45 @@ public:
     bool is_member() const;
     std::shared_ptr<const structure> get_owner() const;
     std::shared_ptr<structure> get_owner();
+
+    visibility get_visibility() const {
+        return _visibility;
+    }
+
+    void set_visibility(visibility vis) {
+        _visibility = vis;
+    }
+
+    /**
+     * Test if the function is exported, i.e. reachable from outside its unit.
+     * Private and protected functions are not exported.
+     */
+    bool is_exported() const {
+        return _visibility != PRIVATE && _visibility != PROTECTED;
+    }
+
+    /**
+     * Test if the function is only declared (without body), so defined by another module linked or loaded with it.
+     */
+    bool is_declaration_only() const {
+        return _declaration_only;
+    }
+
+    void set_declaration_only(bool declaration_only) {
+        _declaration_only = declaration_only;
+    }
+
+    const std::optional<fast_math_flags>& get_fast_math() const {
+        return _fast_math;
+    }
+
+    /**
+     * Set the floating point math relaxations of the function, given by "[[fast_math]]" or "[[strict_math]]" attributes.
+     * They replace the ones of the compiler for this function.
+     */
+    void set_fast_math(const std::optional<fast_math_flags>& flags) {
+        _fast_math = flags;
+    }
 };
 
 
@@ -476,10 +575,15 @@ public:
 
     void accept(model_visitor& visitor) override;
 
-    void update_mangled_name() override;
+    std::string make_mangled_name() const override;
 
     void add_global_variable_definition(const std::shared_ptr<global_variable_definition>& gv);
 
+    /**
+     * Test if a global variable is initialized by this function.
+     */
+    bool has_global_variable_definition(const std::shared_ptr<global_variable_definition>& gv) const;
+
     /**
      * Return the list of global variables sorted in their initialization order.
      * The initialization of a variable must occur after all their dependencies initialization
@@ -517,7 +621,7 @@ protected:
     static std::shared_ptr<global_variable_definition> make_shared(std::shared_ptr<ns> ns);
     static std::shared_ptr<global_variable_definition> make_shared(std::shared_ptr<ns> ns, const std::string& name);
 
-    void update_mangled_name() override;
+    std::string make_mangled_name() const override;
 
 public:
     void accept(model_visitor& visitor) override;
@@ -553,7 +657,7 @@ protected:
     std::shared_ptr<structure> do_create_structure(const std::string &name) override;
     void on_structure_defined(std::shared_ptr<structure>) override;
 
-    void update_mangled_name() override;
+    std::string make_mangled_name() const override;
 public:
 
     void accept(model_visitor& visitor) override;
@@ -621,6 +725,7 @@ protected:
     friend class k::model::gen::symbol_resolver;
     friend class k::model::gen::type_reference_resolver;
     friend class k::model::gen::unit_llvm_ir_gen;
+    friend class k::model::gen::constant_folder;
 
     global_constructor_function& get_global_constructor_function() {return *_global_constructor_func;}
     global_destructor_function& get_global_destructor_function() {return *_global_destructor_func;}
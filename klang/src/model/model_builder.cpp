@@ -16,7 +16,7 @@
  * limitations under the License.
  */
 //
-// Note: Last parser log number: 0x20009
+// Note: Last parser log number: 0x2000E
 //
 
 #include "model_builder.hpp"
@@ -119,7 +119,7 @@ namespace k::model {
         }
 
         std::shared_ptr<model::structure> struc = parent_scope->define_structure(st.name.content);
-
+        struc->set_layout_hints(make_layout_hints(st.attributes, true));
 
         // Push function context
         stack<struct_context> push(_contexts, struc);
@@ -137,6 +137,14 @@ namespace k::model {
         std::shared_ptr<model::variable_definition> var = parent_scope->append_variable(decl.name.content);
         var->set_type(_context->from_type_specifier(*decl.type));
 
+        if(!decl.attributes.empty()) {
+            auto member = std::dynamic_pointer_cast<model::member_variable_definition>(var);
+            if(!member) {
+                throw_error(0x000F, decl.name, "Layout attributes are only supported on structure fields");
+            }
+            member->set_layout_hints(make_layout_hints(decl.attributes, false));
+        }
+
         if(decl.init) {
             _expr.reset();
             decl.init->visit(*this);
@@ -151,11 +159,34 @@ namespace k::model {
         }
         std::shared_ptr<model::function> function = parent_scope->define_function(func.name.content);
 
+        // Function visibility is the one of its scope, unless explicitly specified.
+        if(auto scope = current_context<visibility_context>()) {
+            function->set_visibility(scope->visibility);
+        }
+        for(const auto& spec : func.specifiers) {
+            switch(spec.type) {
+                case lex::keyword::PUBLIC:
+                    function->set_visibility(model::PUBLIC);
+                    break;
+                case lex::keyword::PROTECTED:
+                    function->set_visibility(model::PROTECTED);
+                    break;
+                case lex::keyword::PRIVATE:
+                    function->set_visibility(model::PRIVATE);
+                    break;
+                default:
+                    // TODO add other function specs
+                    break;
+            }
+        }
+
+        if(!func.attributes.empty()) {
+            function->set_fast_math(make_fast_math_flags(func.attributes));
+        }
+
         // Push function context
         stack<func_context> push(_contexts, function);
 
-        // TODO add function specs
-
         if(func.type) {
             function->set_return_type(_context->from_type_specifier(*func.type));
         }
@@ -170,6 +201,8 @@ namespace k::model {
             if(auto block = std::dynamic_pointer_cast<model::block>(_stmt)) {
                 function->set_block(block);
             }
+        } else {
+            function->set_declaration_only(true);
         }
     }
 
@@ -280,6 +313,7 @@ namespace k::model {
         }
 
         auto while_stmt = std::make_shared<model::while_statement>(parent_scope, stmt.shared_as<parse::ast::while_statement>());
+        while_stmt->set_hints(make_loop_hints(stmt.attributes));
 
         // Push function context
         stack<while_context> push(_contexts, while_stmt);
@@ -313,6 +347,88 @@ namespace k::model {
         _stmt = while_stmt;
     }
 
+    loop_hints model_builder::make_loop_hints(const std::vector<parse::ast::attribute>& attributes) {
+        loop_hints hints;
+        for(const auto& attr : attributes) {
+            const std::string& name = attr.name.content;
+            if(name == "no_alias") {
+                if(!attr.args.empty()) {
+                    throw_error(0x000C, attr.name, "Loop attribute '{}' does not expect any argument", {name});
+                }
+                hints.no_alias = true;
+            } else if(name == "unroll" || name == "vectorize") {
+                unsigned int value = 0;
+                if(attr.args.size() > 1 || (attr.args.size() == 1 && !std::holds_alternative<lex::integer>(attr.args.front()))) {
+                    throw_error(0x000D, attr.name, "Loop attribute '{}' expects at most one integer argument", {name});
+                } else if(attr.args.size() == 1) {
+                    value = attr.args.front().get<lex::integer>().to_unsigned_int();
+                }
+                (name == "unroll" ? hints.unroll : hints.vectorize) = value;
+            } else {
+                throw_error(0x000E, attr.name, "Unknown loop attribute '{}'", {name});
+            }
+        }
+        return hints;
+    }
+
+    layout_hints model_builder::make_layout_hints(const std::vector<parse::ast::attribute>& attributes, bool is_struct) {
+        layout_hints hints;
+        for(const auto& attr : attributes) {
+            const std::string& name = attr.name.content;
+            if(name == "packed" || (is_struct && (name == "reorder" || name == "no_reorder"))) {
+                if(!attr.args.empty()) {
+                    throw_error(0x0010, attr.name, "Layout attribute '{}' does not expect any argument", {name});
+                }
+                if(name == "packed") {
+                    hints.packed = true;
+                } else {
+                    hints.reorder = name == "reorder";
+                }
+            } else if(name == "align") {
+                if(attr.args.size() != 1 || !std::holds_alternative<lex::integer>(attr.args.front())) {
+                    throw_error(0x0011, attr.name, "Layout attribute 'align' expects one integer argument");
+                }
+                unsigned int align = attr.args.front().get<lex::integer>().to_unsigned_int();
+                if(align == 0 || (align & (align - 1)) != 0) {
+                    throw_error(0x0012, attr.name, "Layout attribute 'align' expects a power of two");
+                }
+                hints.align = align;
+            } else {
+                throw_error(0x0013, attr.name, "Unknown {} layout attribute '{}'", {is_struct ? "structure" : "field", name});
+            }
+        }
+        return hints;
+    }
+
+    fast_math_flags model_builder::make_fast_math_flags(const std::vector<parse::ast::attribute>& attributes) {
+        fast_math_flags flags;
+        for(const auto& attr : attributes) {
+            const std::string& name = attr.name.content;
+            if(name == "strict_math") {
+                if(!attr.args.empty()) {
+                    throw_error(0x0014, attr.name, "Function attribute '{}' does not expect any argument", {name});
+                }
+                flags = fast_math_flags{};
+            } else if(name == "fast_math") {
+                if(attr.args.empty()) {
+                    flags = fast_math_flags::fast();
+                }
+                for(const auto& arg : attr.args) {
+                    if(!std::holds_alternative<lex::string>(arg)) {
+                        throw_error(0x0015, attr.name, "Function attribute 'fast_math' expects flag names as strings");
+                    }
+                    auto flag = std::get<std::string>(arg.get<lex::string>().value());
+                    if(!flags.set(flag)) {
+                        throw_error(0x0016, attr.name, "Unknown fast math flag '{}'", {flag});
+                    }
+                }
+            } else {
+                throw_error(0x0017, attr.name, "Unknown function attribute '{}'", {name});
+            }
+        }
+        return flags;
+    }
+
     void model_builder::visit_for_statement(parse::ast::for_statement &stmt) {
         auto parent_scope = current_context_content<statement>();
         if(!parent_scope) {
@@ -320,6 +436,7 @@ namespace k::model {
         }
 
         auto for_stmt = std::make_shared<model::for_statement>(parent_scope, stmt.shared_as<parse::ast::for_statement>());
+        for_stmt->set_hints(make_loop_hints(stmt.attributes));
 
         // Push function context
         stack<for_context> push(_contexts, for_stmt);
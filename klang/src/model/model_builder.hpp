@@ -160,6 +160,25 @@ protected:
 
     void visit_comma_expr(parse::ast::expr_list_expr &) override;
 
+    /**
+     * Make loop hints from loop statement attributes: "unroll", "unroll(count)", "vectorize", "vectorize(width)"
+     * and "no_alias".
+     */
+    loop_hints make_loop_hints(const std::vector<parse::ast::attribute>& attributes);
+
+    /**
+     * Make layout hints from structure or structure field attributes: "packed" and "align(bytes)",
+     * plus "reorder" and "no_reorder" for structures.
+     */
+    layout_hints make_layout_hints(const std::vector<parse::ast::attribute>& attributes, bool is_struct);
+
+    /**
+     * Make floating point math flags from function attributes: "fast_math" (all flags), "fast_math(flags...)"
+     * with flag names as strings ("reassoc", "contract", "nnan", "ninf", "nsz", "arcp" or "afn"),
+     * or "strict_math" (no flag).
+     */
+    fast_math_flags make_fast_math_flags(const std::vector<parse::ast::attribute>& attributes);
+
     [[noreturn]] void throw_error(unsigned int code, const lex::lexeme& lexeme, const std::string& message, const std::vector<std::string>& args = {}) {
         error(code, lexeme, message, args);
         throw parse::parsing_error(message);
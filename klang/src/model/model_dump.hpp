@@ -315,8 +315,18 @@ public:
         if(expr.is_literal()) {
             _stm << "<<value-expr-lit:" << expr.get_literal().content << ">>";
         } else {
-            _stm << "<<value-expr-val:TODO" << ">>";
-            // TODO
+            _stm << "<<value-expr-val:";
+            std::visit([&](auto&& val) {
+                using T = std::decay_t<decltype(val)>;
+                if constexpr (std::is_same_v<T, bool>) {
+                    _stm << (val ? "true" : "false");
+                } else if constexpr (std::is_same_v<T, char> || std::is_same_v<T, unsigned char>) {
+                    _stm << (int) val;
+                } else if constexpr (std::is_arithmetic_v<T> || std::is_same_v<T, std::string>) {
+                    _stm << val;
+                }
+            }, expr.get_value());
+            _stm << ">>";
         }
     }
 
@@ -23,6 +23,8 @@
 
 #include "../common/tools.hpp"
 
+#include <algorithm>
+
 namespace k::model {
 
 
@@ -184,10 +186,6 @@ void expression_statement::accept(model_visitor &visitor) {
 // Variable statement
 //
 
-void variable_statement::update_mangled_name() {
-    // TODO Implement mangling scheme
-}
-
 void variable_statement::accept(model_visitor &visitor) {
     visitor.visit_variable_statement(*this);
 }
@@ -240,6 +238,19 @@ void block::append_statement(std::shared_ptr<statement> stmt) {
     // TODO add specific process for variables
 }
 
+void block::replace_statement(const std::shared_ptr<statement>& old_stmt, const std::shared_ptr<statement>& new_stmt) {
+    auto it = std::find(_statements.begin(), _statements.end(), old_stmt);
+    if (it == _statements.end()) {
+        return;
+    }
+    if (new_stmt) {
+        *it = new_stmt;
+        set_this_as_parent_to(new_stmt);
+    } else {
+        _statements.erase(it);
+    }
+}
+
 std::shared_ptr<variable_definition> block::do_create_variable(const std::string &name) {
     return std::shared_ptr<variable_definition>(variable_statement::make_shared(shared_as<block>(), name));
 }
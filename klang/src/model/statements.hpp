@@ -156,6 +156,23 @@ public:
 };
 
 
+/**
+ * Optimization hints of a loop, given by attributes like "[[unroll(4), vectorize(8), no_alias]]".
+ */
+struct loop_hints {
+    /** Unroll count, 0 to let the optimizer choose it and 1 to disable unrolling. */
+    std::optional<unsigned int> unroll;
+    /** Vectorization width, 0 to let the optimizer choose it and 1 to disable vectorization. */
+    std::optional<unsigned int> vectorize;
+    /** Memory accesses of different iterations never alias, iterations can be run in parallel. */
+    bool no_alias = false;
+
+    bool empty() const {
+        return !unroll && !vectorize && !no_alias;
+    }
+};
+
+
 /**
  * While statement
  */
@@ -167,6 +184,8 @@ protected:
     std::shared_ptr<expression> _test_expr;
     std::shared_ptr<statement> _nested_stmt;
 
+    loop_hints _hints;
+
 public:
     while_statement() = delete;
     while_statement(const std::shared_ptr<statement>& parent) : statement(parent) {}
@@ -201,6 +220,14 @@ public:
         return _nested_stmt;
     }
 
+    const loop_hints& get_hints() const {
+        return _hints;
+    }
+
+    void set_hints(const loop_hints& hints) {
+        _hints = hints;
+    }
+
 };
 
 
@@ -217,6 +244,7 @@ protected:
     std::shared_ptr<expression> _step_expr;
     std::shared_ptr<statement> _nested_stmt;
 
+    loop_hints _hints;
 
     std::shared_ptr<variable_definition> do_create_variable(const std::string &name) override;
     void on_variable_defined(std::shared_ptr<variable_definition>) override;
@@ -249,6 +277,14 @@ public:
 
     void set_nested_stmt(const std::shared_ptr<statement> &nested_stmt);
 
+    const loop_hints& get_hints() const {
+        return _hints;
+    }
+
+    void set_hints(const loop_hints& hints) {
+        _hints = hints;
+    }
+
     std::shared_ptr<variable_holder> get_variable_holder() override;
     std::shared_ptr<const variable_holder> get_variable_holder() const override;
 
@@ -323,8 +359,6 @@ protected:
         return var_def;
     }
 
-    void update_mangled_name() override;
-
 public:
     void accept(model_visitor& visitor) override;
 
@@ -381,6 +415,13 @@ public:
 
     void append_statement(std::shared_ptr<statement> stmt);
 
+    /**
+     * Replace a statement of this block.
+     * @param old_stmt Statement to replace.
+     * @param new_stmt Replacement statement, null to remove the old one.
+     */
+    void replace_statement(const std::shared_ptr<statement>& old_stmt, const std::shared_ptr<statement>& new_stmt);
+
     std::shared_ptr<variable_holder> get_variable_holder() override;
     std::shared_ptr<const variable_holder> get_variable_holder() const override;
 
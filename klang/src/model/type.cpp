@@ -76,6 +76,13 @@ std::shared_ptr<sized_array_type> type::get_array(unsigned long size)
     return get_array()->with_size(size);
 }
 
+std::shared_ptr<vector_type> type::get_vector(unsigned long size)
+{
+    return tools::compute_if_absent(vectors, size,
+                    [&](unsigned long sz){return std::shared_ptr<vector_type>{new vector_type(shared_from_this(), sz)};}
+            )->second;
+}
+
 llvm::Type* type::get_llvm_type() const {
     return _llvm_type;
 };
@@ -121,13 +128,27 @@ std::string primitive_type::to_string()const {
             {UNSIGNED_INT, "unsigned int"},
             {LONG, "long"},
             {UNSIGNED_LONG, "unsigned long"},
-            // TODO Add (unsigned) long long
+            {LONG_LONG, "long long"},
+            {UNSIGNED_LONG_LONG, "unsigned long long"},
             {FLOAT, "float"},
             {DOUBLE, "double"}
     };
     return type_names[_type];
 }
 
+const std::shared_ptr<primitive_type>& primitive_type::common_type(const std::shared_ptr<primitive_type>& left, const std::shared_ptr<primitive_type>& right) {
+    if (left->is_float() != right->is_float()) {
+        return left->is_float() ? left : right;
+    }
+    if (left->type_size() != right->type_size()) {
+        return left->type_size() > right->type_size() ? left : right;
+    }
+    if (left->is_unsigned() != right->is_unsigned()) {
+        return left->is_unsigned() ? left : right;
+    }
+    return left;
+}
+
 llvm::Constant* primitive_type::generate_default_value_initializer() const {
     if (is_integer()) {
         return llvm::ConstantInt::get(get_llvm_type(), 0);
@@ -282,6 +303,40 @@ std::string sized_array_type::to_string() const {
     return stm.str();
 }
 
+//
+// Vector type
+//
+
+vector_type::vector_type(std::shared_ptr<type> subtype, unsigned long size) :
+    type(subtype),
+    _size(size)
+{}
+
+bool vector_type::is_resolved() const
+{
+    return subtype.lock()->is_resolved();
+}
+
+llvm::Type* vector_type::get_llvm_type() const {
+    return llvm::FixedVectorType::get(subtype.lock()->get_llvm_type(), _size);
+}
+
+llvm::Constant* vector_type::generate_default_value_initializer() const {
+    return llvm::ConstantAggregateZero::get(get_llvm_type());
+}
+
+std::string vector_type::to_string() const {
+    auto sub = subtype.lock();
+    std::ostringstream stm;
+    if(sub) {
+        stm << sub->to_string();
+    } else {
+        stm << "<<nosub>>";
+    }
+    stm << "[[" << _size << "]]";
+    return stm.str();
+}
+
 //
 // Structure type builder
 //
@@ -307,7 +362,14 @@ std::shared_ptr<struct_type> struct_type_builder::build() {
     }
 
     llvm::StructType* st = llvm::StructType::create(**_context, llvm::ArrayRef<llvm::Type*>(types), _name);
-    std::shared_ptr<struct_type> st_type{new struct_type(_name, _struct, std::move(_fields), st)}; 
+    auto layout = _context->get_data_layout().getStructLayout(st);
+    for(size_t idx=0; idx<_fields.size(); ++idx) {
+        _fields[idx].offset = layout->getElementOffset(idx);
+        _fields[idx].size = _context->get_data_layout().getTypeAllocSize(types[idx]);
+    }
+    std::shared_ptr<struct_type> st_type{new struct_type(_name, _struct, std::move(_fields), st)};
+    st_type->_size = layout->getSizeInBytes();
+    st_type->_alignment = layout->getAlignment().value();
     _context->add_struct(st_type);
 
     return st_type;
@@ -356,10 +418,14 @@ std::shared_ptr<structure> struct_type::get_struct() const {
     return _struct.lock();
 }
 
-void struct_type::set_llvm_type(std::vector<field>&& fields, llvm::StructType* llvm_struct_type, llvm::Constant* default_init_constant) {
+void struct_type::set_llvm_type(std::vector<field>&& fields, llvm::StructType* llvm_struct_type, llvm::Constant* default_init_constant,
+                                uint64_t size, uint64_t alignment, bool custom_layout) {
     _fields = fields;
     _llvm_type = llvm_struct_type;
     _default_init_constant = default_init_constant;
+    _size = size;
+    _alignment = alignment;
+    _custom_layout = custom_layout;
 }
 
 
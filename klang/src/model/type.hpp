@@ -58,6 +58,7 @@ class reference_type;
 class pointer_type;
 class sized_array_type;
 class array_type;
+class vector_type;
 class struct_type;
 class function_reference_type;
 
@@ -71,6 +72,7 @@ protected:
     std::shared_ptr<reference_type> reference;
     std::shared_ptr<pointer_type> pointer;
     std::shared_ptr<array_type> array;
+    std::map<unsigned long, std::shared_ptr<vector_type>> vectors;
 
     mutable llvm::Type* _llvm_type;
 
@@ -97,13 +99,21 @@ public:
     inline static bool is_pointer(const std::shared_ptr<type>& type);
     inline static bool is_sized_array(const std::shared_ptr<type>& type);
     inline static bool is_array(const std::shared_ptr<type>& type);
+    inline static bool is_vector(const std::shared_ptr<type>& type);
     inline static bool is_struct(const std::shared_ptr<type>& type);
     inline static bool is_function_reference(const std::shared_ptr<type>& type);
 
+    /**
+     * Lane type of a vector type, the type itself for any other type.
+     * Let element-wise operations be processed as their scalar counterparts.
+     */
+    inline static std::shared_ptr<type> get_lane_type(const std::shared_ptr<type>& type);
+
     virtual std::shared_ptr<reference_type> get_reference();
     std::shared_ptr<pointer_type> get_pointer();
     std::shared_ptr<array_type> get_array();
     std::shared_ptr<sized_array_type> get_array(unsigned long size);
+    std::shared_ptr<vector_type> get_vector(unsigned long size);
 
     virtual llvm::Type* get_llvm_type() const;
 
@@ -154,7 +164,8 @@ public:
         UNSIGNED_INT,
         LONG,
         UNSIGNED_LONG,
-        // TODO add (unsigned) long long
+        LONG_LONG,
+        UNSIGNED_LONG_LONG,
         FLOAT,
         DOUBLE
     };
@@ -202,6 +213,13 @@ public:
 
     std::string to_string()const override;
 
+    /**
+     * Common type of an arithmetic operation between two primitive types (usual arithmetic conversions):
+     * floating point over integer, then the widest, then unsigned over signed of the same width.
+     * @return One of the two given types.
+     */
+    static const std::shared_ptr<primitive_type>& common_type(const std::shared_ptr<primitive_type>& left, const std::shared_ptr<primitive_type>& right);
+
     static std::shared_ptr<primitive_type> from_type(PRIMITIVE_TYPE type);
     static std::shared_ptr<type> from_string(const std::string& type_name);
     static std::shared_ptr<type> from_keyword(const lex::keyword& kw, bool is_unsigned = false);
@@ -351,6 +369,43 @@ inline bool type::is_sized_array(const std::shared_ptr<type>& type) {
 }
 
 
+/**
+ * SIMD vector type, fixed count of lanes of a primitive type.
+ * Lowered to LLVM fixed vectors, operations on them are always generated as vector instructions.
+ */
+class vector_type : public type {
+protected:
+    unsigned long _size;
+
+    friend class type;
+    vector_type(std::shared_ptr<type> subtype, unsigned long size);
+
+public:
+    unsigned long get_size() const {return _size;}
+
+    std::shared_ptr<type> get_lane_type() const {return get_subtype();}
+
+    bool is_resolved() const override;
+
+    llvm::Type* get_llvm_type() const override;
+
+    llvm::Constant* generate_default_value_initializer() const override;
+
+    std::string to_string() const override;
+};
+
+inline bool type::is_vector(const std::shared_ptr<type>& type) {
+    return std::dynamic_pointer_cast<vector_type>(type) != nullptr;
+}
+
+inline std::shared_ptr<type> type::get_lane_type(const std::shared_ptr<type>& type) {
+    if(auto vec = std::dynamic_pointer_cast<vector_type>(type)) {
+        return vec->get_lane_type();
+    }
+    return type;
+}
+
+
 
 
 /**
@@ -359,9 +414,13 @@ inline bool type::is_sized_array(const std::shared_ptr<type>& type) {
 class struct_type : public type {
 public:
     struct field {
+        /** Index of the field in the LLVM structure (padding may be inserted as explicit elements). */
         size_t index;
         std::string name;
         std::weak_ptr<type> field_type;
+        /** Offset and size of the field in the structure, in bytes. */
+        uint64_t offset = 0;
+        uint64_t size = 0;
     };
     typedef std::vector<field> fields_t;
 
@@ -380,9 +439,20 @@ protected:
 
     llvm::Constant* _default_init_constant = nullptr;
 
+    /** Size and alignment of the structure, in bytes. */
+    uint64_t _size = 0;
+    uint64_t _alignment = 0;
+
+    /**
+     * The layout is not the natural one of the fields (packed or explicitly aligned structure or fields):
+     * the LLVM structure is packed, with explicit padding elements, and its alignment is not the LLVM one.
+     */
+    bool _custom_layout = false;
+
     struct_type(const std::string& name, std::weak_ptr<k::model::structure> st, std::vector<field>&& fields, llvm::StructType* llvm_struct_type);
 
-    void set_llvm_type(std::vector<field>&& fields, llvm::StructType* llvm_struct_type, llvm::Constant* default_init_constant);
+    void set_llvm_type(std::vector<field>&& fields, llvm::StructType* llvm_struct_type, llvm::Constant* default_init_constant,
+                       uint64_t size, uint64_t alignment, bool custom_layout = false);
 
 public:
     struct_type(const std::string& name, std::weak_ptr<k::model::structure> st);
@@ -401,6 +471,10 @@ public:
     bool has_member(const std::string& name) const;
     std::optional<field> get_member(const std::string& name) const;
 
+    uint64_t get_size() const {return _size;}
+    uint64_t get_alignment() const {return _alignment;}
+    bool has_custom_layout() const {return _custom_layout;}
+
     llvm::Constant* generate_default_value_initializer() const override;
 };
 
@@ -65,6 +65,10 @@ void ast::array_type_specifier::visit(ast_visitor &visitor) {
     visitor.visit_array_type_specifier(*this);
 }
 
+void ast::vector_type_specifier::visit(ast_visitor &visitor) {
+    visitor.visit_vector_type_specifier(*this);
+}
+
 void ast::pointer_type_specifier::visit(ast_visitor &visitor) {
     visitor.visit_pointer_type_specifier(*this);
 }
@@ -196,6 +200,10 @@ void default_ast_visitor::visit_array_type_specifier(ast::array_type_specifier &
 
 }
 
+void default_ast_visitor::visit_vector_type_specifier(ast::vector_type_specifier &) {
+
+}
+
 void default_ast_visitor::visit_pointer_type_specifier(ast::pointer_type_specifier &) {
 
 }
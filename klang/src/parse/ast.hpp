@@ -118,9 +118,13 @@ namespace k::parse {
         struct keyword_type_specifier : public type_specifier {
             lex::keyword keyword;
             bool is_unsigned = false;
+            /** Second 'long' keyword of "long long". */
+            bool is_long_long = false;
 
-            keyword_type_specifier(const lex::keyword & keyword, bool is_unsigned = false) : keyword(keyword) {}
-            keyword_type_specifier(lex::keyword && keyword, bool is_unsigned = false) : keyword(keyword) {}
+            keyword_type_specifier(const lex::keyword & keyword, bool is_unsigned = false, bool is_long_long = false) :
+                    keyword(keyword), is_unsigned(is_unsigned), is_long_long(is_long_long) {}
+            keyword_type_specifier(lex::keyword && keyword, bool is_unsigned = false, bool is_long_long = false) :
+                    keyword(keyword), is_unsigned(is_unsigned), is_long_long(is_long_long) {}
 
             virtual void visit(ast_visitor &visitor) override;
         };
@@ -137,6 +141,18 @@ namespace k::parse {
             virtual void visit(ast_visitor &visitor) override;
         };
 
+        struct vector_type_specifier : public type_specifier {
+            std::shared_ptr<type_specifier> subtype;
+            lex::punctuator br_open, br_close;
+            lex::integer lex_int;
+
+            vector_type_specifier(const std::shared_ptr<type_specifier> &subtype, const lex::punctuator &br_open,
+                                  const lex::punctuator &br_close, const lex::integer &lex_int):
+                    subtype(subtype), br_open(br_open), br_close(br_close), lex_int(lex_int) {}
+
+            virtual void visit(ast_visitor &visitor) override;
+        };
+
         struct pointer_type_specifier : public type_specifier {
             std::shared_ptr<type_specifier> subtype;
             lex::operator_ pointer_type;
@@ -197,6 +213,14 @@ namespace k::parse {
 
         typedef std::shared_ptr<declaration> decl_ptr;
 
+        /**
+         * Attribute, like "unroll(4)" in "[[unroll(4), no_alias]]".
+         */
+        struct attribute {
+            lex::identifier name;
+            std::vector<lex::any_literal> args;
+        };
+
         struct statement : public ast_node {
         };
 
@@ -478,6 +502,7 @@ namespace k::parse {
             lex::keyword while_kw;
             std::shared_ptr<expression> test_expr;
             std::shared_ptr<statement> nested_stmt;
+            std::vector<attribute> attributes;
 
             while_statement(const lex::keyword &while_kw,
                               const std::shared_ptr<expression>& test_expr,
@@ -496,7 +521,7 @@ namespace k::parse {
             std::shared_ptr<expression> test_expr;
             std::shared_ptr<expression> step_expr;
             std::shared_ptr<statement> nested_stmt;
-
+            std::vector<attribute> attributes;
 
             for_statement(const lex::keyword &for_kw,
                           const lex::punctuator &first_semicolon_kw,
@@ -560,6 +585,7 @@ namespace k::parse {
             lex::punctuator open_brace, close_brace;
             lex::identifier name;
             std::vector <decl_ptr> declarations;
+            std::vector<attribute> attributes;
 
             struct_decl(const std::vector <lex::keyword>& specifiers,
                             const lex::keyword& st,
@@ -585,6 +611,7 @@ namespace k::parse {
             lex::identifier name;
             std::shared_ptr<ast::type_specifier> type;
             expr_ptr init;
+            std::vector<attribute> attributes;
 
             variable_decl(const std::vector <lex::keyword> &specifiers, const lex::identifier &name,
                           const std::shared_ptr<ast::type_specifier> &type, expr_ptr init = nullptr) :
@@ -618,6 +645,7 @@ namespace k::parse {
             std::shared_ptr<ast::type_specifier> type;
             std::vector<std::shared_ptr<parameter_spec>> params;
             std::shared_ptr<block_statement> content;
+            std::vector<attribute> attributes;
 
             function_decl(const std::vector <lex::keyword> &specifiers, const lex::identifier &name,
                           const std::shared_ptr<ast::type_specifier> &type, const std::vector<std::shared_ptr<parameter_spec>> &params,
@@ -680,6 +708,7 @@ namespace k::parse {
         virtual void visit_identified_type_specifier(ast::identified_type_specifier &) = 0;
         virtual void visit_keyword_type_specifier(ast::keyword_type_specifier &) = 0;
         virtual void visit_array_type_specifier(ast::array_type_specifier &) = 0;
+        virtual void visit_vector_type_specifier(ast::vector_type_specifier &) = 0;
         virtual void visit_pointer_type_specifier(ast::pointer_type_specifier &) = 0;
 
         virtual void visit_parameter_specifier(ast::parameter_spec &) = 0;
@@ -727,6 +756,7 @@ namespace k::parse {
         void visit_identified_type_specifier(ast::identified_type_specifier &) override;
         void visit_keyword_type_specifier(ast::keyword_type_specifier &) override;
         void visit_array_type_specifier(ast::array_type_specifier &) override;
+        void visit_vector_type_specifier(ast::vector_type_specifier &) override;
         void visit_pointer_type_specifier(ast::pointer_type_specifier &) override;
 
         void visit_parameter_specifier(ast::parameter_spec &) override;
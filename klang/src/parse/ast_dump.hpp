@@ -140,7 +140,7 @@ class ast_dump_visitor : public k::parse::ast_visitor {
         }
 
         void visit_keyword_type_specifier(ast::keyword_type_specifier &identifier) override  {
-            _stm  <<  "<<kwtype:" << identifier.keyword.content << ">>";
+            _stm  <<  "<<kwtype:" << (identifier.is_unsigned ? "unsigned " : "") << identifier.keyword.content << (identifier.is_long_long ? " long" : "") << ">>";
         }
 
         void visit_array_type_specifier(ast::array_type_specifier &arr) override {
@@ -152,6 +152,11 @@ class ast_dump_visitor : public k::parse::ast_visitor {
                 _stm << "[<<undef>>]";
         }
 
+        void visit_vector_type_specifier(ast::vector_type_specifier &vec) override {
+            vec.subtype->visit(*this);
+            _stm << "[[" << vec.lex_int.content << "]]";
+        }
+
         void visit_pointer_type_specifier(ast::pointer_type_specifier &ptr) override {
             ptr.subtype->visit(*this);
             _stm << ptr.pointer_type.content;
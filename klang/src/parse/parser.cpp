@@ -16,7 +16,7 @@
  * limitations under the License.
  */
 //
-// Note: Last parser log number: 0x1003C
+// Note: Last parser log number: 0x10043
 //
 
 #include "parser.hpp"
@@ -148,6 +148,23 @@ ast::decl_ptr parser::parse_declaration()
         return decl;
     }
 
+    if(auto attributes = parse_attributes(); !attributes.empty()) {
+        // Attributes are only supported on structures, functions and variables (structure fields).
+        if(auto decl = parse_struct_decl()) {
+            decl->attributes = std::move(attributes);
+            return decl;
+        }
+        if(auto decl = parse_function_decl()) {
+            decl->attributes = std::move(attributes);
+            return decl;
+        }
+        if(auto decl = parse_variable_decl()) {
+            decl->attributes = std::move(attributes);
+            return decl;
+        }
+        throw_error(0x0044, _lexer.pick(), "Attributes are only supported on structure, function and variable declarations");
+    }
+
     // Look for a struct decl
     if(auto decl = parse_struct_decl()) {
         return decl;
@@ -656,8 +673,70 @@ std::shared_ptr<ast::for_statement> parser::parse_for_statement()
     );
 }
 
+std::vector<ast::attribute> parser::parse_attributes()
+{
+    std::vector<ast::attribute> attributes;
+
+    while(true) {
+        lex::lex_holder holder(_lexer);
+        if(_lexer.get() != lex::punctuator::BRACKET_OPEN || _lexer.get() != lex::punctuator::BRACKET_OPEN) {
+            holder.rollback();
+            break;
+        }
+
+        do {
+            auto lname = _lexer.get();
+            if(lex::is_not<lex::identifier>(lname)) {
+                throw_error(0x003D, lname, "Attribute list expects an attribute name");
+            }
+            ast::attribute attr{lex::as<lex::identifier>(lname), {}};
+
+            lex::lex_holder args_holder(_lexer);
+            if(_lexer.get() == lex::punctuator::PARENTHESIS_OPEN) {
+                auto larg = _lexer.get();
+                while(larg != lex::punctuator::PARENTHESIS_CLOSE) {
+                    if(!lex::is<lex::literal>(larg)) {
+                        throw_error(0x003E, larg, "Attribute arguments must be literals");
+                    }
+                    attr.args.push_back(lex::as_any_literal(larg));
+                    larg = _lexer.get();
+                    if(larg == lex::punctuator::COMMA) {
+                        larg = _lexer.get();
+                    } else if(larg != lex::punctuator::PARENTHESIS_CLOSE) {
+                        throw_error(0x003F, larg, "Attribute arguments expect a comma ',' or a closing parenthesis ')'");
+                    }
+                }
+            } else {
+                args_holder.rollback();
+            }
+
+            attributes.push_back(std::move(attr));
+        } while(_lexer.get() == lex::punctuator::COMMA);
+        _lexer.unget();
+
+        if(_lexer.get() != lex::punctuator::BRACKET_CLOSE || _lexer.get() != lex::punctuator::BRACKET_CLOSE) {
+            throw_error(0x0040, _lexer.pick(), "Attribute list expects to be closed by ']]'");
+        }
+    }
+
+    return attributes;
+}
+
 std::shared_ptr<ast::statement> parser::parse_statement()
 {
+    if(auto attributes = parse_attributes(); !attributes.empty()) {
+        // Attributes are only supported on loops.
+        if(auto while_stmt = parse_while_statement()) {
+            while_stmt->attributes = std::move(attributes);
+            return while_stmt;
+        }
+        if(auto for_stmt = parse_for_statement()) {
+            for_stmt->attributes = std::move(attributes);
+            return for_stmt;
+        }
+        throw_error(0x0041, _lexer.pick(), "Attributes are only supported on loop statements");
+    }
+
     if(auto block = parse_statement_block()) {
         return block;
     }
@@ -765,6 +844,22 @@ std::shared_ptr<ast::type_specifier> parser::parse_type_spec()
 
         if(lex == lex::punctuator::BRACKET_OPEN) {
 
+            if (_lexer.pick() == lex::punctuator::BRACKET_OPEN) {
+                // Vector type specifier: T[[N]]
+                _lexer.get();
+                auto lint = _lexer.get();
+                if (!lex::is<lex::integer>(lint)) {
+                    throw_error(0x0042, lint, "Vector type specifier expects an integer lane count");
+                }
+                auto lbrclose = _lexer.get();
+                if (lbrclose != lex::punctuator::BRACKET_CLOSE || _lexer.pick() != lex::punctuator::BRACKET_CLOSE) {
+                    throw_error(0x0043, _lexer.pick(), "Vector type specifier expects double closing brackets ']]'");
+                }
+                _lexer.get();
+                res = std::make_shared<ast::vector_type_specifier>(res, lex::as<lex::punctuator>(lex), lex::as<lex::punctuator>(lbrclose), lex::as<lex::integer>(lint));
+                continue;
+            }
+
             auto lint = _lexer.get();
             std::optional<lex::integer> int_index;
             if (lex::is<lex::integer>(lint)) {
@@ -812,7 +907,14 @@ std::shared_ptr<ast::type_specifier> parser::parse_fundamental_type_spec() {
             lex::keyword::LONG,
             lex::keyword::FLOAT,
             lex::keyword::DOUBLE>(ltype)){
-        return std::make_shared<ast::keyword_type_specifier>( std::get<lex::keyword>(ltype.value().get()) , is_unsigned);
+        bool is_long_long = false;
+        if(ltype == lex::keyword::LONG) {
+            if(_lexer.pick() == lex::keyword::LONG) {
+                _lexer.get();
+                is_long_long = true;
+            }
+        }
+        return std::make_shared<ast::keyword_type_specifier>( std::get<lex::keyword>(ltype.value().get()) , is_unsigned, is_long_long);
     }
     holder.rollback();
     return {};
@@ -92,6 +92,7 @@ public:
 
     /**
      *  DECLARATION := VISIBILITY_DECL | NAMESPACE_DECL | FUNCTION_DECL | STRUCT_DECLARATION | VARIABLE_DECL
+     *              | ATTRIBUTES (STRUCT_DECLARATION | FUNCTION_DECL | VARIABLE_DECL)
      * @return
      */
     ast::decl_ptr parse_declaration();
@@ -188,11 +189,19 @@ public:
     std::shared_ptr<ast::for_statement> parse_for_statement();
 
     /**
-     * STATEMENT := STATEMENT_BLOCK | RETURN_STATEMENT | IF_ELSE_STATEMENT | WHILE_STATEMENT | FOR_STATEMENT | VARIABLE_DECL | EXPRESSION_STATEMENT
+     * STATEMENT := STATEMENT_BLOCK | RETURN_STATEMENT | IF_ELSE_STATEMENT | VARIABLE_DECL | EXPRESSION_STATEMENT
+     *            | ?[ATTRIBUTES] (WHILE_STATEMENT | FOR_STATEMENT)
      * @return
      */
     std::shared_ptr<ast::statement> parse_statement();
 
+    /**
+     * ATTRIBUTES := *('[' '[' ATTRIBUTE *(',' ATTRIBUTE) ']' ']')
+     * ATTRIBUTE := identifier ?('(' ?(literal *(',' literal)) ')')
+     * @return Attributes, empty if there is none.
+     */
+    std::vector<ast::attribute> parse_attributes();
+
     /**
      * EXPRESSION_STATEMENT := ?[EXPRESSION] ';'
      */
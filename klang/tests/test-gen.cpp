@@ -16,11 +16,32 @@
  * limitations under the License.
  */
 
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
+
 #include <catch2/catch_all.hpp>
 
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Object/ObjectFile.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/TargetParser/Host.h>
+#include <llvm/Transforms/Scalar/SROA.h>
+
 #include "../src/common/logger.hpp"
 #include "../src/parse/parser.hpp"
 #include "../src/parse/ast_dump.hpp"
+#include "../src/model/mangler.hpp"
 #include "../src/model/model.hpp"
 #include "../src/model/model_builder.hpp"
 #include "../src/model/model_dump.hpp"
@@ -35,6 +56,73 @@ std::unique_ptr<k::model::gen::unit_llvm_jit> gen_jit(std::string_view src, bool
     return comp->to_jit();
 }
 
+/**
+ * Build the model of a source and resolve its symbols and types, without generating code.
+ */
+void resolve_source(std::string_view src) {
+    k::log::logger log;
+    auto context = k::model::context::create();
+    auto unit = k::model::unit::create(context);
+    k::parse::parser parser(log);
+    parser.parse(src);
+    auto ast = parser.parse_unit();
+    k::model::model_builder::visit(log, context, *ast, *unit);
+    k::model::gen::symbol_resolver(log, context, *unit).resolve();
+    context->resolve_types();
+    k::model::gen::type_reference_resolver(log, context, *unit).resolve();
+}
+
+/**
+ * Target machine for the given triple, with a generic CPU.
+ */
+std::unique_ptr<llvm::TargetMachine> create_target_machine(const std::string& triple, const std::string& features = "") {
+    // Targets are registered by the first compiler context.
+    k::compiler::create();
+    std::string error;
+    auto target = llvm::TargetRegistry::lookupTarget(triple, error);
+    REQUIRE( target != nullptr );
+    return std::unique_ptr<llvm::TargetMachine>(target->createTargetMachine(triple, "generic", features, {}, llvm::Reloc::PIC_));
+}
+
+/**
+ * Unique temporary file, removed at the end of the test.
+ */
+struct temporary_file {
+    llvm::SmallString<128> path;
+
+    temporary_file(const std::string& prefix, const std::string& suffix) {
+        REQUIRE_FALSE( llvm::sys::fs::createTemporaryFile(prefix, suffix, path) );
+    }
+
+    ~temporary_file() {
+        llvm::sys::fs::remove(path);
+    }
+
+    std::string str() const {
+        return path.str().str();
+    }
+};
+
+/**
+ * Unique temporary directory, removed with its content at the end of the test.
+ */
+struct temporary_directory {
+    llvm::SmallString<128> path;
+
+    explicit temporary_directory(const std::string& prefix) {
+        REQUIRE_FALSE( llvm::sys::fs::createUniqueDirectory((std::filesystem::temp_directory_path() / prefix).string(), path) );
+    }
+
+    ~temporary_directory() {
+        std::error_code ec;
+        std::filesystem::remove_all(path.str().str(), ec);
+    }
+
+    std::string str() const {
+        return path.str().str();
+    }
+};
+
 
 TEST_CASE( "Simple method", "[gen]" ) {
 
@@ -1614,6 +1702,96 @@ TEST_CASE( "uint64 arithmetic", "[gen][uint64][arithmetic]" ) {
     }
 }
 
+TEST_CASE( "int128 arithmetic", "[gen][int128][arithmetic]" ) {
+    auto src = R"SRC(
+        module test;
+        mul_wide(a : long, b : long) : long long {
+            return (long long) a * b;
+        }
+        umul_wide(a : unsigned long, b : unsigned long) : unsigned long long {
+            return a * (unsigned long long) b;
+        }
+        add(a : long long, b : long long) : long long {
+            return a + b;
+        }
+        div(a : unsigned long long, b : unsigned long long) : unsigned long long {
+            return a / b;
+        }
+        high(a : unsigned long long) : unsigned long {
+            return (unsigned long) (a >> 64);
+        }
+        max() : long long {
+            return 170141183460469231731687303715884105727ll;
+        }
+        to_double(a : long long) : double {
+            return (double) a;
+        }
+        )SRC";
+
+    auto comp = k::compiler::create();
+
+    SECTION("int128 types") {
+        comp->parse_source(src, k::optimization_level::O2);
+        REQUIRE( comp->get_element_mangled_name("add") == "_KFN4test3addEnn" );
+        REQUIRE( comp->get_element_mangled_name("div") == "_KFN4test3divEoo" );
+        REQUIRE( k::model::mangler::demangle("_KFN4test3divEoo") == "test::div(unsigned long long, unsigned long long)" );
+        auto mul_wide_name = comp->get_element_mangled_name("mul_wide");
+
+        auto module = comp->take_module();
+        module.withModuleDo([&](llvm::Module& m) {
+            // 64x64->128 multiply: a single i128 multiply of extended 64-bit operands.
+            size_t muls = 0;
+            for (auto& inst : llvm::instructions(*m.getFunction(mul_wide_name))) {
+                if (inst.getOpcode() == llvm::Instruction::Mul) {
+                    REQUIRE( inst.getType()->isIntegerTy(128) );
+                    REQUIRE( llvm::isa<llvm::SExtInst>(inst.getOperand(0)) );
+                    REQUIRE( llvm::isa<llvm::SExtInst>(inst.getOperand(1)) );
+                    muls++;
+                }
+            }
+            REQUIRE( muls == 1 );
+        });
+    }
+
+    SECTION("Execution") {
+        comp->parse_source(src, k::optimization_level::O2);
+        auto jit = comp->to_jit();
+        REQUIRE(jit);
+
+        typedef __int128 type_t;
+        typedef unsigned __int128 utype_t;
+
+        auto mul_wide = jit->lookup_symbol<type_t(*)(int64_t, int64_t)>("mul_wide");
+        REQUIRE( mul_wide != nullptr );
+        REQUIRE( mul_wide(INT64_MAX, INT64_MAX) == (type_t)INT64_MAX * INT64_MAX );
+        REQUIRE( mul_wide(INT64_MIN, 2) == (type_t)INT64_MIN * 2 );
+
+        auto umul_wide = jit->lookup_symbol<utype_t(*)(uint64_t, uint64_t)>("umul_wide");
+        REQUIRE( umul_wide != nullptr );
+        REQUIRE( umul_wide(UINT64_MAX, UINT64_MAX) == (utype_t)UINT64_MAX * UINT64_MAX );
+
+        auto add = jit->lookup_symbol<type_t(*)(type_t, type_t)>("add");
+        REQUIRE( add != nullptr );
+        REQUIRE( add((type_t)1 << 100, -1) == ((type_t)1 << 100) - 1 );
+
+        auto div = jit->lookup_symbol<utype_t(*)(utype_t, utype_t)>("div");
+        REQUIRE( div != nullptr );
+        REQUIRE( div((utype_t)1 << 127, 4) == (utype_t)1 << 125 );
+
+        auto high = jit->lookup_symbol<uint64_t(*)(utype_t)>("high");
+        REQUIRE( high != nullptr );
+        REQUIRE( high((utype_t)42 << 64) == 42 );
+
+        auto max = jit->lookup_symbol<type_t(*)()>("max");
+        REQUIRE( max != nullptr );
+        REQUIRE( max() == (type_t)(((utype_t)1 << 127) - 1) );
+
+        auto to_double = jit->lookup_symbol<double(*)(type_t)>("to_double");
+        REQUIRE( to_double != nullptr );
+        REQUIRE( to_double((type_t)1 << 80) == 0x1p80 );
+    }
+}
+
 TEST_CASE( "float arithmetic", "[gen][float][arithmetic]" ) {
 
     auto jit = gen_jit(R"SRC(
@@ -2268,6 +2446,317 @@ TEST_CASE("For", "[gen][for]") {
 
 }
 
+TEST_CASE("Loop hints", "[gen][for][while]") {
+    auto src = R"SRC(
+        module test;
+        sum(p: int[64]&) : int {
+            res : int = 0;
+            [[vectorize(4), no_alias]]
+            for(i : int = 0; i < 64; i+=1) {
+                res += p[i];
+            }
+            return res;
+        }
+
+        scale(p: int[64]&, f: int) {
+            [[unroll(1), vectorize(1)]]
+            for(i : int = 0; i < 64; i+=1) {
+                p[i] = p[i] * f;
+            }
+        }
+
+        count(n: int) : int {
+            res : int = 0;
+            [[unroll]]
+            while(res < n) {
+                res += 1;
+            }
+            return res;
+        }
+        )SRC";
+
+    auto comp = k::compiler::create();
+
+    SECTION("Loop metadata") {
+        comp->parse_source(src, false);
+        auto sum_name = comp->get_element_mangled_name("sum");
+        auto scale_name = comp->get_element_mangled_name("scale");
+        auto count_name = comp->get_element_mangled_name("count");
+
+        auto loop_properties = [](llvm::Function* func) {
+            std::vector<std::string> properties;
+            size_t access_groups = 0;
+            for (auto& inst : llvm::instructions(*func)) {
+                if (auto loop_id = inst.getMetadata(llvm::LLVMContext::MD_loop)) {
+                    for (size_t n = 1; n < loop_id->getNumOperands(); ++n) {
+                        auto property = llvm::cast<llvm::MDNode>(loop_id->getOperand(n));
+                        properties.push_back(llvm::cast<llvm::MDString>(property->getOperand(0))->getString().str());
+                    }
+                }
+                if (inst.getMetadata(llvm::LLVMContext::MD_access_group)) {
+                    access_groups++;
+                }
+            }
+            return std::make_pair(properties, access_groups);
+        };
+
+        auto module = comp->take_module();
+        module.withModuleDo([&](llvm::Module& m) {
+            auto [sum_props, sum_groups] = loop_properties(m.getFunction(sum_name));
+            REQUIRE( sum_props == std::vector<std::string>{"llvm.loop.vectorize.enable", "llvm.loop.vectorize.width", "llvm.loop.parallel_accesses"} );
+            REQUIRE( sum_groups > 0 );
+
+            auto [scale_props, scale_groups] = loop_properties(m.getFunction(scale_name));
+            REQUIRE( scale_props == std::vector<std::string>{"llvm.loop.unroll.disable", "llvm.loop.vectorize.width"} );
+            REQUIRE( scale_groups == 0 );
+
+            auto [count_props, count_groups] = loop_properties(m.getFunction(count_name));
+            REQUIRE( count_props == std::vector<std::string>{"llvm.loop.unroll.enable"} );
+        });
+    }
+
+    SECTION("Vectorized loop") {
+        comp->parse_source(src, k::optimization_level::O2);
+        auto sum_name = comp->get_element_mangled_name("sum");
+
+        auto module = comp->take_module();
+        module.withModuleDo([&](llvm::Module& m) {
+            bool vectorized = false;
+            for (auto& inst : llvm::instructions(*m.getFunction(sum_name))) {
+                vectorized |= inst.getType()->isVectorTy();
+            }
+            REQUIRE( vectorized );
+        });
+    }
+
+    SECTION("Execution") {
+        comp->parse_source(src, k::optimization_level::O2);
+        auto jit = comp->to_jit();
+        REQUIRE(jit);
+
+        int arr[64];
+        for (int n = 0; n < 64; ++n) {
+            arr[n] = n;
+        }
+
+        auto scale = jit->lookup_symbol<void(*)(int(*)[64], int)>("scale");
+        REQUIRE( scale != nullptr );
+        scale(&arr, 2);
+        REQUIRE( arr[63] == 126 );
+
+        auto sum = jit->lookup_symbol<int(*)(int(*)[64])>("sum");
+        REQUIRE( sum != nullptr );
+        REQUIRE( sum(&arr) == 4032 );
+
+        auto count = jit->lookup_symbol<int(*)(int)>("count");
+        REQUIRE( count != nullptr );
+        REQUIRE( count(0) == 0 );
+        REQUIRE( count(10) == 10 );
+    }
+}
+
+//
+// SIMD vectors
+//
+
+TEST_CASE("SIMD vectors", "[gen][vector]") {
+    auto src = R"SRC(
+        module test;
+        dot(a: float[[4]], b: float[[4]]) : float {
+            return reduce_add(a * b);
+        }
+
+        madd(a: float[[4]]&, b: float[[4]]&, f: float) : float {
+            r : float[[4]] = a * b + f;
+            return reduce_add(r);
+        }
+
+        premul(a: float[[4]]&, f: float) : float {
+            return reduce_add(f * a);
+        }
+
+        lane(a: int[[8]]&, i: int) : int {
+            return a[i];
+        }
+
+        set_lane(a: int[[8]]&, i: int, v: int) {
+            a[i] = v;
+        }
+
+        extent(a: int[[8]]&) : int {
+            return reduce_max(a) - reduce_min(a);
+        }
+
+        reverse(a: int[[4]]&, b: int[[4]]&) {
+            b = shuffle(a, 3, 2, 1, 0);
+        }
+
+        interleave(a: int[[4]]&, b: int[[4]]&, c: int[[4]]&) {
+            c = shuffle(a, b, 0, 4, 1, 5);
+        }
+
+        scale(a: int[[4]]&, f: int) {
+            a *= f;
+        }
+        )SRC";
+
+    auto comp = k::compiler::create();
+
+    SECTION("Vector instructions") {
+        comp->parse_source(src, false);
+        REQUIRE( comp->get_element_mangled_name("dot") == "_KFN4test3dotEDv4_fDv4_f" );
+        REQUIRE( k::model::mangler::demangle("_KFN4test3dotEDv4_fDv4_f") == "test::dot(float[[4]], float[[4]])" );
+        auto madd_name = comp->get_element_mangled_name("madd");
+        auto premul_name = comp->get_element_mangled_name("premul");
+        auto reverse_name = comp->get_element_mangled_name("reverse");
+        auto scale_name = comp->get_element_mangled_name("scale");
+        auto lane_name = comp->get_element_mangled_name("lane");
+        auto set_lane_name = comp->get_element_mangled_name("set_lane");
+
+        auto module = comp->take_module();
+        module.withModuleDo([&](llvm::Module& m) {
+            auto count = [](llvm::Function* func, unsigned opcode) {
+                size_t res = 0;
+                for (auto& inst : llvm::instructions(*func)) {
+                    if (inst.getOpcode() == opcode && inst.getType()->isVectorTy()) {
+                        res++;
+                    }
+                }
+                return res;
+            };
+            auto calls = [](llvm::Function* func, llvm::Intrinsic::ID id) {
+                size_t res = 0;
+                for (auto& inst : llvm::instructions(*func)) {
+                    if (auto call = llvm::dyn_cast<llvm::IntrinsicInst>(&inst); call && call->getIntrinsicID() == id) {
+                        res++;
+                    }
+                }
+                return res;
+            };
+
+            auto madd = m.getFunction(madd_name);
+            REQUIRE( count(madd, llvm::Instruction::FMul) == 1 );
+            REQUIRE( count(madd, llvm::Instruction::FAdd) == 1 );
+            REQUIRE( count(madd, llvm::Instruction::ShuffleVector) == 1 ); // Splat of f
+            REQUIRE( calls(madd, llvm::Intrinsic::vector_reduce_fadd) == 1 );
+
+            auto premul = m.getFunction(premul_name);
+            REQUIRE( count(premul, llvm::Instruction::FMul) == 1 );
+            REQUIRE( count(premul, llvm::Instruction::ShuffleVector) == 1 ); // Splat of f
+
+            REQUIRE( count(m.getFunction(reverse_name), llvm::Instruction::ShuffleVector) == 1 );
+            REQUIRE( count(m.getFunction(scale_name), llvm::Instruction::Mul) == 1 );
+
+            // Lanes are read and written through the whole vector, not through the lane address.
+            auto lane_accesses = [](llvm::Function* func, unsigned opcode) {
+                size_t res = 0;
+                for (auto& inst : llvm::instructions(*func)) {
+                    if (auto load = llvm::dyn_cast<llvm::LoadInst>(&inst)) {
+                        REQUIRE_FALSE( llvm::isa<llvm::GetElementPtrInst>(load->getPointerOperand()) );
+                    } else if (auto store = llvm::dyn_cast<llvm::StoreInst>(&inst)) {
+                        REQUIRE_FALSE( llvm::isa<llvm::GetElementPtrInst>(store->getPointerOperand()) );
+                    }
+                    if (inst.getOpcode() == opcode) {
+                        res++;
+                    }
+                }
+                return res;
+            };
+            REQUIRE( lane_accesses(m.getFunction(lane_name), llvm::Instruction::ExtractElement) == 1 );
+            REQUIRE( lane_accesses(m.getFunction(set_lane_name), llvm::Instruction::InsertElement) == 1 );
+        });
+    }
+
+    SECTION("Execution") {
+        comp->parse_source(src, k::optimization_level::O2);
+        auto jit = comp->to_jit();
+        REQUIRE(jit);
+
+        alignas(16) float fa[4] = {1.0f, 2.0f, 3.0f, 4.0f};
+        alignas(16) float fb[4] = {5.0f, 6.0f, 7.0f, 8.0f};
+        auto madd = jit->lookup_symbol<float(*)(float(*)[4], float(*)[4], float)>("madd");
+        REQUIRE( madd != nullptr );
+        REQUIRE( madd(&fa, &fb, 1.0f) == 74.0f );
+
+        auto premul = jit->lookup_symbol<float(*)(float(*)[4], float)>("premul");
+        REQUIRE( premul != nullptr );
+        REQUIRE( premul(&fa, 2.0f) == 20.0f );
+
+        alignas(32) int v8[8] = {3, -7, 12, 0, 5, 9, -2, 4};
+        auto lane = jit->lookup_symbol<int(*)(int(*)[8], int)>("lane");
+        auto set_lane = jit->lookup_symbol<void(*)(int(*)[8], int, int)>("set_lane");
+        auto extent = jit->lookup_symbol<int(*)(int(*)[8])>("extent");
+        REQUIRE( lane != nullptr );
+        REQUIRE( set_lane != nullptr );
+        REQUIRE( extent != nullptr );
+        REQUIRE( lane(&v8, 2) == 12 );
+        REQUIRE( extent(&v8) == 19 );
+        set_lane(&v8, 1, 20);
+        REQUIRE( lane(&v8, 1) == 20 );
+        REQUIRE( extent(&v8) == 22 );
+
+        alignas(16) int a[4] = {1, 2, 3, 4};
+        alignas(16) int b[4] = {5, 6, 7, 8};
+        alignas(16) int c[4] = {0, 0, 0, 0};
+        auto reverse = jit->lookup_symbol<void(*)(int(*)[4], int(*)[4])>("reverse");
+        REQUIRE( reverse != nullptr );
+        reverse(&a, &c);
+        REQUIRE( c[0] == 4 );
+        REQUIRE( c[3] == 1 );
+
+        auto interleave = jit->lookup_symbol<void(*)(int(*)[4], int(*)[4], int(*)[4])>("interleave");
+        REQUIRE( interleave != nullptr );
+        interleave(&a, &b, &c);
+        REQUIRE( c[0] == 1 );
+        REQUIRE( c[1] == 5 );
+        REQUIRE( c[2] == 2 );
+        REQUIRE( c[3] == 6 );
+
+        auto scale = jit->lookup_symbol<void(*)(int(*)[4], int)>("scale");
+        REQUIRE( scale != nullptr );
+        scale(&a, 3);
+        REQUIRE( a[0] == 3 );
+        REQUIRE( a[3] == 12 );
+    }
+
+    SECTION("Rejected vectors") {
+        REQUIRE_THROWS_AS( resolve_source(R"SRC(
+            module test;
+            bad(a: bool[[4]]) {}
+            )SRC"), std::runtime_error );
+        REQUIRE_THROWS_AS( resolve_source(R"SRC(
+            module test;
+            bad(a: int) : int {
+                return reduce_add(a);
+            }
+            )SRC"), k::model::gen::resolution_error );
+        REQUIRE_THROWS_AS( resolve_source(R"SRC(
+            module test;
+            bad(a: int[[4]], b: int[[4]]) : int {
+                return reduce_add(a, b);
+            }
+            )SRC"), k::model::gen::resolution_error );
+        REQUIRE_THROWS_AS( resolve_source(R"SRC(
+            module test;
+            bad(a: int[[4]], b: float[[4]]) : int[[4]] {
+                return shuffle(a, b, 0, 4, 1, 5);
+            }
+            )SRC"), k::model::gen::resolution_error );
+        REQUIRE_THROWS_AS( resolve_source(R"SRC(
+            module test;
+            bad(a: int[[4]]) : int[[4]] {
+                return shuffle(a);
+            }
+            )SRC"), k::model::gen::resolution_error );
+        REQUIRE_THROWS_AS( resolve_source(R"SRC(
+            module test;
+            bad(a: int[[4]], i: int) : int[[4]] {
+                return shuffle(a, i, 2, 1, 0);
+            }
+            )SRC"), k::model::gen::resolution_error );
+    }
+}
+
 //
 // Pointer, addresses and value-of
 //
@@ -2385,6 +2874,166 @@ TEST_CASE("Array indices references", "[gen][refs][array]") {
     REQUIRE(arr[3] == 8);
 }
 
+TEST_CASE("Checked array subscripts", "[gen][array]") {
+    auto src = R"SRC(
+        module test;
+        sum(p: int[8]&) : int {
+            res : int = 0;
+            for(i : int = 0; i < 8; i+=1) {
+                res += p[i];
+            }
+            return res;
+        }
+
+        sum_odd(p: int[8]&) : int {
+            res : int = 0;
+            for(i : int = 0; i <= 7; i = i + 1) {
+                i += 1;
+                res += p[i];
+            }
+            return res;
+        }
+
+        get(p: int[8]&, i: int) : int {
+            return p[i] + p[7];
+        }
+        )SRC";
+
+    auto comp = k::compiler::create();
+    comp->set_checked_subscripts(true);
+
+    SECTION("Subscripts proven in bounds are not checked") {
+        comp->parse_source(src, false);
+        auto sum_name = comp->get_element_mangled_name("sum");
+        auto sum_odd_name = comp->get_element_mangled_name("sum_odd");
+        auto get_name = comp->get_element_mangled_name("get");
+
+        auto count_traps = [](llvm::Function* func) {
+            size_t count = 0;
+            for (auto& inst : llvm::instructions(*func)) {
+                if (auto intrinsic = llvm::dyn_cast<llvm::IntrinsicInst>(&inst); intrinsic && intrinsic->getIntrinsicID() == llvm::Intrinsic::trap) {
+                    count++;
+                }
+            }
+            return count;
+        };
+
+        auto module = comp->take_module();
+        module.withModuleDo([&](llvm::Module& m) {
+            REQUIRE( m.getFunction(sum_name) != nullptr );
+            REQUIRE( count_traps(m.getFunction(sum_name)) == 0 );
+            // Loop variable is modified in the loop body
+            REQUIRE( count_traps(m.getFunction(sum_odd_name)) == 1 );
+            // Constant index is in bounds, not the parameter one
+            REQUIRE( count_traps(m.getFunction(get_name)) == 1 );
+        });
+    }
+
+    SECTION("Checked subscripts execution") {
+        comp->parse_source(src, k::optimization_level::O2);
+        auto jit = comp->to_jit();
+        REQUIRE(jit);
+
+        int arr[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+        auto sum = jit->lookup_symbol<int(*)(int(*)[8])>("sum");
+        REQUIRE( sum != nullptr );
+        REQUIRE( sum(&arr) == 36 );
+
+        auto sum_odd = jit->lookup_symbol<int(*)(int(*)[8])>("sum_odd");
+        REQUIRE( sum_odd != nullptr );
+        REQUIRE( sum_odd(&arr) == 20 );
+
+        auto get = jit->lookup_symbol<int(*)(int(*)[8], int)>("get");
+        REQUIRE( get != nullptr );
+        REQUIRE( get(&arr, 2) == 11 );
+    }
+}
+
+TEST_CASE("Array subscript facts", "[gen][array]") {
+    auto src = R"SRC(
+        module test;
+        sum(p: int[8]&) : int {
+            res : int = 0;
+            for(i : int = 0; i < 8; i+=1) {
+                res += p[i];
+            }
+            return res;
+        }
+
+        get(p: int[8]&, i: int) : int {
+            return p[i];
+        }
+        )SRC";
+
+    auto comp = k::compiler::create();
+
+    auto count_geps = [](llvm::Function* func, bool in_bounds) {
+        size_t count = 0;
+        for (auto& inst : llvm::instructions(*func)) {
+            if (auto gep = llvm::dyn_cast<llvm::GetElementPtrInst>(&inst); gep && gep->isInBounds() == in_bounds) {
+                count++;
+            }
+        }
+        return count;
+    };
+
+    SECTION("In bounds accesses") {
+        comp->parse_source(src, k::optimization_level::O0);
+        auto sum_name = comp->get_element_mangled_name("sum");
+        auto get_name = comp->get_element_mangled_name("get");
+
+        auto module = comp->take_module();
+        module.withModuleDo([&](llvm::Module& m) {
+            // Only indices proven in bounds (or checked) make in bounds accesses.
+            REQUIRE( count_geps(m.getFunction(sum_name), true) == 1 );
+            REQUIRE( count_geps(m.getFunction(get_name), true) == 0 );
+            REQUIRE( count_geps(m.getFunction(get_name), false) == 1 );
+        });
+    }
+
+    SECTION("Checked accesses") {
+        comp->set_checked_subscripts(true);
+        comp->parse_source(src, k::optimization_level::O0);
+        auto get_name = comp->get_element_mangled_name("get");
+
+        auto module = comp->take_module();
+        module.withModuleDo([&](llvm::Module& m) {
+            REQUIRE( count_geps(m.getFunction(get_name), true) == 1 );
+        });
+    }
+
+    SECTION("Index range after variable promotion") {
+        comp->parse_source(src, k::optimization_level::O0);
+        auto sum_name = comp->get_element_mangled_name("sum");
+
+        auto module = comp->take_module();
+        module.withModuleDo([&](llvm::Module& m) {
+            auto sum = m.getFunction(sum_name);
+
+            // Promote local variables to registers, as the optimization pipelines do first.
+            llvm::FunctionAnalysisManager fam;
+            llvm::PassBuilder builder;
+            builder.registerFunctionAnalyses(fam);
+            llvm::FunctionPassManager passes;
+            passes.addPass(llvm::SROAPass(llvm::SROAOptions::ModifyCFG));
+            passes.run(*sum, fam);
+
+            // The range of the loop variable is still known once it is not loaded anymore.
+            bool assumed = false;
+            for (auto& inst : llvm::instructions(*sum)) {
+                REQUIRE_FALSE( llvm::isa<llvm::LoadInst>(&inst) && inst.getType()->isIntegerTy(32) && llvm::isa<llvm::AllocaInst>(inst.getOperand(0)) );
+                if (auto call = llvm::dyn_cast<llvm::IntrinsicInst>(&inst); call && call->getIntrinsicID() == llvm::Intrinsic::assume) {
+                    auto cmp = llvm::dyn_cast<llvm::ICmpInst>(call->getArgOperand(0));
+                    auto bound = cmp ? llvm::dyn_cast<llvm::ConstantInt>(cmp->getOperand(1)) : nullptr;
+                    assumed |= cmp && cmp->getPredicate() == llvm::ICmpInst::ICMP_ULT && bound && bound->getZExtValue() == 8;
+                }
+            }
+            REQUIRE( assumed );
+        });
+    }
+}
+
 //
 // Structure content references and invocation
 //
@@ -2513,6 +3162,383 @@ TEST_CASE("Structure content and invocation through reference", "[gen][struct]")
     REQUIRE( res_test_ref == ((28 + 72) + 72) );
 }
 
+TEST_CASE("Small structures passed and returned by value", "[gen][struct]") {
+    auto src = R"SRC(
+        module test;
+
+        struct pair {
+            a : int;
+            b : int;
+            sum() : int {
+                return a + b;
+            }
+        }
+
+        struct vec3 {
+            x : float;
+            y : float;
+            z : float;
+        }
+
+        struct mixed {
+            d : double;
+            i : int;
+        }
+
+        make_pair(a : int, b : int) : pair {
+            p : pair;
+            p.a = a;
+            p.b = b;
+            return p;
+        }
+
+        swap(p : pair) : pair {
+            r : pair;
+            r.a = p.b;
+            r.b = p.a;
+            return r;
+        }
+
+        chain(a : int, b : int) : int {
+            s : pair = swap(make_pair(a, b));
+            return s.a * 10 + s.sum();
+        }
+
+        scale(v : vec3, f : float) : vec3 {
+            r : vec3;
+            r.x = v.x * f;
+            r.y = v.y * f;
+            r.z = v.z * f;
+            return r;
+        }
+
+        make_mixed(d : double, i : int) : mixed {
+            m : mixed;
+            m.d = d;
+            m.i = i;
+            return m;
+        }
+
+        total(m : mixed) : double {
+            return m.d + (double) m.i;
+        }
+
+        struct wide {
+            a : long;
+            b : long;
+        }
+
+        spill(a : int, b : int, c : int, d : int, e : int, w : wide, f : int) : long {
+            return w.a * 10 + w.b * 100 + (long) f * 1000 + (long) (a + b + c + d + e);
+        }
+
+        call_spill(a : long, b : long) : long {
+            w : wide;
+            w.a = a;
+            w.b = b;
+            return spill(1, 1, 1, 1, 1, w, 2);
+        }
+        )SRC";
+
+    SECTION("Coerced IR") {
+        // Coercion follows the System V x86-64 ABI.
+        auto target = create_target_machine("x86_64-unknown-linux-gnu");
+        auto comp = k::compiler::create(target.get());
+        comp->parse_source(src, k::optimization_level::O0);
+        auto swap_name = comp->get_element_mangled_name("swap");
+        auto scale_name = comp->get_element_mangled_name("scale");
+        auto total_name = comp->get_element_mangled_name("total");
+        auto spill_name = comp->get_element_mangled_name("spill");
+        auto call_spill_name = comp->get_element_mangled_name("call_spill");
+
+        auto module = comp->take_module();
+        module.withModuleDo([&](llvm::Module& m) {
+            auto& ctx = m.getContext();
+
+            // {int, int} is passed and returned as a single 64-bit integer.
+            auto swap = m.getFunction(swap_name);
+            REQUIRE( swap->getReturnType() == llvm::Type::getInt64Ty(ctx) );
+            REQUIRE( swap->arg_size() == 1 );
+            REQUIRE( swap->getArg(0)->getType() == llvm::Type::getInt64Ty(ctx) );
+
+            // {float, float, float} is passed as <2 x float> and float.
+            auto scale = m.getFunction(scale_name);
+            REQUIRE( scale->arg_size() == 3 );
+            REQUIRE( scale->getArg(0)->getType() == llvm::FixedVectorType::get(llvm::Type::getFloatTy(ctx), 2) );
+            REQUIRE( scale->getArg(1)->getType() == llvm::Type::getFloatTy(ctx) );
+            REQUIRE( scale->getReturnType()->isStructTy() );
+
+            // {double, int} is passed as double and i32.
+            auto total = m.getFunction(total_name);
+            REQUIRE( total->arg_size() == 2 );
+            REQUIRE( total->getArg(0)->getType() == llvm::Type::getDoubleTy(ctx) );
+            REQUIRE( total->getArg(1)->getType() == llvm::Type::getInt32Ty(ctx) );
+
+            // {long, long} needs two general purpose registers when only one is left: it is passed in memory,
+            // and the last int still takes the remaining register.
+            auto spill = m.getFunction(spill_name);
+            REQUIRE( spill->arg_size() == 7 );
+            REQUIRE( spill->getArg(5)->getType()->isPointerTy() );
+            REQUIRE( spill->getParamByValType(5) != nullptr );
+            REQUIRE( spill->getArg(6)->getType() == llvm::Type::getInt32Ty(ctx) );
+            bool byval_call = false;
+            for (auto& inst : llvm::instructions(m.getFunction(call_spill_name))) {
+                if (auto call = llvm::dyn_cast<llvm::CallInst>(&inst); call && call->getCalledFunction() == spill) {
+                    byval_call = call->getParamByValType(5) != nullptr;
+                }
+            }
+            REQUIRE( byval_call );
+
+            // 'this' is used without local storage.
+            for (auto& func : m) {
+                for (auto& inst : llvm::instructions(func)) {
+                    if (auto alloca = llvm::dyn_cast<llvm::AllocaInst>(&inst)) {
+                        REQUIRE( alloca->getName() != "this" );
+                    }
+                }
+            }
+        });
+    }
+
+    SECTION("Execution") {
+        auto comp = k::compiler::create();
+        comp->parse_source(src, k::optimization_level::O0);
+        auto jit = comp->to_jit();
+        REQUIRE(jit);
+
+        struct pair {
+            int a;
+            int b;
+        };
+        struct vec3 {
+            float x;
+            float y;
+            float z;
+        };
+        struct mixed {
+            double d;
+            int i;
+        };
+
+        auto swap = jit->lookup_symbol<pair(*)(pair)>("swap");
+        REQUIRE( swap != nullptr );
+        auto swapped = swap({1, 2});
+        REQUIRE( swapped.a == 2 );
+        REQUIRE( swapped.b == 1 );
+
+        auto chain = jit->lookup_symbol<int(*)(int, int)>("chain");
+        REQUIRE( chain != nullptr );
+        REQUIRE( chain(3, 4) == 47 );
+
+        auto scale = jit->lookup_symbol<vec3(*)(vec3, float)>("scale");
+        REQUIRE( scale != nullptr );
+        auto scaled = scale({1.0f, 2.0f, 3.0f}, 2.0f);
+        REQUIRE( scaled.x == 2.0f );
+        REQUIRE( scaled.y == 4.0f );
+        REQUIRE( scaled.z == 6.0f );
+
+        auto make_mixed = jit->lookup_symbol<mixed(*)(double, int)>("make_mixed");
+        REQUIRE( make_mixed != nullptr );
+        auto m = make_mixed(1.5, 3);
+        REQUIRE( m.d == 1.5 );
+        REQUIRE( m.i == 3 );
+
+        auto total = jit->lookup_symbol<double(*)(mixed)>("total");
+        REQUIRE( total != nullptr );
+        REQUIRE( total({1.5, 3}) == 4.5 );
+
+        struct wide {
+            long a;
+            long b;
+        };
+        auto call_spill = jit->lookup_symbol<long(*)(long, long)>("call_spill");
+        REQUIRE( call_spill != nullptr );
+        REQUIRE( call_spill(3, 4) == 2435 );
+        auto spill = jit->lookup_symbol<long(*)(int, int, int, int, int, wide, int)>("spill");
+        REQUIRE( spill != nullptr );
+        REQUIRE( spill(1, 2, 3, 4, 5, {6, 7}, 8) == 8775 );
+    }
+}
+
+TEST_CASE("Structure layout controls", "[gen][struct]") {
+    auto src = R"SRC(
+        module test;
+
+        struct natural {
+            a : byte;
+            b : double;
+            c : byte;
+        }
+
+        [[reorder]]
+        struct reordered {
+            a : byte;
+            b : double;
+            c : byte;
+        }
+
+        [[packed]]
+        struct packed {
+            a : byte;
+            b : double;
+            c : byte;
+        }
+
+        [[align(32)]]
+        struct aligned {
+            a : int;
+        }
+
+        struct field_aligned {
+            a : byte;
+            [[align(8)]] b : int;
+        }
+
+        gp : packed;
+
+        set_packed(a : byte, b : double, c : byte) : double {
+            gp.a = a;
+            gp.b = b;
+            gp.c = c;
+            return gp.b;
+        }
+
+        sum_reordered(a : byte, b : double, c : byte) : double {
+            r : reordered;
+            r.a = a;
+            r.b = b;
+            r.c = c;
+            return r.b + (double) r.a + (double) r.c;
+        }
+        )SRC";
+
+    auto comp = k::compiler::create();
+
+    SECTION("Layout") {
+        comp->parse_source(src, k::optimization_level::O0);
+
+        auto get_struct_type = [&](const std::string& name) {
+            auto elems = comp->find_elements(name);
+            REQUIRE( elems.size() == 1 );
+            auto st = std::dynamic_pointer_cast<k::model::structure>(elems.front());
+            REQUIRE( st != nullptr );
+            return st->get_struct_type();
+        };
+
+        // Declaration order, natural alignment.
+        auto natural = get_struct_type("natural");
+        REQUIRE( natural->get_size() == 24 );
+        REQUIRE( natural->get_member("b")->offset == 8 );
+        REQUIRE( natural->get_member("c")->offset == 16 );
+        REQUIRE_FALSE( natural->has_custom_layout() );
+
+        // Biggest alignment first.
+        auto reordered = get_struct_type("reordered");
+        REQUIRE( reordered->get_size() == 16 );
+        REQUIRE( reordered->get_member("b")->offset == 0 );
+        REQUIRE( reordered->get_member("a")->offset == 8 );
+        REQUIRE( reordered->get_member("c")->offset == 9 );
+
+        // No padding.
+        auto packed = get_struct_type("packed");
+        REQUIRE( packed->get_size() == 10 );
+        REQUIRE( packed->get_alignment() == 1 );
+        REQUIRE( packed->get_member("b")->offset == 1 );
+        REQUIRE( packed->get_member("c")->offset == 9 );
+        REQUIRE( packed->has_custom_layout() );
+
+        auto aligned = get_struct_type("aligned");
+        REQUIRE( aligned->get_size() == 32 );
+        REQUIRE( aligned->get_alignment() == 32 );
+
+        auto field_aligned = get_struct_type("field_aligned");
+        REQUIRE( field_aligned->get_size() == 16 );
+        REQUIRE( field_aligned->get_alignment() == 8 );
+        REQUIRE( field_aligned->get_member("b")->offset == 8 );
+
+        std::ostringstream report;
+        comp->print_struct_layouts(report);
+        REQUIRE( report.str().find("size 24, alignment 8, padding 14") != std::string::npos );
+        REQUIRE( report.str().find("size 10, alignment 1, padding 0") != std::string::npos );
+    }
+
+    SECTION("Reordering option") {
+        comp->set_reorder_struct_fields(true);
+        comp->parse_source(src, k::optimization_level::O0);
+
+        // Structures without layout attributes are reordered, others keep their layout.
+        auto natural = std::dynamic_pointer_cast<k::model::structure>(comp->find_elements("natural").front())->get_struct_type();
+        REQUIRE( natural->get_size() == 16 );
+        auto packed = std::dynamic_pointer_cast<k::model::structure>(comp->find_elements("packed").front())->get_struct_type();
+        REQUIRE( packed->get_member("b")->offset == 1 );
+    }
+
+    SECTION("Execution") {
+        comp->parse_source(src, k::optimization_level::O2);
+        auto jit = comp->to_jit();
+        REQUIRE(jit);
+
+        struct __attribute__((packed)) packed {
+            unsigned char a;
+            double b;
+            unsigned char c;
+        };
+        static_assert(sizeof(packed) == 10);
+
+        auto gp = jit->lookup_symbol<packed*>("gp");
+        REQUIRE( gp != nullptr );
+        auto set_packed = jit->lookup_symbol<double(*)(unsigned char, double, unsigned char)>("set_packed");
+        REQUIRE( set_packed != nullptr );
+        REQUIRE( set_packed(1, 2.5, 3) == 2.5 );
+        REQUIRE( gp->a == 1 );
+        REQUIRE( gp->b == 2.5 );
+        REQUIRE( gp->c == 3 );
+
+        auto sum_reordered = jit->lookup_symbol<double(*)(unsigned char, double, unsigned char)>("sum_reordered");
+        REQUIRE( sum_reordered != nullptr );
+        REQUIRE( sum_reordered(1, 2.5, 3) == 6.5 );
+    }
+
+    SECTION("References to fields") {
+        // References are accessed with the natural alignment of their type, they cannot refer to under-aligned fields.
+        REQUIRE_THROWS_AS( resolve_source(R"SRC(
+            module test;
+
+            [[packed]]
+            struct packed {
+                a : byte;
+                b : double;
+            }
+
+            get(d : double&) : double {
+                return d;
+            }
+
+            bad(p : packed&) : double {
+                return get(p.b);
+            }
+            )SRC"), k::model::gen::resolution_error );
+
+        REQUIRE_NOTHROW( resolve_source(R"SRC(
+            module test;
+
+            [[packed]]
+            struct packed {
+                a : byte;
+                b : double;
+            }
+
+            get(b : byte&) : byte {
+                return b;
+            }
+
+            good(p : packed&) : byte {
+                return get(p.a);
+            }
+            )SRC") );
+    }
+}
+
 //
 // Var name lookup and "this" usage
 //
@@ -2789,6 +3815,85 @@ TEST_CASE("Relative mangled name lookup", "[gen][name_lookup]") {
     REQUIRE_THROWS_AS(comp->get_element_mangled_name("blahblah::blah"), std::runtime_error);
 }
 
+TEST_CASE("Lazy and interned element names", "[gen][name_lookup]") {
+    const char* src = R"SRC(
+        module the::test;
+
+        sum(a: int, b: int) : int {
+            c : int = a + b;
+            return c;
+        }
+        )SRC";
+    auto comp1 = k::compiler::create();
+    comp1->parse_source(src);
+    auto comp2 = k::compiler::create();
+    comp2->parse_source(src);
+
+    auto sum1 = std::dynamic_pointer_cast<k::model::function>(comp1->find_elements("sum").front());
+    auto sum2 = std::dynamic_pointer_cast<k::model::function>(comp2->find_elements("sum").front());
+    REQUIRE( sum1->get_mangled_name() == "_KFN3the4test3sumEii" );
+
+    // Equal names of different units share the same storage.
+    REQUIRE( &sum1->get_fq_name() == &sum2->get_fq_name() );
+    REQUIRE( &sum1->get_mangled_name() == &sum2->get_mangled_name() );
+    REQUIRE( k::string_pool::intern("::the::test::sum").get() == &sum1->get_fq_name() );
+
+    // Pooled strings are released with their last holder.
+    std::weak_ptr<const std::string> unused = k::string_pool::intern("::the::test::unused");
+    REQUIRE( unused.expired() );
+    std::weak_ptr<const std::string> used = k::string_pool::intern("::the::test::sum");
+    REQUIRE_FALSE( used.expired() );
+
+    // Parameters are never mangled.
+    REQUIRE( sum1->get_parameter(0)->get_short_name() == "a" );
+    REQUIRE( sum1->get_parameter(0)->get_mangled_name().empty() );
+
+    // Names are computed again when renamed.
+    sum1->assign_name(k::name(true, {"the", "test", "add"}));
+    REQUIRE( sum1->get_fq_name() == "::the::test::add" );
+    REQUIRE( sum1->get_mangled_name() == "_KFN3the4test3addEii" );
+    sum1->assign_name("add");
+    REQUIRE( sum1->get_short_name() == "add" );
+    REQUIRE( sum1->get_fq_name().empty() );
+    REQUIRE( sum1->get_mangled_name().empty() );
+}
+
+TEST_CASE("Demangle names", "[gen][name_lookup]") {
+    using k::model::mangler;
+
+    // Functions:
+    REQUIRE( mangler::demangle("_KFN3the4test10test_localEv") == "the::test::test_local()" );
+    REQUIRE( mangler::demangle("_KFN4test4fiboEj") == "test::fibo(unsigned int)" );
+    REQUIRE( mangler::demangle("_KFN4test3addEiPKcRd") == "test::add(int, char const*, double&)" );
+    REQUIRE( mangler::demangle("_KFN4test4moveEN4test4plopE") == "test::move(test::plop)" );
+
+    // Member functions:
+    REQUIRE( mangler::demangle("_KFMN3the4test4plop3sumEv") == "the::test::plop::sum()" );
+    REQUIRE( mangler::demangle("_KFKMN3the4test4plop3sumEv") == "the::test::plop::sum() const" );
+
+    // Variables and structures:
+    REQUIRE( mangler::demangle("_KN3the4test1gE") == "the::test::g" );
+
+    // Round trip:
+    auto comp = k::compiler::create();
+    comp->parse_source(R"SRC(
+        module the::test;
+        struct plop {
+            a : int;
+            sum(b: int, c: double) : int {
+                return a + b;
+            }
+        }
+        )SRC");
+    REQUIRE( mangler::demangle(comp->get_element_mangled_name("plop::sum")) == "the::test::plop::sum(int, double)" );
+
+    // Not K symbols:
+    REQUIRE( mangler::demangle("main") == "main" );
+    REQUIRE( mangler::demangle("_ZN4test4fiboEj") == "_ZN4test4fiboEj" );
+    REQUIRE( mangler::demangle("_KFN4test") == "_KFN4test" );
+    REQUIRE( mangler::demangle("_KFN4test4fiboEjQ") == "_KFN4test4fiboEjQ" );
+}
+
 TEST_CASE("Relative to root namespace name lookup", "[gen][name_lookup]") {
 
     auto comp = k::compiler::create();
@@ -3043,5 +4148,1275 @@ TEST_CASE("Global primitive variable non-trivial initialization", "[gen]") {
     REQUIRE( res_test_b == 25 );
 }
 
+TEST_CASE("Global variable constant expression initialization", "[gen][variable]") {
+    auto comp = k::compiler::create();
+
+    SECTION("Constant initializers") {
+        comp->parse_source(R"SRC(
+            module test;
+            a : int = 2 * 21;
+            b : long = a + 1;
+            c : double = (double) b / 2.0;
+            d : bool = a > 40 && !(b == 0);
+            e : short = -a;
+            test() : long {
+                return b;
+            }
+            )SRC", k::optimization_level::O0);
+        auto b_name = comp->get_element_mangled_name("b");
+        auto c_name = comp->get_element_mangled_name("c");
+        auto d_name = comp->get_element_mangled_name("d");
+        auto e_name = comp->get_element_mangled_name("e");
+
+        auto module = comp->take_module();
+        module.withModuleDo([&](llvm::Module& m) {
+            // No startup constructor for constant initializers.
+            REQUIRE( m.getNamedGlobal("llvm.global_ctors") == nullptr );
+
+            auto b = llvm::dyn_cast<llvm::ConstantInt>(m.getNamedGlobal(b_name)->getInitializer());
+            REQUIRE( b != nullptr );
+            REQUIRE( b->getSExtValue() == 43 );
+            auto c = llvm::dyn_cast<llvm::ConstantFP>(m.getNamedGlobal(c_name)->getInitializer());
+            REQUIRE( c != nullptr );
+            REQUIRE( c->getValueAPF().convertToDouble() == 21.5 );
+            REQUIRE( m.getNamedGlobal(d_name)->getInitializer()->isOneValue() );
+            auto e = llvm::dyn_cast<llvm::ConstantInt>(m.getNamedGlobal(e_name)->getInitializer());
+            REQUIRE( e != nullptr );
+            REQUIRE( e->getSExtValue() == -42 );
+        });
+    }
+
+    SECTION("Dynamic initializers") {
+        comp->parse_source(R"SRC(
+            module test;
+            a : int = init();
+            b : int = a + 1;
+            c : int = 1 / 0;
+            init() : int {
+                return 25;
+            }
+            test() : int {
+                return b;
+            }
+            )SRC", k::optimization_level::O0);
+
+        auto module = comp->take_module();
+        module.withModuleDo([&](llvm::Module& m) {
+            // Initializers depending on a function call, or with undefined behavior, are still run at startup.
+            REQUIRE( m.getNamedGlobal("llvm.global_ctors") != nullptr );
+        });
+    }
+
+    SECTION("Execution") {
+        comp->parse_source(R"SRC(
+            module test;
+            a : int = 2 * 21;
+            b : long = a + 1;
+            c : int = init() + a;
+            init() : int {
+                return 25;
+            }
+            test_b() : long {
+                return b;
+            }
+            test_c() : int {
+                return c;
+            }
+            )SRC", k::optimization_level::O0);
+        auto jit = comp->to_jit();
+        REQUIRE(jit);
 
+        auto test_b = jit->lookup_symbol<int64_t(*)()>("test_b");
+        REQUIRE( test_b != nullptr );
+        REQUIRE( test_b() == 43 );
 
+        auto test_c = jit->lookup_symbol<int(*)()>("test_c");
+        REQUIRE( test_c != nullptr );
+        REQUIRE( test_c() == 25 + 42 );
+    }
+}
+
+TEST_CASE("Constant folding", "[gen][optimization]") {
+    auto src = R"SRC(
+        module test;
+        constant() : int {
+            return 2 * 3 + 4;
+        }
+        narrow() : short {
+            return (short) 70000;
+        }
+        signed_div() : int {
+            return -7 / 2;
+        }
+        unsigned_shift() : unsigned int {
+            return ((unsigned int) -8) >> 1;
+        }
+        neutral(x : int) : int {
+            return (x * 1 + 0) | 0;
+        }
+        dead_branch(x : int) : int {
+            if (2 > 3) {
+                return 1;
+            } else if (1 == 1) {
+                return x;
+            }
+            return 0;
+        }
+        )SRC";
+
+    auto comp = k::compiler::create();
+
+    SECTION("Folded IR") {
+        comp->parse_source(src, k::optimization_level::O0);
+        auto constant_name = comp->get_element_mangled_name("constant");
+        auto neutral_name = comp->get_element_mangled_name("neutral");
+        auto dead_branch_name = comp->get_element_mangled_name("dead_branch");
+
+        auto module = comp->take_module();
+        module.withModuleDo([&](llvm::Module& m) {
+            auto count = [](llvm::Function* func, auto predicate) {
+                size_t res = 0;
+                for (auto& inst : llvm::instructions(*func)) {
+                    if (predicate(inst)) {
+                        res++;
+                    }
+                }
+                return res;
+            };
+            auto is_arithmetic = [](llvm::Instruction& inst) { return llvm::isa<llvm::BinaryOperator>(inst); };
+            auto is_comparison = [](llvm::Instruction& inst) { return llvm::isa<llvm::CmpInst>(inst); };
+
+            REQUIRE( count(m.getFunction(constant_name), is_arithmetic) == 0 );
+            REQUIRE( count(m.getFunction(neutral_name), is_arithmetic) == 0 );
+            REQUIRE( count(m.getFunction(dead_branch_name), is_comparison) == 0 );
+        });
+    }
+
+    SECTION("Execution") {
+        comp->parse_source(src, k::optimization_level::O0);
+        auto jit = comp->to_jit();
+        REQUIRE(jit);
+
+        auto constant = jit->lookup_symbol<int(*)()>("constant");
+        REQUIRE( constant != nullptr );
+        REQUIRE( constant() == 10 );
+
+        auto narrow = jit->lookup_symbol<short(*)()>("narrow");
+        REQUIRE( narrow != nullptr );
+        REQUIRE( narrow() == (short) 70000 );
+
+        auto signed_div = jit->lookup_symbol<int(*)()>("signed_div");
+        REQUIRE( signed_div != nullptr );
+        REQUIRE( signed_div() == -3 );
+
+        auto unsigned_shift = jit->lookup_symbol<unsigned int(*)()>("unsigned_shift");
+        REQUIRE( unsigned_shift != nullptr );
+        REQUIRE( unsigned_shift() == ((unsigned int) -8) >> 1 );
+
+        auto neutral = jit->lookup_symbol<int(*)(int)>("neutral");
+        REQUIRE( neutral != nullptr );
+        REQUIRE( neutral(21) == 21 );
+
+        auto dead_branch = jit->lookup_symbol<int(*)(int)>("dead_branch");
+        REQUIRE( dead_branch != nullptr );
+        REQUIRE( dead_branch(42) == 42 );
+    }
+}
+
+
+
+
+TEST_CASE("Optimization levels", "[gen][optimization]") {
+    auto level = GENERATE(
+            k::optimization_level::O0,
+            k::optimization_level::O1,
+            k::optimization_level::O2,
+            k::optimization_level::O3,
+            k::optimization_level::Os,
+            k::optimization_level::Oz);
+
+    auto comp = k::compiler::create();
+    comp->parse_source(R"SRC(
+        module test;
+
+        fibo(i: unsigned short) : unsigned int {
+            if(i==0) return 1;
+            else if(i==1) return 1;
+            return fibo(i-1) + fibo(i-2);
+        }
+
+        sum(n: int) : int {
+            res : int = 0;
+            for(i : int = 0; i < n; i+=1) {
+                res += i;
+            }
+            return res;
+        }
+        )SRC", level);
+    REQUIRE( comp->get_optimization_level() == level );
+
+    auto jit = comp->to_jit();
+    REQUIRE(jit);
+
+    auto fibo = jit->lookup_symbol < unsigned int(*)(unsigned short) > ("fibo");
+    REQUIRE( fibo != nullptr );
+    REQUIRE( fibo(10) == 89 );
+
+    auto sum = jit->lookup_symbol < int(*)(int) > ("sum");
+    REQUIRE( sum != nullptr );
+    REQUIRE( sum(100) == 4950 );
+}
+
+TEST_CASE("Host CPU targeting", "[gen][target]") {
+    REQUIRE_FALSE( k::compiler::host_cpu_name().empty() );
+
+    auto cpu = GENERATE(std::string("native"), k::compiler::host_cpu_name());
+
+    auto comp = k::compiler::create();
+    comp->set_target_cpu(cpu, "native");
+    comp->parse_source(R"SRC(
+        module test;
+        sum(n: int) : int {
+            res : int = 0;
+            for(i : int = 0; i < n; i+=1) {
+                res += i;
+            }
+            return res;
+        }
+        )SRC", k::optimization_level::O3);
+
+    SECTION("Function attributes") {
+        // Features are compared as sets, their order is not significant.
+        auto split_features = [](const std::string& features) {
+            std::set<std::string> res;
+            std::istringstream stm(features);
+            std::string feature;
+            while (std::getline(stm, feature, ',')) {
+                if (!feature.empty()) {
+                    res.insert(feature);
+                }
+            }
+            return res;
+        };
+
+        auto sum_name = comp->get_element_mangled_name("sum");
+        auto module = comp->take_module();
+        module.withModuleDo([&](llvm::Module& m) {
+            auto sum = m.getFunction(sum_name);
+            REQUIRE( sum != nullptr );
+            REQUIRE( sum->getFnAttribute("target-cpu").getValueAsString().str() == k::compiler::host_cpu_name() );
+            REQUIRE( split_features(sum->getFnAttribute("target-features").getValueAsString().str())
+                     == split_features(k::compiler::host_cpu_features()) );
+        });
+    }
+
+    SECTION("Execution") {
+        auto jit = comp->to_jit();
+        REQUIRE(jit);
+
+        auto sum = jit->lookup_symbol < int(*)(int) > ("sum");
+        REQUIRE( sum != nullptr );
+        REQUIRE( sum(1000) == 499500 );
+    }
+}
+
+TEST_CASE("Fast math", "[gen][optimization]") {
+    auto src = R"SRC(
+        module test;
+        dot(p: double[64]&, q: double[64]&) : double {
+            res : double = 0.0;
+            for(i : int = 0; i < 64; i+=1) {
+                res += p[i] * q[i];
+            }
+            return res;
+        }
+
+        [[fast_math]]
+        fast_dot(p: double[64]&, q: double[64]&) : double {
+            res : double = 0.0;
+            for(i : int = 0; i < 64; i+=1) {
+                res += p[i] * q[i];
+            }
+            return res;
+        }
+
+        [[fast_math("contract")]]
+        fma(a: double, b: double, c: double) : double {
+            return a * b + c;
+        }
+
+        [[strict_math]]
+        strict(a: double, b: double) : double {
+            return a + b;
+        }
+
+        madd(a: double, b: double, c: double) : double {
+            return a * b + c;
+        }
+        )SRC";
+
+    auto comp = k::compiler::create();
+
+    // Flags of the floating point additions of a function.
+    auto fadd_flags = [](llvm::Function* func) {
+        std::vector<llvm::FastMathFlags> flags;
+        for (auto& inst : llvm::instructions(*func)) {
+            if (inst.getOpcode() == llvm::Instruction::FAdd) {
+                flags.push_back(inst.getFastMathFlags());
+            }
+        }
+        REQUIRE_FALSE( flags.empty() );
+        return flags;
+    };
+
+    SECTION("Function attributes") {
+        comp->parse_source(src, k::optimization_level::O0);
+        auto dot_name = comp->get_element_mangled_name("dot");
+        auto fast_dot_name = comp->get_element_mangled_name("fast_dot");
+        auto fma_name = comp->get_element_mangled_name("fma");
+
+        auto module = comp->take_module();
+        module.withModuleDo([&](llvm::Module& m) {
+            for (auto& flags : fadd_flags(m.getFunction(dot_name))) {
+                REQUIRE_FALSE( flags.any() );
+            }
+            for (auto& flags : fadd_flags(m.getFunction(fast_dot_name))) {
+                REQUIRE( flags.isFast() );
+            }
+            REQUIRE( m.getFunction(fast_dot_name)->getFnAttribute("unsafe-fp-math").getValueAsString() == "true" );
+            for (auto& flags : fadd_flags(m.getFunction(fma_name))) {
+                REQUIRE( flags.allowContract() );
+                REQUIRE_FALSE( flags.allowReassoc() );
+            }
+        });
+    }
+
+    SECTION("Compiler flags") {
+        comp->set_fast_math(k::fast_math_flags::fast());
+        comp->parse_source(src, k::optimization_level::O0);
+        auto dot_name = comp->get_element_mangled_name("dot");
+        auto strict_name = comp->get_element_mangled_name("strict");
+
+        auto module = comp->take_module();
+        module.withModuleDo([&](llvm::Module& m) {
+            for (auto& flags : fadd_flags(m.getFunction(dot_name))) {
+                REQUIRE( flags.isFast() );
+            }
+            // Function attributes replace compiler flags.
+            for (auto& flags : fadd_flags(m.getFunction(strict_name))) {
+                REQUIRE_FALSE( flags.any() );
+            }
+        });
+    }
+
+    SECTION("Flag names") {
+        auto flags = k::fast_math_flags::parse("reassoc,contract");
+        REQUIRE( flags );
+        REQUIRE( flags->reassoc );
+        REQUIRE( flags->contract );
+        REQUIRE_FALSE( flags->nnan );
+        REQUIRE( k::fast_math_flags::parse("fast")->all() );
+        REQUIRE_FALSE( k::fast_math_flags::parse("reassoc,unknown") );
+    }
+
+    SECTION("Vectorized reduction") {
+        comp->parse_source(src, k::optimization_level::O3);
+        auto dot_name = comp->get_element_mangled_name("dot");
+        auto fast_dot_name = comp->get_element_mangled_name("fast_dot");
+
+        auto module = comp->take_module();
+        module.withModuleDo([&](llvm::Module& m) {
+            auto vectorized = [](llvm::Function* func) {
+                for (auto& inst : llvm::instructions(*func)) {
+                    if (inst.getOpcode() == llvm::Instruction::FAdd && inst.getType()->isVectorTy()) {
+                        return true;
+                    }
+                }
+                return false;
+            };
+            // Strict floating point additions cannot be reordered.
+            REQUIRE_FALSE( vectorized(m.getFunction(dot_name)) );
+            REQUIRE( vectorized(m.getFunction(fast_dot_name)) );
+        });
+    }
+
+    SECTION("Fused multiply-add") {
+        auto target = create_target_machine("x86_64-unknown-linux-gnu", "+fma");
+        auto comp = k::compiler::create(target.get());
+        comp->parse_source(src, k::optimization_level::O2);
+        auto fma_name = comp->get_element_mangled_name("fma");
+        auto madd_name = comp->get_element_mangled_name("madd");
+
+        std::string asm_code;
+        auto module = comp->take_module();
+        module.withModuleDo([&](llvm::Module& m) {
+            llvm::raw_string_ostream stream(asm_code);
+            llvm::buffer_ostream buffer(stream);
+            llvm::legacy::PassManager pass;
+            REQUIRE_FALSE( target->addPassesToEmitFile(pass, buffer, nullptr, llvm::CodeGenFileType::AssemblyFile) );
+            pass.run(m);
+        });
+
+        // Assembly of a function, from its label to its end marker.
+        auto function_asm = [&](const std::string& name) {
+            auto start = asm_code.find(name + ":");
+            REQUIRE( start != std::string::npos );
+            auto end = asm_code.find(".Lfunc_end", start);
+            REQUIRE( end != std::string::npos );
+            return asm_code.substr(start, end - start);
+        };
+        // Contracted multiply and add are fused, strict ones are not.
+        REQUIRE( function_asm(fma_name).find("vfmadd") != std::string::npos );
+        REQUIRE( function_asm(madd_name).find("vfmadd") == std::string::npos );
+    }
+
+    SECTION("Execution") {
+        comp->parse_source(src, k::optimization_level::O3);
+        auto jit = comp->to_jit();
+        REQUIRE(jit);
+
+        double p[64], q[64];
+        double expected = 0.0;
+        for (int n = 0; n < 64; ++n) {
+            p[n] = n;
+            q[n] = 0.5;
+            expected += p[n] * q[n];
+        }
+
+        auto dot = jit->lookup_symbol<double(*)(double(*)[64], double(*)[64])>("dot");
+        REQUIRE( dot != nullptr );
+        REQUIRE( dot(&p, &q) == expected );
+
+        // Exact as long as all partial sums are representable.
+        auto fast_dot = jit->lookup_symbol<double(*)(double(*)[64], double(*)[64])>("fast_dot");
+        REQUIRE( fast_dot != nullptr );
+        REQUIRE( fast_dot(&p, &q) == expected );
+
+        auto fma = jit->lookup_symbol<double(*)(double, double, double)>("fma");
+        REQUIRE( fma != nullptr );
+        REQUIRE( fma(2.0, 3.0, 1.0) == 7.0 );
+    }
+}
+
+TEST_CASE("Non-exported functions", "[gen][visibility]") {
+    auto optimize = GENERATE(false, true);
+
+    auto comp = k::compiler::create();
+    comp->parse_source(R"SRC(
+        module test;
+
+        private fibo(i: unsigned int) : unsigned int {
+            if(i<2) return 1;
+            return fibo(i-1) + fibo(i-2);
+        }
+
+        struct counter {
+            value : int;
+        protected:
+            step() : int {
+                return 2;
+            }
+        public:
+            next() : int {
+                value += this.step();
+                return value;
+            }
+        }
+
+        test_fibo(i: unsigned int) : unsigned int {
+            return fibo(i);
+        }
+
+        test_counter() : int {
+            c : counter;
+            c.value = 40;
+            return c.next();
+        }
+        )SRC", optimize);
+
+    SECTION("Linkage and calling conventions") {
+        auto fibo_name = comp->get_element_mangled_name("fibo");
+        auto step_name = comp->get_element_mangled_name("counter::step");
+        auto test_fibo_name = comp->get_element_mangled_name("test_fibo");
+        auto next_name = comp->get_element_mangled_name("counter::next");
+
+        // Unoptimized, so calls are not inlined.
+        auto module = comp->take_module(false);
+        module.withModuleDo([&](llvm::Module& m) {
+            auto fibo = m.getFunction(fibo_name);
+            auto step = m.getFunction(step_name);
+            auto test_fibo = m.getFunction(test_fibo_name);
+            auto next = m.getFunction(next_name);
+            REQUIRE( fibo != nullptr );
+            REQUIRE( step != nullptr );
+            REQUIRE( test_fibo != nullptr );
+            REQUIRE( next != nullptr );
+
+            // Private and protected functions are internal and use the fast calling convention.
+            for (auto func : {fibo, step}) {
+                REQUIRE( func->hasInternalLinkage() );
+                REQUIRE( func->getCallingConv() == llvm::CallingConv::Fast );
+            }
+            // Exported functions keep the C calling convention.
+            for (auto func : {test_fibo, next}) {
+                REQUIRE( func->hasExternalLinkage() );
+                REQUIRE( func->getCallingConv() == llvm::CallingConv::C );
+            }
+
+            // Call sites match their callee.
+            size_t internal_calls = 0;
+            size_t exported_calls = 0;
+            for (auto& func : m) {
+                for (auto& inst : llvm::instructions(func)) {
+                    auto call = llvm::dyn_cast<llvm::CallInst>(&inst);
+                    if (!call) {
+                        continue;
+                    }
+                    auto callee = call->getCalledFunction();
+                    if (callee == fibo || callee == step) {
+                        REQUIRE( call->getCallingConv() == llvm::CallingConv::Fast );
+                        internal_calls++;
+                    } else if (callee == test_fibo || callee == next) {
+                        REQUIRE( call->getCallingConv() == llvm::CallingConv::C );
+                        exported_calls++;
+                    }
+                }
+            }
+            // fibo twice in fibo and once in test_fibo, step in next, and next in test_counter.
+            REQUIRE( internal_calls == 4 );
+            REQUIRE( exported_calls == 1 );
+        });
+    }
+
+    SECTION("Execution") {
+        auto jit = comp->to_jit();
+        REQUIRE(jit);
+
+        auto test_fibo = jit->lookup_symbol < unsigned int(*)(unsigned int) > ("test_fibo");
+        REQUIRE( test_fibo != nullptr );
+        REQUIRE( test_fibo(10) == 89 );
+
+        auto test_counter = jit->lookup_symbol < int(*)() > ("test_counter");
+        REQUIRE( test_counter != nullptr );
+        REQUIRE( test_counter() == 42 );
+    }
+}
+
+TEST_CASE("Partitioned code generation", "[gen][partitions]") {
+    const char* src = R"SRC(
+        module test;
+
+        fibo(i: unsigned int) : unsigned int {
+            if(i<2) return 1;
+            return fibo(i-1) + fibo(i-2);
+        }
+
+        twice(i: int) : int {
+            return i * 2;
+        }
+        )SRC";
+
+    SECTION("JIT runs the postponed optimization") {
+        auto comp = k::compiler::create();
+        comp->set_codegen_partitions(4);
+        comp->parse_source(src, k::optimization_level::O2);
+        auto jit = comp->to_jit();
+        REQUIRE(jit);
+
+        auto fibo = jit->lookup_symbol < unsigned int(*)(unsigned int) > ("fibo");
+        REQUIRE( fibo != nullptr );
+        REQUIRE( fibo(10) == 89 );
+
+        auto twice = jit->lookup_symbol < int(*)(int) > ("twice");
+        REQUIRE( twice != nullptr );
+        REQUIRE( twice(21) == 42 );
+    }
+
+    SECTION("Object file") {
+        auto comp = k::compiler::create();
+        comp->set_codegen_partitions(4);
+        comp->parse_source(src, k::optimization_level::O2);
+        temporary_file object("klang-test-partitions", "o");
+        REQUIRE( comp->gen_object_file(object.str()) );
+        REQUIRE( std::filesystem::file_size(object.str()) > 0 );
+    }
+
+    SECTION("Cross object file") {
+        // Objects of a foreign target cannot be combined by the host linker.
+        llvm::Triple host(llvm::sys::getProcessTriple());
+        std::string triple = host.getArch() == llvm::Triple::aarch64 ? "x86_64-unknown-linux-gnu" : "aarch64-unknown-linux-gnu";
+        auto target = create_target_machine(triple);
+        auto comp = k::compiler::create(target.get());
+        comp->set_codegen_partitions(4);
+        comp->parse_source(src, k::optimization_level::O2);
+
+        temporary_file object("klang-test-partitions-cross", "o");
+        REQUIRE( comp->gen_object_file(object.str()) );
+
+        auto buffer = llvm::MemoryBuffer::getFile(object.str());
+        REQUIRE( buffer );
+        auto file = llvm::object::ObjectFile::createObjectFile((*buffer)->getMemBufferRef());
+        REQUIRE( file );
+        REQUIRE( (*file)->getArch() == llvm::Triple(triple).getArch() );
+        bool has_fibo = false;
+        for (const auto& symbol : (*file)->symbols()) {
+            auto name = symbol.getName();
+            if (!name) {
+                llvm::consumeError(name.takeError());
+                continue;
+            }
+            has_fibo |= *name == comp->get_element_mangled_name("fibo");
+        }
+        REQUIRE( has_fibo );
+    }
+}
+
+TEST_CASE("Lazy JIT", "[gen][jit]") {
+    auto comp = k::compiler::create();
+    comp->parse_source(R"SRC(
+        module test;
+
+        value : int = 40;
+
+        private fibo(i: unsigned int) : unsigned int {
+            if(i<2) return 1;
+            return fibo(i-1) + fibo(i-2);
+        }
+
+        test_fibo(i: unsigned int) : unsigned int {
+            return fibo(i);
+        }
+
+        next() : int {
+            value += 2;
+            return value;
+        }
+        )SRC");
+
+    auto test_fibo_name = comp->get_element_mangled_name("test_fibo");
+    auto next_name = comp->get_element_mangled_name("next");
+
+    auto jit = comp->to_jit(k::jit_options{.lazy = true, .track_compiled_functions = true});
+    REQUIRE(jit);
+    REQUIRE(jit->is_lazy());
+
+    auto test_fibo = jit->lookup_symbol < unsigned int(*)(unsigned int) > ("test_fibo");
+    REQUIRE( test_fibo != nullptr );
+    auto next = jit->lookup_symbol < int(*)() > ("next");
+    REQUIRE( next != nullptr );
+    // Looking up functions does not compile them.
+    REQUIRE( jit->get_compiled_functions().count(test_fibo_name) == 0 );
+
+    REQUIRE( test_fibo(10) == 89 );
+    // Only called functions are compiled.
+    REQUIRE( jit->get_compiled_functions().count(test_fibo_name) == 1 );
+    REQUIRE( jit->get_compiled_functions().count(next_name) == 0 );
+
+    REQUIRE( next() == 42 );
+    REQUIRE( jit->get_compiled_functions().count(next_name) == 1 );
+}
+
+TEST_CASE("JIT object cache", "[gen][jit][cache]") {
+    const char* src = R"SRC(
+        module test;
+
+        fibo(i: unsigned int) : unsigned int {
+            if(i<2) return 1;
+            return fibo(i-1) + fibo(i-2);
+        }
+        )SRC";
+
+    temporary_directory directory("klang-test-jit-cache");
+
+    k::jit_options options;
+    options.cache_directory = directory.str();
+
+    SECTION("Warm start loads cached objects") {
+        for (size_t n = 0; n < 2; ++n) {
+            auto comp = k::compiler::create();
+            comp->parse_source(src);
+            auto jit = comp->to_jit(options);
+            REQUIRE(jit);
+            REQUIRE(jit->get_object_cache() != nullptr);
+
+            auto fibo = jit->lookup_symbol < unsigned int(*)(unsigned int) > ("fibo");
+            REQUIRE( fibo != nullptr );
+            REQUIRE( fibo(10) == 89 );
+
+            auto stats = jit->get_cache_statistics();
+            if (n == 0) {
+                REQUIRE( stats.hits == 0 );
+                REQUIRE( stats.misses > 0 );
+            } else {
+                REQUIRE( stats.hits > 0 );
+                REQUIRE( stats.misses == 0 );
+            }
+        }
+    }
+
+    SECTION("Size limit evicts objects") {
+        options.cache_max_size = 1;
+        auto comp = k::compiler::create();
+        comp->parse_source(src);
+        auto jit = comp->to_jit(options);
+        REQUIRE(jit);
+
+        auto fibo = jit->lookup_symbol < unsigned int(*)(unsigned int) > ("fibo");
+        REQUIRE( fibo != nullptr );
+        REQUIRE( fibo(10) == 89 );
+        REQUIRE( jit->get_cache_statistics().evictions > 0 );
+    }
+}
+
+TEST_CASE("Concurrent JIT compilation", "[gen][jit][threads]") {
+    auto lazy = GENERATE(false, true);
+
+    auto comp = k::compiler::create();
+    comp->parse_source(R"SRC(
+        module test;
+
+        fibo(i: unsigned int) : unsigned int {
+            if(i<2) return 1;
+            return fibo(i-1) + fibo(i-2);
+        }
+
+        twice(i: int) : int {
+            return i * 2;
+        }
+
+        square(i: int) : int {
+            return i * i;
+        }
+        )SRC");
+
+    k::jit_options options;
+    options.lazy = lazy;
+    options.compile_threads = 4;
+    auto jit = comp->to_jit(options);
+    REQUIRE(jit);
+
+    std::atomic<int> failures = 0;
+    std::vector<std::thread> threads;
+    for (int n = 0; n < 8; ++n) {
+        threads.emplace_back([&, n]() {
+            switch (n % 3) {
+                case 0: {
+                    auto fibo = jit->lookup_symbol < unsigned int(*)(unsigned int) > ("fibo");
+                    if (!fibo || fibo(10) != 89) ++failures;
+                    break;
+                }
+                case 1: {
+                    auto twice = jit->lookup_symbol < int(*)(int) > ("twice");
+                    if (!twice || twice(n) != n * 2) ++failures;
+                    break;
+                }
+                default: {
+                    auto square = jit->lookup_symbol < int(*)(int) > ("square");
+                    if (!square || square(n) != n * n) ++failures;
+                    break;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    REQUIRE( failures == 0 );
+}
+
+TEST_CASE("JIT symbol lookups", "[gen][jit]") {
+    auto jit = gen_jit(R"SRC(
+        module test;
+
+        value : int = 40;
+
+        twice(i: int) : int {
+            return i * 2;
+        }
+
+        square(i: int) : int {
+            return i * i;
+        }
+        )SRC");
+    REQUIRE(jit);
+
+    SECTION("Repeated lookups") {
+        auto first = jit->lookup_symbol < int(*)(int) > ("twice");
+        auto second = jit->lookup_symbol < int(*)(int) > ("twice");
+        REQUIRE( first != nullptr );
+        REQUIRE( first == second );
+        REQUIRE( second(21) == 42 );
+    }
+
+    SECTION("Batch lookup") {
+        auto addrs = jit->lookup_symbols({"twice", "square", "value", "_KNotASymbol"});
+        REQUIRE( addrs.size() == 4 );
+        REQUIRE( addrs[0] );
+        REQUIRE( addrs[1] );
+        REQUIRE( addrs[2] );
+        REQUIRE( !addrs[3] );
+        REQUIRE( addrs[0].toPtr<int(*)(int)>()(4) == 8 );
+        REQUIRE( addrs[1].toPtr<int(*)(int)>()(4) == 16 );
+        REQUIRE( *addrs[2].toPtr<int*>() == 40 );
+        REQUIRE( addrs[1].toPtr<int(*)(int)>() == jit->lookup_symbol < int(*)(int) > ("square") );
+    }
+
+    SECTION("Function handles") {
+        auto square = jit->get_function<int(int)>("square");
+        REQUIRE( square );
+        REQUIRE( square(7) == 49 );
+
+        auto missing = jit->get_function<int(int)>("_KNotASymbol");
+        REQUIRE( !missing );
+    }
+}
+
+TEST_CASE("Tiered JIT", "[gen][jit][tiered]") {
+    auto comp = k::compiler::create();
+    comp->parse_source(R"SRC(
+        module test;
+
+        calls : int = 0;
+
+        fibo(i: unsigned int) : unsigned int {
+            if(i<2) return 1;
+            return fibo(i-1) + fibo(i-2);
+        }
+
+        count() : int {
+            calls += 1;
+            return calls;
+        }
+        )SRC");
+    // Tier 0 is not optimized, whatever the compiler optimization level.
+    REQUIRE( comp->get_optimization_level() == k::optimization_level::O2 );
+
+    k::jit_options options;
+    options.tiered = true;
+    options.tier_up_threshold = 10;
+    auto jit = comp->to_jit(options);
+    REQUIRE(jit);
+    REQUIRE(jit->is_tiered());
+
+    auto fibo = jit->get_function<unsigned int(unsigned int)>("fibo");
+    REQUIRE( fibo );
+    auto count = jit->get_function<int()>("count");
+    REQUIRE( count );
+
+    // Not hot yet. Recursive calls go through the stub, so they count: fibo(4) enters fibo 9 times,
+    // as tier 0 is not optimized (no inlining nor recursion elimination).
+    REQUIRE( fibo(4) == 5 );
+    REQUIRE( count() == 1 );
+    jit->wait_tier_up();
+    REQUIRE( jit->get_tiered_up_count() == 0 );
+
+    // The 10th entry requests the re-optimization.
+    REQUIRE( fibo(1) == 1 );
+    jit->wait_tier_up();
+    REQUIRE( jit->get_tiered_up_count() == 1 );
+
+    for (int n = 2; n <= 20; ++n) {
+        REQUIRE( count() == n );
+    }
+    jit->wait_tier_up();
+    REQUIRE( jit->get_tiered_up_count() == 2 );
+
+    // Optimized functions give the same results and share global variables.
+    REQUIRE( fibo(20) == 10946 );
+    REQUIRE( count() == 21 );
+    REQUIRE( *jit->lookup_symbol<int*>("calls") == 21 );
+}
+
+TEST_CASE("Reload JIT functions", "[gen][jit][reload]") {
+    auto comp = k::compiler::create();
+    comp->parse_source(R"SRC(
+        module test;
+
+        total : int = 0;
+
+        step() : int {
+            return 1;
+        }
+
+        add() : int {
+            total += step();
+            return total;
+        }
+        )SRC");
+
+    // Optimized, but step() must not be inlined nor constant-propagated into add(), to be reloadable.
+    REQUIRE( comp->get_optimization_level() == k::optimization_level::O2 );
+
+    k::jit_options options;
+    options.reloadable = true;
+    auto jit = comp->to_jit(options);
+    REQUIRE(jit);
+    REQUIRE(jit->is_reloadable());
+
+    auto add = jit->get_function<int()>("add");
+    REQUIRE( add );
+    REQUIRE( add() == 1 );
+    REQUIRE( add() == 2 );
+
+    // New step, called through its stub by the unchanged add function.
+    REQUIRE( jit->reload_function(R"SRC(
+        module test;
+
+        total : int = 0;
+
+        step() : int {
+            return 10;
+        }
+
+        add() : int {
+            total += step();
+            return total;
+        }
+        )SRC", "step") );
+    REQUIRE( add() == 12 );
+
+    // New add, keeping the global variable state. The same handle calls the new code.
+    REQUIRE( jit->reload_function(R"SRC(
+        module test;
+
+        total : int = 0;
+
+        step() : int {
+            return 10;
+        }
+
+        add() : int {
+            total += step() * 2;
+            return total;
+        }
+        )SRC", "add") );
+    REQUIRE( add() == 32 );
+    REQUIRE( *jit->lookup_symbol<int*>("total") == 32 );
+
+    // Unknown functions cannot be reloaded.
+    REQUIRE_FALSE( jit->reload_function(R"SRC(
+        module test;
+
+        other() : int {
+            return 0;
+        }
+        )SRC", "other") );
+}
+
+TEST_CASE("JIT libraries", "[gen][jit][libraries]") {
+    auto common = k::compiler::create();
+    common->parse_source(R"SRC(
+        module lib;
+
+        base : int = 100;
+
+        twice(i: int) : int {
+            return i * 2;
+        }
+        )SRC");
+    auto jit = common->to_jit();
+    REQUIRE(jit);
+
+    // Tenants use the common code of the main library and define the same symbols in their own libraries.
+    auto create_tenant = [](int offset) {
+        auto comp = k::compiler::create();
+        comp->parse_source(std::string(R"SRC(
+        module lib;
+
+        twice(i: int) : int;
+
+        tenant() : int {
+            return twice(100) + )SRC") + std::to_string(offset) + R"SRC(;
+        }
+        )SRC");
+        return comp;
+    };
+    auto tenant1 = create_tenant(1);
+    auto tenant2 = create_tenant(2);
+
+    REQUIRE( jit->create_library("tenant1", {"main"}) );
+    REQUIRE( jit->create_library("tenant2", {"main"}) );
+    REQUIRE_FALSE( jit->create_library("tenant1") );
+    REQUIRE_FALSE( jit->create_library("tenant3", {"unknown"}) );
+    REQUIRE_FALSE( jit->add_compiler(tenant1, "unknown") );
+
+    auto handle1 = jit->add_compiler(tenant1, "tenant1");
+    REQUIRE( handle1 );
+    REQUIRE( jit->add_compiler(tenant2, "tenant2") );
+
+    auto t1 = jit->get_function<int()>("tenant", "tenant1");
+    auto t2 = jit->get_function<int()>("tenant", "tenant2");
+    REQUIRE( t1 );
+    REQUIRE( t2 );
+    REQUIRE( t1.get() != t2.get() );
+    REQUIRE( t1() == 201 );
+    REQUIRE( t2() == 202 );
+
+    // Common code is shared, the main library does not see tenant symbols.
+    REQUIRE( jit->lookup_symbol<int*>("base", "tenant1") == jit->lookup_symbol<int*>("base") );
+    REQUIRE( jit->lookup_symbol<int(*)()>("tenant") == nullptr );
+
+    SECTION("Tenants with distinct module names") {
+        // K names are resolved in the modules of the requested library, whatever the order modules are added in.
+        auto create_named_tenant = [](const std::string& module, int value) {
+            auto comp = k::compiler::create();
+            comp->parse_source("module " + module + "; tenant() : int { return " + std::to_string(value) + "; }");
+            return comp;
+        };
+        REQUIRE( jit->create_library("tenant_a", {"main"}) );
+        REQUIRE( jit->create_library("tenant_b", {"main"}) );
+        REQUIRE( jit->add_compiler(create_named_tenant("tenant_a", 10), "tenant_a") );
+        REQUIRE( jit->add_compiler(create_named_tenant("tenant_b", 20), "tenant_b") );
+
+        auto ta = jit->get_function<int()>("tenant", "tenant_a");
+        auto tb = jit->get_function<int()>("tenant", "tenant_b");
+        REQUIRE( ta );
+        REQUIRE( tb );
+        REQUIRE( ta() == 10 );
+        REQUIRE( tb() == 20 );
+        auto addrs = jit->lookup_symbols({"tenant", "base"}, "tenant_b");
+        REQUIRE( addrs[0].toPtr<int(*)()>() == tb.get() );
+        // Elements of dependencies are found too.
+        REQUIRE( addrs[1].toPtr<int*>() == jit->lookup_symbol<int*>("base") );
+    }
+
+    SECTION("Remove a tenant module") {
+        std::string tenant_name = tenant1->get_element_mangled_name("tenant");
+        REQUIRE( jit->remove_module(handle1) );
+        REQUIRE( jit->lookup_symbol<int(*)()>(tenant_name, "tenant1") == nullptr );
+
+        // Other tenants are unaffected.
+        REQUIRE( jit->get_function<int()>("tenant", "tenant2")() == 202 );
+    }
+}
+
+TEST_CASE("JIT memory", "[gen][jit][memory]") {
+    auto common = k::compiler::create();
+    common->parse_source(R"SRC(
+        module lib;
+
+        base : int = 100;
+
+        twice(i: int) : int {
+            return i * 2;
+        }
+        )SRC");
+
+    k::jit_options options;
+    SECTION("JITLink") {
+    }
+    SECTION("JITLink with slab allocator") {
+        options.memory_slab_size = 1024 * 1024;
+    }
+    SECTION("RuntimeDyld") {
+        options.debugger = true;
+    }
+
+    auto jit = common->to_jit(options);
+    REQUIRE(jit);
+    REQUIRE( jit->get_memory_limit() == 0 );
+    REQUIRE( jit->get_function<int(int)>("twice")(21) == 42 );
+
+    auto usage = jit->get_memory_usage();
+    REQUIRE( usage.code > 0 );
+    REQUIRE( usage.data > 0 );
+    REQUIRE( usage.total() == usage.code + usage.rodata + usage.data );
+
+    // Memory of removed modules is given back.
+    auto tenant = k::compiler::create();
+    tenant->parse_source(R"SRC(
+        module lib;
+
+        twice(i: int) : int;
+
+        tenant() : int {
+            return twice(100) + 1;
+        }
+        )SRC");
+    REQUIRE( jit->create_library("tenant", {"main"}) );
+    auto handle = jit->add_compiler(tenant, "tenant");
+    REQUIRE( handle );
+    REQUIRE( jit->get_function<int()>("tenant", "tenant")() == 201 );
+    REQUIRE( jit->get_memory_usage().code > usage.code );
+
+    REQUIRE( jit->remove_module(handle) );
+    REQUIRE( jit->get_memory_usage().total() == usage.total() );
+}
+
+TEST_CASE("JIT memory limit", "[gen][jit][memory]") {
+    auto comp = k::compiler::create();
+    comp->parse_source(R"SRC(
+        module test;
+
+        fibo(i: unsigned int) : unsigned int {
+            if(i<2) return 1;
+            return fibo(i-1) + fibo(i-2);
+        }
+        )SRC");
+
+    k::jit_options options;
+    options.memory_limit = 16;
+    auto jit = comp->to_jit(options, false);
+    REQUIRE(jit);
+    REQUIRE( jit->get_memory_limit() == 16 );
+
+    // Linking fails cleanly, nothing is accounted.
+    REQUIRE( jit->lookup_symbol < unsigned int(*)(unsigned int) > ("fibo") == nullptr );
+    REQUIRE( jit->get_memory_usage().total() == 0 );
+}
+
+TEST_CASE("Precompiled module", "[gen][jit][precompiled]") {
+    auto comp = k::compiler::create();
+    comp->parse_source(R"SRC(
+        module the::test;
+
+        struct plop {
+            a : int = 5;
+            b : int = 12;
+            c : int;
+            sum() : int {
+                return a + b + c;
+            }
+        }
+
+        g : plop;
+
+        test_global() : int {
+            return g.sum();
+        }
+
+        twice(i: int) : int {
+            return i * 2;
+        }
+
+        h : int = twice(4);
+
+        test_h() : int {
+            return h;
+        }
+        )SRC");
+    std::string twice_name = comp->get_element_mangled_name("twice");
+
+    temporary_file file("klang-test-precompiled", "kpm");
+    auto path = file.str();
+    REQUIRE( comp->gen_precompiled_module(path) );
+
+    SECTION("Metadata") {
+        auto module = k::model::gen::precompiled_module::load(path);
+        REQUIRE( module );
+        REQUIRE( module->get_module_name() == "::the::test" );
+        REQUIRE_FALSE( module->get_target_triple().empty() );
+        REQUIRE( module->get_object().getBufferSize() > 0 );
+        REQUIRE( module->get_initializers().size() == 1 );
+
+        auto twice = module->find_symbol("twice");
+        REQUIRE( twice != nullptr );
+        REQUIRE( twice->kind == k::model::gen::precompiled_module::FUNCTION );
+        REQUIRE( twice->name == "::the::test::twice" );
+        REQUIRE( twice->mangled_name == twice_name );
+        REQUIRE( twice->type == "(int) : int" );
+        REQUIRE( module->find_symbol("the::test::twice") == twice );
+        REQUIRE( module->find_symbol("::the::test::twice") == twice );
+        REQUIRE( module->find_symbol("plop::sum") != nullptr );
+        REQUIRE( module->find_symbol("unknown") == nullptr );
+
+        auto g = module->find_symbol("g");
+        REQUIRE( g != nullptr );
+        REQUIRE( g->kind == k::model::gen::precompiled_module::VARIABLE );
+        REQUIRE( g->mangled_name == "_KN3the4test1gE" );
+
+        REQUIRE( module->get_structures().size() == 1 );
+        REQUIRE( module->get_structures()[0].name == "::the::test::plop" );
+        REQUIRE( module->get_structures()[0].fields.size() == 3 );
+        REQUIRE( module->get_structures()[0].fields[0].name == "a" );
+        REQUIRE( module->get_structures()[0].fields[0].type == "int" );
+    }
+
+    SECTION("Load into JIT") {
+        auto jit = k::compiler::load_precompiled_module(path);
+        REQUIRE( jit );
+        REQUIRE( jit->get_function<int(int)>("twice")(21) == 42 );
+        // Global initializers are run.
+        REQUIRE( jit->get_function<int()>("test_global")() == 17 );
+        REQUIRE( jit->get_function<int()>("test_h")() == 8 );
+    }
+
+    SECTION("Load into a JIT library") {
+        auto other = k::compiler::create();
+        other->parse_source(R"SRC(
+            module other;
+            thrice(i: int) : int {
+                return i * 3;
+            }
+            )SRC");
+        auto jit = other->to_jit();
+        REQUIRE( jit );
+        REQUIRE( jit->create_library("precompiled") );
+        auto handle = jit->add_precompiled_module(k::model::gen::precompiled_module::load(path), "precompiled");
+        REQUIRE( handle );
+        REQUIRE( jit->get_function<int()>("test_global", "precompiled")() == 17 );
+        REQUIRE( jit->get_function<int()>("test_h", "precompiled")() == 8 );
+        REQUIRE( jit->get_function<int(int)>("thrice")(3) == 9 );
+        REQUIRE( jit->remove_module(handle) );
+        REQUIRE( jit->lookup_symbol<int(*)(int)>(twice_name, "precompiled") == nullptr );
+    }
+
+    SECTION("Invalid files") {
+        REQUIRE( k::model::gen::precompiled_module::load(path + ".missing") == nullptr );
+        temporary_file invalid("klang-test-precompiled-invalid", "kpm");
+        std::ofstream(invalid.str()) << "not a precompiled module";
+        REQUIRE( k::model::gen::precompiled_module::load(invalid.str()) == nullptr );
+        REQUIRE( k::compiler::load_precompiled_module(invalid.str()) == nullptr );
+    }
+}
+
+TEST_CASE("JIT perf map", "[gen][jit][perf]") {
+    REQUIRE( k::model::gen::jit_perf_map::get_label("_KFN4test4fiboEj") == "test::fibo(unsigned int)" );
+    REQUIRE( k::model::gen::jit_perf_map::get_label("_KFN4test4fiboEj$tier1") == "test::fibo(unsigned int) [tier1]" );
+    REQUIRE( k::model::gen::jit_perf_map::get_label("__klang_tier_up") == "__klang_tier_up" );
+
+    auto src = R"SRC(
+        module test;
+
+        fibo(i: unsigned int) : unsigned int {
+            if(i<2) return 1;
+            return fibo(i-1) + fibo(i-2);
+        }
+        )SRC";
+
+    // The map is opened once per process: it is removed at the end of the test, not between linkers.
+    struct perf_map_remover {
+        ~perf_map_remover() {
+            llvm::sys::fs::remove(k::model::gen::jit_perf_map::get_path());
+        }
+    } remover;
+
+    // JITLink (or the default linker), then RuntimeDyld with debugger registration.
+    for (bool debugger : {false, true}) {
+        auto comp = k::compiler::create();
+        comp->parse_source(src);
+
+        k::jit_options options;
+        options.perf_map = true;
+        options.debugger = debugger;
+        auto jit = comp->to_jit(options);
+        REQUIRE(jit);
+
+        auto fibo = jit->lookup_symbol < unsigned int(*)(unsigned int) > ("fibo");
+        REQUIRE( fibo != nullptr );
+        REQUIRE( fibo(10) == 89 );
+
+        std::ifstream map(k::model::gen::jit_perf_map::get_path());
+        REQUIRE( map.is_open() );
+        bool found = false;
+        for (std::string line; std::getline(map, line); ) {
+            if (line.ends_with(" test::fibo(unsigned int)")) {
+                std::istringstream fields(line);
+                uint64_t address = 0, size = 0;
+                fields >> std::hex >> address >> size;
+                found = found || (address == reinterpret_cast<uint64_t>(fibo) && size > 0);
+            }
+        }
+        REQUIRE( found );
+    }
+}
@@ -143,6 +143,44 @@ TEST_CASE( "Parse int[4][] type spec", "[parser][type]") {
     REQUIRE( subtype->keyword.type == k::lex::keyword::INT );
 }
 
+TEST_CASE( "Parse unsigned long long type spec", "[parser][type]") {
+    k::log::logger log;
+    k::parse::parser parser(log, "unsigned long long*");
+    auto spec = parser.parse_type_spec();
+    REQUIRE( spec );
+
+    auto ptr_spec = std::dynamic_pointer_cast<ast::pointer_type_specifier>(spec);
+    REQUIRE( ptr_spec );
+
+    auto subtype = std::dynamic_pointer_cast<ast::keyword_type_specifier>(ptr_spec->subtype);
+    REQUIRE( subtype );
+    REQUIRE( subtype->keyword.type == k::lex::keyword::LONG );
+    REQUIRE( subtype->is_unsigned );
+    REQUIRE( subtype->is_long_long );
+}
+
+TEST_CASE( "Parse float[[4]]& type spec", "[parser][type][vector]") {
+    k::log::logger log;
+    k::parse::parser parser(log, "float[[4]]&");
+    auto spec = parser.parse_type_spec();
+    REQUIRE( spec );
+
+    auto ref_spec = std::dynamic_pointer_cast<ast::pointer_type_specifier>(spec);
+    REQUIRE( ref_spec );
+    REQUIRE( ref_spec->pointer_type.type == k::lex::operator_::AMPERSAND );
+
+    auto vec_spec = std::dynamic_pointer_cast<ast::vector_type_specifier>(ref_spec->subtype);
+    REQUIRE( vec_spec );
+    REQUIRE( vec_spec->lex_int.int_content() == "4" );
+
+    auto subtype = std::dynamic_pointer_cast<ast::keyword_type_specifier>(vec_spec->subtype);
+    REQUIRE( subtype );
+    REQUIRE( subtype->keyword.type == k::lex::keyword::FLOAT );
+
+    k::parse::parser bad_parser(log, "int[[4]");
+    REQUIRE_THROWS( bad_parser.parse_type_spec() );
+}
+
 
 //
 // Parse Primary expressions
@@ -1098,3 +1136,59 @@ TEST_CASE( "Parse for statement", "[parser][for]") {
     REQUIRE( block->statements.size() == 1 );
 
 }
+
+TEST_CASE( "Parse loop attributes", "[parser][for][attributes]") {
+    k::log::logger log;
+    k::parse::parser parser(log, "[[unroll(4), no_alias]] [[vectorize]] for(i : int = 0; i < m; i += 1 ) { res += i; }");
+    auto stmt = std::dynamic_pointer_cast<ast::for_statement>(parser.parse_statement());
+    REQUIRE( stmt );
+
+    REQUIRE( stmt->attributes.size() == 3 );
+    REQUIRE( stmt->attributes[0].name.content == "unroll" );
+    REQUIRE( stmt->attributes[0].args.size() == 1 );
+    REQUIRE( std::holds_alternative<k::lex::integer>(stmt->attributes[0].args[0]) );
+    REQUIRE( stmt->attributes[1].name.content == "no_alias" );
+    REQUIRE( stmt->attributes[1].args.empty() );
+    REQUIRE( stmt->attributes[2].name.content == "vectorize" );
+    REQUIRE( stmt->attributes[2].args.empty() );
+
+    k::parse::parser other(log, "[[unroll]] res += 2;");
+    REQUIRE_THROWS_AS( other.parse_statement(), k::parse::parsing_error );
+}
+
+TEST_CASE( "Parse structure layout attributes", "[parser][struct][attributes]") {
+    k::log::logger log;
+    k::parse::parser parser(log, "[[packed, align(8)]] struct plop { a : char; [[align(4)]] b : int; }");
+    auto decl = std::dynamic_pointer_cast<ast::struct_decl>(parser.parse_declaration());
+    REQUIRE( decl );
+
+    REQUIRE( decl->attributes.size() == 2 );
+    REQUIRE( decl->attributes[0].name.content == "packed" );
+    REQUIRE( decl->attributes[0].args.empty() );
+    REQUIRE( decl->attributes[1].name.content == "align" );
+    REQUIRE( decl->attributes[1].args.size() == 1 );
+
+    REQUIRE( decl->declarations.size() == 2 );
+    auto a = std::dynamic_pointer_cast<ast::variable_decl>(decl->declarations[0]);
+    REQUIRE( a );
+    REQUIRE( a->attributes.empty() );
+    auto b = std::dynamic_pointer_cast<ast::variable_decl>(decl->declarations[1]);
+    REQUIRE( b );
+    REQUIRE( b->attributes.size() == 1 );
+    REQUIRE( b->attributes[0].name.content == "align" );
+
+    k::parse::parser other(log, "[[packed]] namespace plop { }");
+    REQUIRE_THROWS_AS( other.parse_declaration(), k::parse::parsing_error );
+}
+
+TEST_CASE( "Parse function attributes", "[parser][function][attributes]") {
+    k::log::logger log;
+    k::parse::parser parser(log, "[[fast_math(\"reassoc\", \"contract\")]] dot(a : double, b : double) : double { return a * b; }");
+    auto decl = std::dynamic_pointer_cast<ast::function_decl>(parser.parse_declaration());
+    REQUIRE( decl );
+
+    REQUIRE( decl->attributes.size() == 1 );
+    REQUIRE( decl->attributes[0].name.content == "fast_math" );
+    REQUIRE( decl->attributes[0].args.size() == 2 );
+    REQUIRE( std::get<std::string>(decl->attributes[0].args[0].get<k::lex::string>().value()) == "reassoc" );
+}
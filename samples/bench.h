@@ -0,0 +1,47 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+//
+// Timing harness shared by the K versus C benchmarks of the samples.
+//
+
+#ifndef KLANG_SAMPLES_BENCH_H
+#define KLANG_SAMPLES_BENCH_H
+
+#include <time.h>
+
+// Monotonic time, in seconds.
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Run a statement a number of times and keep the best duration, in milliseconds.
+#define BENCH_BEST(best, runs, statement) do { \
+        (best) = -1; \
+        for (int bench_run = 0; bench_run < (runs); ++bench_run) { \
+            double bench_start = bench_now(); \
+            statement; \
+            double bench_duration = (bench_now() - bench_start) * 1000; \
+            if ((best) < 0 || bench_duration < (best)) { \
+                (best) = bench_duration; \
+            } \
+        } \
+    } while (0)
+
+#endif // KLANG_SAMPLES_BENCH_H
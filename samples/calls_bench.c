@@ -0,0 +1,65 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+//
+// Benchmark of call-heavy recursive code (calls_bench.k) against the same code written in C.
+//
+// Build and run, with the same optimization level on both sides:
+//   klangc -O2 calls_bench.k -o calls_bench_k.o
+//   cc -O2 calls_bench.c calls_bench_k.o -o calls_bench
+//   ./calls_bench 30
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+// Entry point implemented in K (bench_calls::run)
+unsigned int k_run(unsigned int) __asm__("_KFN11bench_calls3runEj");
+
+// Same code implemented in C
+static unsigned int c_fibo(unsigned int i) {
+    if(i<2) return 1;
+    return c_fibo(i-1) + c_fibo(i-2);
+}
+
+static unsigned int c_ackermann(unsigned int m, unsigned int n) {
+    if(m==0) return n+1;
+    if(n==0) return c_ackermann(m-1, 1);
+    return c_ackermann(m-1, c_ackermann(m, n-1));
+}
+
+__attribute__((noinline))
+unsigned int c_run(unsigned int n) {
+    return c_fibo(n) + c_ackermann(2, n);
+}
+
+static void bench(const char* name, unsigned int (*run)(unsigned int), unsigned int param, int runs) {
+    double best;
+    unsigned int res = 0;
+    BENCH_BEST(best, runs, res = run(param));
+    printf("%s: run(%u) = %u, best of %d runs: %.3f ms\n", name, param, res, runs, best);
+}
+
+int main(int argc, char** argv) {
+    unsigned int param = argc > 1 ? (unsigned int)atoi(argv[1]) : 30;
+    int runs = argc > 2 ? atoi(argv[2]) : 5;
+    bench("C", c_run, param, runs);
+    bench("K", k_run, param, runs);
+    return 0;
+}
@@ -0,0 +1,56 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+//
+// Benchmark of the fibo.k workload against the same algorithm written in C.
+//
+// Build and run, with the same optimization level on both sides:
+//   klangc -O3 fibo_bench.k -o fibo_bench_k.o
+//   cc -O3 fibo_bench.c fibo_bench_k.o -o fibo_bench
+//   ./fibo_bench 35
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+// Fibonacci method implemented in K (bench::fibo)
+unsigned int k_fibo(unsigned short) __asm__("_KFN5bench4fiboEt");
+
+// Same method implemented in C
+__attribute__((noinline))
+unsigned int c_fibo(unsigned short i) {
+    if(i==0) return 1;
+    else if(i==1) return 1;
+    return c_fibo(i-1) + c_fibo(i-2);
+}
+
+static void bench(const char* name, unsigned int (*fibo)(unsigned short), unsigned short param, int runs) {
+    double best;
+    unsigned int res = 0;
+    BENCH_BEST(best, runs, res = fibo(param));
+    printf("%s: fibo(%hu) = %u, best of %d runs: %.3f ms\n", name, param, res, runs, best);
+}
+
+int main(int argc, char** argv) {
+    unsigned short param = argc > 1 ? (unsigned short)atoi(argv[1]) : 32;
+    int runs = argc > 2 ? atoi(argv[2]) : 5;
+    bench("C", c_fibo, param, runs);
+    bench("K", k_fibo, param, runs);
+    return 0;
+}
@@ -0,0 +1,75 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+//
+// Benchmark of floating point reductions (fp_bench.k) against the same loop written in C.
+// The strict K dot product is comparable to the C one built without -ffast-math,
+// the relaxed one is vectorized and uses fused multiply-adds when the target supports them.
+//
+// Build and run, with the same optimization level on both sides:
+//   klangc -O3 --march=native fp_bench.k -o fp_bench_k.o
+//   cc -O3 -march=native fp_bench.c fp_bench_k.o -o fp_bench
+//   ./fp_bench 100000
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+// Entry points implemented in K (bench_fp::init, bench_fp::dot and bench_fp::fast_dot)
+void k_init(void) __asm__("_KFN8bench_fp4initEv");
+double k_dot(void) __asm__("_KFN8bench_fp3dotEv");
+double k_fast_dot(void) __asm__("_KFN8bench_fp8fast_dotEv");
+
+// Same code implemented in C
+static double c_xs[4096];
+static double c_ys[4096];
+
+static void c_init(void) {
+    for(int i = 0; i < 4096; ++i) {
+        c_xs[i] = i % 7;
+        c_ys[i] = (i % 5) * 0.5;
+    }
+}
+
+__attribute__((noinline))
+double c_dot(void) {
+    double res = 0.0;
+    for(int i = 0; i < 4096; ++i) {
+        res += c_xs[i] * c_ys[i];
+    }
+    return res;
+}
+
+static void bench(const char* name, double (*dot)(void), int iterations, int runs) {
+    double best;
+    double res = 0;
+    BENCH_BEST(best, runs, for (int i = 0; i < iterations; ++i) { res = dot(); });
+    printf("%s: dot() = %f, best of %d runs of %d iterations: %.3f ms\n", name, res, runs, iterations, best);
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 100000;
+    int runs = argc > 2 ? atoi(argv[2]) : 5;
+    c_init();
+    k_init();
+    bench("C", c_dot, iterations, runs);
+    bench("K (strict)", k_dot, iterations, runs);
+    bench("K (fast math)", k_fast_dot, iterations, runs);
+    return 0;
+}
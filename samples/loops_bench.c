@@ -0,0 +1,72 @@
+/*
+ * K Language compiler
+ *
+ * Copyright 2026 Emilien Kia
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+//
+// Benchmark of array loops (loops_bench.k) against the same loop written in C.
+// K loops are vectorized as requested by their hints, the scalar one shows the vectorization gain.
+//
+// Build and run, with the same optimization level on both sides:
+//   klangc -O3 loops_bench.k -o loops_bench_k.o
+//   cc -O3 loops_bench.c loops_bench_k.o -o loops_bench
+//   ./loops_bench 100000
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+// Entry points implemented in K (bench_loops::init, bench_loops::sum and bench_loops::sum_scalar)
+void k_init(void) __asm__("_KFN11bench_loops4initEv");
+int k_sum(void) __asm__("_KFN11bench_loops3sumEv");
+int k_sum_scalar(void) __asm__("_KFN11bench_loops10sum_scalarEv");
+
+// Same code implemented in C
+static int c_data[4096];
+
+static void c_init(void) {
+    for(int i = 0; i < 4096; ++i) {
+        c_data[i] = i % 7;
+    }
+}
+
+__attribute__((noinline))
+int c_sum(void) {
+    int res = 0;
+    for(int i = 0; i < 4096; ++i) {
+        res += c_data[i];
+    }
+    return res;
+}
+
+static void bench(const char* name, int (*sum)(void), int iterations, int runs) {
+    double best;
+    int res = 0;
+    BENCH_BEST(best, runs, for (int i = 0; i < iterations; ++i) { res = sum(); });
+    printf("%s: sum() = %d, best of %d runs of %d iterations: %.3f ms\n", name, res, runs, iterations, best);
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 100000;
+    int runs = argc > 2 ? atoi(argv[2]) : 5;
+    c_init();
+    k_init();
+    bench("C", c_sum, iterations, runs);
+    bench("K (vectorized)", k_sum, iterations, runs);
+    bench("K (scalar)", k_sum_scalar, iterations, runs);
+    return 0;
+}